@@ -0,0 +1,97 @@
+// RBotFirmware host build
+// Motion core throughput for the axis count it is built for (bench_motion_core is built like
+// the firmware and bench_motion_core_2axes for 2 axes) - step ISR ticks per second while a
+// two-axis move runs and blocks planned per second along a dense curve
+// Usage: bench_motion_core [virtualSecs] [numBlocks]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "HostHal.h"
+#include "RdJson.h"
+#include "RobotConfigurations.h"
+#include "RobotMotion/RobotController.h"
+#include "RobotMotion/MotionControl/MotionPlanner.h"
+
+static const char* BENCH_AXES_CONFIG =
+    "{\"axis0\":{\"maxSpeed\":100,\"maxAcc\":100,\"stepsPerRot\":3200,\"unitsPerRot\":40},"
+    "\"axis1\":{\"maxSpeed\":100,\"maxAcc\":100,\"stepsPerRot\":3200,\"unitsPerRot\":40}}";
+
+// End-stop pins of the built-in robots (active low)
+static const int AXIS0_ENDSTOP_PIN = 22;
+static const int AXIS1_ENDSTOP_PIN = 23;
+
+// Step ISR ticks per second of host time - the ISR runs from the virtual timer as the robot is
+// serviced every 1ms of virtual time (which also compiles the steps the ISR outputs)
+static double isrTicksPerSec(int virtualSecs)
+{
+    HostHal::reset();
+    HostHal::setInput(AXIS0_ENDSTOP_PIN, true);
+    HostHal::setInput(AXIS1_ENDSTOP_PIN, true);
+    RobotController robotController;
+    robotController.init(RdJson::getString("/robotConfig", "{}", RobotConfigurations::getConfig("TranquilSmall")).c_str());
+    RobotCommandArgs args;
+    args.setAxisSteps(0, 1000000, true);
+    args.setAxisSteps(1, 500000, true);
+    args.setMoveType(RobotMoveTypeArg_Relative);
+    robotController.moveTo(args);
+
+    const uint32_t SERVICE_US = 1000;
+    uint64_t numServices = uint64_t(virtualSecs) * 1000000 / SERVICE_US;
+    auto startTime = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < numServices; i++)
+    {
+        HostHal::advanceUs(SERVICE_US);
+        robotController.service();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return numServices * SERVICE_US * 1000.0 / MotionBlock::TICK_INTERVAL_NS / secs;
+}
+
+// Blocks planned per second along a dense curve of 1mm blocks with the oldest block removed (as
+// if executed) whenever the pipeline is full
+static double blocksPerSec(int numBlocks)
+{
+    AxesParams axesParams;
+    String axisJSON;
+    for (int axisIdx = 0; axisIdx < 2; axisIdx++)
+        axesParams.configureAxis(BENCH_AXES_CONFIG, axisIdx, axisJSON);
+    MotionPipeline motionPipeline;
+    motionPipeline.init(100);
+    MotionPlanner motionPlanner;
+    motionPlanner.configure(0.05f, 0.05f, false, 0);
+    AxisPosition curAxisPositions;
+    curAxisPositions._axisPositionMM._pt[0] = 100;
+    curAxisPositions._stepsFromHome.setVal(0, lroundf(100 * axesParams.getStepsPerUnit(0)));
+
+    int numPlanned = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    for (int blockIdx = 1; blockIdx <= numBlocks; blockIdx++)
+    {
+        if (!motionPipeline.canAccept())
+            motionPipeline.remove();
+        float x = 100 * cosf(blockIdx * 0.01f);
+        float y = 100 * sinf(blockIdx * 0.01f);
+        RobotCommandArgs args;
+        args.setAxisValMM(0, x, true);
+        args.setAxisValMM(1, y, true);
+        args.setMoreMovesComing(true);
+        AxisFloats actuatorCoords(x * axesParams.getStepsPerUnit(0), y * axesParams.getStepsPerUnit(1));
+        if (motionPlanner.moveTo(args, actuatorCoords, curAxisPositions, axesParams, motionPipeline))
+            numPlanned++;
+        curAxisPositions._axisPositionMM = args.getPointMM();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return numPlanned / secs;
+}
+
+int main(int argc, char* argv[])
+{
+    int virtualSecs = (argc > 1) ? atoi(argv[1]) : 60;
+    int numBlocks = (argc > 2) ? atoi(argv[2]) : 50000;
+    printf("Motion core built for %d axes\n", RobotConsts::MAX_AXES);
+    printf("ISR ticks/s     %.0f (%ds of a two-axis move)\n", isrTicksPerSec(virtualSecs), virtualSecs);
+    printf("blocks/s        %.0f (%d blocks)\n", blocksPerSec(numBlocks), numBlocks);
+    return 0;
+}
@@ -0,0 +1,80 @@
+// RBotFirmware host build
+// Planner throughput - blocks planned per second at several pipeline lengths with the oldest
+// block removed (as if executed) whenever the pipeline is full
+// Usage: bench_planner [numBlocks]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "RobotMotion/MotionControl/MotionPlanner.h"
+
+static const char* BENCH_AXES_CONFIG =
+    "{\"axis0\":{\"maxSpeed\":100,\"maxAcc\":100,\"stepsPerRot\":3200,\"unitsPerRot\":40},"
+    "\"axis1\":{\"maxSpeed\":100,\"maxAcc\":100,\"stepsPerRot\":3200,\"unitsPerRot\":40}}";
+
+// Point on the path - a dense curve of 1mm blocks turning gradually or a straight line of
+// 0.2mm blocks (which keeps accelerating so every add re-plans back through the pipeline)
+static void pathPoint(bool denseCurve, int blockIdx, float& x, float& y)
+{
+    if (denseCurve)
+    {
+        float angle = blockIdx * 0.02f;
+        float radius = 100 + 50 * sinf(blockIdx * 0.001f);
+        x = radius * cosf(angle);
+        y = radius * sinf(angle);
+    }
+    else
+    {
+        x = blockIdx * 0.2f;
+        y = blockIdx * 0.1f;
+    }
+}
+
+static double blocksPerSec(int pipelineLen, bool denseCurve, int numBlocks)
+{
+    AxesParams axesParams;
+    String axisJSON;
+    for (int axisIdx = 0; axisIdx < 2; axisIdx++)
+        axesParams.configureAxis(BENCH_AXES_CONFIG, axisIdx, axisJSON);
+    MotionPipeline motionPipeline;
+    motionPipeline.init(pipelineLen);
+    MotionPlanner motionPlanner;
+    motionPlanner.configure(0.05f, 0.05f, false, 0);
+    AxisPosition curAxisPositions;
+    pathPoint(denseCurve, 0, curAxisPositions._axisPositionMM._pt[0], curAxisPositions._axisPositionMM._pt[1]);
+    for (int axisIdx = 0; axisIdx < 2; axisIdx++)
+        curAxisPositions._stepsFromHome.setVal(axisIdx,
+                    lroundf(curAxisPositions._axisPositionMM._pt[axisIdx] * axesParams.getStepsPerUnit(axisIdx)));
+
+    int numPlanned = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    for (int blockIdx = 1; blockIdx <= numBlocks; blockIdx++)
+    {
+        if (!motionPipeline.canAccept())
+            motionPipeline.remove();
+        float x = 0, y = 0;
+        pathPoint(denseCurve, blockIdx, x, y);
+        RobotCommandArgs args;
+        args.setAxisValMM(0, x, true);
+        args.setAxisValMM(1, y, true);
+        args.setMoreMovesComing(true);
+        AxisFloats actuatorCoords(x * axesParams.getStepsPerUnit(0), y * axesParams.getStepsPerUnit(1));
+        if (motionPlanner.moveTo(args, actuatorCoords, curAxisPositions, axesParams, motionPipeline))
+            numPlanned++;
+        curAxisPositions._axisPositionMM = args.getPointMM();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return numPlanned / secs;
+}
+
+int main(int argc, char* argv[])
+{
+    int numBlocks = (argc > 1) ? atoi(argv[1]) : 20000;
+    printf("Planning %d blocks - blocks/s\n", numBlocks);
+    printf("pipelineLen   dense curve   accelerating straight line\n");
+    for (int pipelineLen : {100, 250, 500})
+        printf("%-13d %-13.0f %.0f\n", pipelineLen, blocksPerSec(pipelineLen, true, numBlocks),
+               blocksPerSec(pipelineLen, false, numBlocks));
+    return 0;
+}
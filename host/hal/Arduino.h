@@ -0,0 +1,64 @@
+// RBotFirmware host build
+// Arduino API for running the motion code on a host - time is virtual and GPIOs are
+// simulated (see HostHal.h)
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include "WString.h"
+
+#define IRAM_ATTR
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x02
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define sq(x) ((x) * (x))
+
+using std::min;
+using std::max;
+
+template <class T>
+T constrain(T val, T low, T high)
+{
+    return val < low ? low : (val > high ? high : val);
+}
+
+// Time
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+uint32_t getCpuFrequencyMhz();
+
+// GPIO
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int level);
+int digitalRead(int pin);
+
+// ESP-IDF types pulled in by the ESP32 Arduino core
+typedef struct esp_timer* esp_timer_handle_t;
+
+// Serial (output is discarded)
+class HardwareSerialHost
+{
+public:
+    void begin(unsigned long) {}
+    size_t print(const char*) { return 0; }
+    size_t println(const char*) { return 0; }
+};
+extern HardwareSerialHost Serial;
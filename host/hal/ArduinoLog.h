@@ -0,0 +1,60 @@
+// RBotFirmware host build
+// Logging goes to stdout when HOST_LOG is set in the environment - errors and warnings are
+// counted so tests can check for them
+
+#pragma once
+
+#include <stdarg.h>
+#include "Arduino.h"
+
+#define LOG_LEVEL_SILENT 0
+#define LOG_LEVEL_FATAL 1
+#define LOG_LEVEL_ERROR 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_NOTICE 4
+#define LOG_LEVEL_TRACE 5
+#define LOG_LEVEL_VERBOSE 6
+#define LOG_LEVEL_INFO LOG_LEVEL_NOTICE
+
+#define LOG_HOST(format)            \
+    do                              \
+    {                               \
+        va_list args;               \
+        va_start(args, format);     \
+        print(format, args);        \
+        va_end(args);               \
+    } while (0)
+
+class Logging
+{
+public:
+    template <class T>
+    void begin(int, T*, bool = true) {}
+    void fatal(const char* format, ...) { _numErrors++; LOG_HOST(format); }
+    void error(const char* format, ...) { _numErrors++; LOG_HOST(format); }
+    void warning(const char* format, ...) { _numWarnings++; LOG_HOST(format); }
+    void notice(const char* format, ...) { LOG_HOST(format); }
+    void info(const char* format, ...) { LOG_HOST(format); }
+    void infoln(const char* format, ...) { LOG_HOST(format); }
+    void trace(const char* format, ...) { LOG_HOST(format); }
+    void verbose(const char* format, ...) { LOG_HOST(format); }
+
+    unsigned _numErrors = 0;
+    unsigned _numWarnings = 0;
+
+private:
+    // ArduinoLog formats - %F is a double, %T a bool and %l a long
+    static void print(const char* format, va_list args)
+    {
+        static const bool enabled = getenv("HOST_LOG") != NULL;
+        if (!enabled)
+            return;
+        String fmtStr(format);
+        fmtStr.replace("%F", "%f");
+        fmtStr.replace("%T", "%d");
+        fmtStr.replace("%l", "%ld");
+        vprintf(fmtStr.c_str(), args);
+    }
+};
+
+extern Logging Log;
@@ -0,0 +1,16 @@
+// RBotFirmware host build
+// UARTs used to configure stepper drivers - nothing is sent
+
+#pragma once
+
+#include "Arduino.h"
+
+#define SERIAL_8N1 0x800001c
+
+class HardwareSerial
+{
+public:
+    HardwareSerial(int) {}
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+    void end() {}
+};
@@ -0,0 +1,180 @@
+// RBotFirmware host build
+// Simulated time and GPIOs
+
+#include "Arduino.h"
+#include "ArduinoLog.h"
+#include "HostHal.h"
+#include "soc/gpio_reg.h"
+#include "xtensa/core-macros.h"
+
+Logging Log;
+HardwareSerialHost Serial;
+
+namespace
+{
+    uint64_t _timeNs = 0;
+    uint64_t _outLevels = 0;
+    uint64_t _inLevels = 0;
+    uint64_t _inDriven = 0;
+    std::vector<HostHal::PinEvent> _pinEvents;
+    std::vector<HostHal::RegWrite> _regWrites;
+    static constexpr uint32_t CPU_FREQ_MHZ = 240;
+
+    bool validPin(int pin)
+    {
+        return (pin >= 0) && (pin < HostHal::NUM_GPIO_PINS);
+    }
+
+    // Set output latches and log the pins which change
+    void setOutputs(uint64_t pinMask, bool level)
+    {
+        uint64_t changed = level ? (pinMask & ~_outLevels) : (pinMask & _outLevels);
+        if (level)
+            _outLevels |= pinMask;
+        else
+            _outLevels &= ~pinMask;
+        for (int pin = 0; pin < HostHal::NUM_GPIO_PINS; pin++)
+            if (changed & (1ULL << pin))
+                _pinEvents.push_back({_timeNs, uint8_t(pin), level});
+    }
+
+    uint64_t pinLevels()
+    {
+        return (_outLevels & ~_inDriven) | (_inLevels & _inDriven);
+    }
+}
+
+namespace HostHal
+{
+    void reset()
+    {
+        _timeNs = 0;
+        _outLevels = 0;
+        _inLevels = 0;
+        _inDriven = 0;
+        clearLogs();
+    }
+
+    uint64_t nowNs()
+    {
+        return _timeNs;
+    }
+
+    void advanceNs(uint64_t ns)
+    {
+        _timeNs += ns;
+    }
+
+    void advanceUs(uint64_t us)
+    {
+        _timeNs += us * 1000;
+    }
+
+    void setInput(int pin, bool level)
+    {
+        if (!validPin(pin))
+            return;
+        _inDriven |= 1ULL << pin;
+        if (level)
+            _inLevels |= 1ULL << pin;
+        else
+            _inLevels &= ~(1ULL << pin);
+    }
+
+    bool getLevel(int pin)
+    {
+        return validPin(pin) && (pinLevels() & (1ULL << pin));
+    }
+
+    const std::vector<PinEvent>& pinEvents()
+    {
+        return _pinEvents;
+    }
+
+    const std::vector<RegWrite>& regWrites()
+    {
+        return _regWrites;
+    }
+
+    void clearLogs()
+    {
+        _pinEvents.clear();
+        _regWrites.clear();
+    }
+
+    uint32_t countRisingEdges(int pin)
+    {
+        uint32_t edges = 0;
+        for (const PinEvent& ev : _pinEvents)
+            if ((ev._pin == pin) && ev._level)
+                edges++;
+        return edges;
+    }
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(_timeNs / 1000000);
+}
+
+unsigned long micros()
+{
+    // 32 bits like the ESP32 so wrap-around is handled the same way
+    return (uint32_t)(_timeNs / 1000);
+}
+
+void delay(uint32_t ms)
+{
+    _timeNs += uint64_t(ms) * 1000000;
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    _timeNs += uint64_t(us) * 1000;
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+    return CPU_FREQ_MHZ;
+}
+
+uint32_t hostCycleCount()
+{
+    return uint32_t(_timeNs * CPU_FREQ_MHZ / 1000);
+}
+
+void pinMode(int pin, int mode)
+{
+}
+
+void digitalWrite(int pin, int level)
+{
+    if (validPin(pin))
+        setOutputs(1ULL << pin, level != 0);
+}
+
+int digitalRead(int pin)
+{
+    return HostHal::getLevel(pin) ? 1 : 0;
+}
+
+void hostRegWrite(uint32_t reg, uint32_t val)
+{
+    _regWrites.push_back({int(reg), val});
+    switch (reg)
+    {
+        case GPIO_OUT_W1TS_REG: setOutputs(val, true); break;
+        case GPIO_OUT_W1TC_REG: setOutputs(val, false); break;
+        case GPIO_OUT1_W1TS_REG: setOutputs(uint64_t(val) << 32, true); break;
+        case GPIO_OUT1_W1TC_REG: setOutputs(uint64_t(val) << 32, false); break;
+    }
+}
+
+uint32_t hostRegRead(uint32_t reg)
+{
+    if (reg == GPIO_IN_REG)
+        return uint32_t(pinLevels());
+    if (reg == GPIO_IN1_REG)
+        return uint32_t(pinLevels() >> 32) & 0xff;
+    return 0;
+}
@@ -0,0 +1,50 @@
+// RBotFirmware host build
+// Control of the simulated hardware - tests advance virtual time and drive end-stop inputs,
+// and read back every change made to the output pins
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace HostHal
+{
+    static constexpr int NUM_GPIO_PINS = 40;
+
+    // Change of level of an output pin
+    struct PinEvent
+    {
+        uint64_t _timeNs;
+        uint8_t _pin;
+        bool _level;
+    };
+
+    // Write to a GPIO register
+    struct RegWrite
+    {
+        int _reg;
+        uint32_t _val;
+    };
+
+    // Reset time, pins and logs
+    void reset();
+
+    // Virtual time - micros() and millis() follow it
+    uint64_t nowNs();
+    void advanceNs(uint64_t ns);
+    void advanceUs(uint64_t us);
+
+    // Input levels (e.g. end-stops) - an input pin reads as its output latch until set here
+    void setInput(int pin, bool level);
+
+    // Current level of a pin
+    bool getLevel(int pin);
+
+    // Output pin changes and register writes since the last clear
+    const std::vector<PinEvent>& pinEvents();
+    const std::vector<RegWrite>& regWrites();
+    void clearLogs();
+
+    // Rising edges of a pin in the log
+    uint32_t countRisingEdges(int pin);
+}
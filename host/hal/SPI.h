@@ -0,0 +1,5 @@
+// RBotFirmware host build
+
+#pragma once
+
+#include "Arduino.h"
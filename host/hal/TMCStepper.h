@@ -0,0 +1,27 @@
+// RBotFirmware host build
+// Trinamic drivers - register writes are discarded
+
+#pragma once
+
+#include "HardwareSerial.h"
+
+class TMC2208Stepper
+{
+public:
+    TMC2208Stepper(HardwareSerial*, float) {}
+    TMC2208Stepper(HardwareSerial*, float, uint8_t) {}
+    void begin() {}
+    void reset() {}
+    void toff(uint8_t) {}
+    void rms_current(uint16_t) {}
+    void microsteps(uint16_t) {}
+    void intpol(bool) {}
+    void pwm_autoscale(bool) {}
+    void en_spreadCycle(bool) {}
+};
+
+class TMC2209Stepper : public TMC2208Stepper
+{
+public:
+    TMC2209Stepper(HardwareSerial* pSerial, float rSense, uint8_t addr) : TMC2208Stepper(pSerial, rSense, addr) {}
+};
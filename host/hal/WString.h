@@ -0,0 +1,166 @@
+// RBotFirmware host build
+// Arduino String for the host build - only the parts used by the motion code
+
+#pragma once
+
+#include <string>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#define DEC 10
+#define HEX 16
+
+class String
+{
+private:
+    std::string _str;
+
+public:
+    String() {}
+    String(const char* pStr)
+    {
+        if (pStr)
+            _str = pStr;
+    }
+    String(const std::string& str) : _str(str) {}
+    String(char ch) : _str(1, ch) {}
+    String(int val, unsigned char base = DEC) : _str(toBase(long(val), base)) {}
+    String(unsigned int val, unsigned char base = DEC) : _str(toBase((unsigned long)val, base)) {}
+    String(long val, unsigned char base = DEC) : _str(toBase(val, base)) {}
+    String(unsigned long val, unsigned char base = DEC) : _str(toBase(val, base)) {}
+    String(long long val) : _str(std::to_string(val)) {}
+    String(unsigned long long val) : _str(std::to_string(val)) {}
+    String(double val, unsigned int decimalPlaces = 2)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, val);
+        _str = buf;
+    }
+    String(float val, unsigned int decimalPlaces = 2) : String(double(val), decimalPlaces) {}
+
+    const char* c_str() const { return _str.c_str(); }
+    unsigned int length() const { return _str.length(); }
+    void reserve(unsigned int size) { _str.reserve(size); }
+
+    bool concat(const String& str) { _str += str._str; return true; }
+    bool concat(const char* pStr) { if (pStr) _str += pStr; return true; }
+    bool concat(char ch) { _str += ch; return true; }
+    bool concat(int val) { _str += std::to_string(val); return true; }
+    bool concat(unsigned int val) { _str += std::to_string(val); return true; }
+    bool concat(long val) { _str += std::to_string(val); return true; }
+    bool concat(unsigned long val) { _str += std::to_string(val); return true; }
+    bool concat(double val) { return concat(String(val)); }
+
+    String& operator+=(const String& str) { concat(str); return *this; }
+    String& operator+=(const char* pStr) { concat(pStr); return *this; }
+    String& operator+=(char ch) { concat(ch); return *this; }
+    String& operator+=(int val) { concat(val); return *this; }
+    String& operator+=(unsigned int val) { concat(val); return *this; }
+    String& operator+=(long val) { concat(val); return *this; }
+    String& operator+=(unsigned long val) { concat(val); return *this; }
+    String& operator+=(double val) { concat(val); return *this; }
+
+    friend String operator+(const String& a, const String& b) { return String(a._str + b._str); }
+    friend String operator+(const String& a, const char* b) { return String(a._str + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b._str); }
+    friend String operator+(const String& a, char b) { return String(a._str + b); }
+
+    bool equals(const String& str) const { return _str == str._str; }
+    bool equals(const char* pStr) const { return _str == (pStr ? pStr : ""); }
+    bool equalsIgnoreCase(const String& str) const { return strcasecmp(_str.c_str(), str._str.c_str()) == 0; }
+    bool operator==(const String& str) const { return _str == str._str; }
+    bool operator==(const char* pStr) const { return equals(pStr); }
+    bool operator!=(const String& str) const { return _str != str._str; }
+    bool operator!=(const char* pStr) const { return !equals(pStr); }
+    bool operator<(const String& str) const { return _str < str._str; }
+    bool startsWith(const String& prefix) const { return _str.compare(0, prefix._str.length(), prefix._str) == 0; }
+    bool endsWith(const String& suffix) const
+    {
+        return (_str.length() >= suffix._str.length()) &&
+               (_str.compare(_str.length() - suffix._str.length(), suffix._str.length(), suffix._str) == 0);
+    }
+
+    char charAt(unsigned int idx) const { return idx < _str.length() ? _str[idx] : 0; }
+    void setCharAt(unsigned int idx, char ch) { if (idx < _str.length()) _str[idx] = ch; }
+    char operator[](unsigned int idx) const { return charAt(idx); }
+    char& operator[](unsigned int idx) { return _str[idx]; }
+
+    int indexOf(char ch, unsigned int fromIdx = 0) const { return toIdx(_str.find(ch, fromIdx)); }
+    int indexOf(const String& str, unsigned int fromIdx = 0) const { return toIdx(_str.find(str._str, fromIdx)); }
+    int lastIndexOf(char ch) const { return toIdx(_str.rfind(ch)); }
+    String substring(unsigned int beginIdx) const
+    {
+        return beginIdx < _str.length() ? String(_str.substr(beginIdx)) : String();
+    }
+    String substring(unsigned int beginIdx, unsigned int endIdx) const
+    {
+        if (beginIdx > endIdx)
+            std::swap(beginIdx, endIdx);
+        if (beginIdx >= _str.length())
+            return String();
+        return String(_str.substr(beginIdx, endIdx - beginIdx));
+    }
+
+    long toInt() const { return atol(_str.c_str()); }
+    float toFloat() const { return float(atof(_str.c_str())); }
+    double toDouble() const { return atof(_str.c_str()); }
+
+    void trim()
+    {
+        size_t startIdx = _str.find_first_not_of(" \t\r\n");
+        if (startIdx == std::string::npos)
+        {
+            _str.clear();
+            return;
+        }
+        size_t endIdx = _str.find_last_not_of(" \t\r\n");
+        _str = _str.substr(startIdx, endIdx - startIdx + 1);
+    }
+    void toUpperCase() { for (char& ch : _str) ch = toupper(ch); }
+    void toLowerCase() { for (char& ch : _str) ch = tolower(ch); }
+    void replace(const String& find, const String& replaceWith)
+    {
+        if (find._str.empty())
+            return;
+        size_t pos = 0;
+        while ((pos = _str.find(find._str, pos)) != std::string::npos)
+        {
+            _str.replace(pos, find._str.length(), replaceWith._str);
+            pos += replaceWith._str.length();
+        }
+    }
+    void replace(char find, char replaceWith) { for (char& ch : _str) if (ch == find) ch = replaceWith; }
+    void remove(unsigned int idx) { if (idx < _str.length()) _str.erase(idx); }
+    void remove(unsigned int idx, unsigned int count) { if (idx < _str.length()) _str.erase(idx, count); }
+    void toCharArray(char* pBuf, unsigned int bufLen) const
+    {
+        if (bufLen == 0)
+            return;
+        strncpy(pBuf, _str.c_str(), bufLen - 1);
+        pBuf[bufLen - 1] = 0;
+    }
+
+private:
+    static std::string toBase(unsigned long val, unsigned char base)
+    {
+        if (base == DEC)
+            return std::to_string(val);
+        std::string str;
+        do
+        {
+            str.insert(str.begin(), "0123456789abcdef"[val % base]);
+            val /= base;
+        } while (val);
+        return str;
+    }
+    static std::string toBase(long val, unsigned char base)
+    {
+        if ((base == DEC) || (val >= 0))
+            return base == DEC ? std::to_string(val) : toBase((unsigned long)val, base);
+        return toBase((unsigned long)(unsigned int)val, base);
+    }
+    static int toIdx(size_t pos) { return pos == std::string::npos ? -1 : int(pos); }
+};
@@ -0,0 +1,19 @@
+// RBotFirmware host build
+// ESP32 GPIO registers - writes and reads go to the simulated GPIOs
+
+#pragma once
+
+#include <stdint.h>
+
+#define GPIO_OUT_W1TS_REG 0x3ff44008
+#define GPIO_OUT_W1TC_REG 0x3ff4400c
+#define GPIO_OUT1_W1TS_REG 0x3ff44014
+#define GPIO_OUT1_W1TC_REG 0x3ff44018
+#define GPIO_IN_REG 0x3ff4403c
+#define GPIO_IN1_REG 0x3ff44040
+
+void hostRegWrite(uint32_t reg, uint32_t val);
+uint32_t hostRegRead(uint32_t reg);
+
+#define REG_WRITE(_r, _v) hostRegWrite((_r), (_v))
+#define REG_READ(_r) hostRegRead(_r)
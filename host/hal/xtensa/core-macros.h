@@ -0,0 +1,10 @@
+// RBotFirmware host build
+// CPU cycle counter - follows virtual time at the ESP32 clock rate
+
+#pragma once
+
+#include <stdint.h>
+
+uint32_t hostCycleCount();
+
+#define XTHAL_GET_CCOUNT() hostCycleCount()
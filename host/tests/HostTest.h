@@ -0,0 +1,222 @@
+// RBotFirmware host build
+// Checks and a robot running on the simulated hardware for the host tests
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "ArduinoLog.h"
+#include "HostHal.h"
+#include "RobotConfigurations.h"
+#include "RdJson.h"
+#include "RobotCommandArgs.h"
+#include "RobotMotion/RobotController.h"
+#include "WorkManager/Evaluators/EvaluatorGCode.h"
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond)                                                                 \
+    do                                                                              \
+    {                                                                               \
+        if (!(cond))                                                                \
+        {                                                                           \
+            printf("%s:%d CHECK failed: %s\n", __FILE__, __LINE__, #cond);          \
+            hostTestFailures++;                                                     \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                       \
+    do                                                                              \
+    {                                                                               \
+        double checkA = (a), checkB = (b);                                          \
+        if (fabs(checkA - checkB) > (tol))                                          \
+        {                                                                           \
+            printf("%s:%d CHECK_NEAR failed: %s = %g, %s = %g\n", __FILE__,         \
+                   __LINE__, #a, checkA, #b, checkB);                               \
+            hostTestFailures++;                                                     \
+        }                                                                           \
+    } while (0)
+
+static inline int hostTestResult(const char* testName)
+{
+    printf("%s: %s\n", testName, hostTestFailures ? "FAILED" : "passed");
+    return hostTestFailures ? 1 : 0;
+}
+
+// Position of an axis moving in one direction (steps) sampled every sampleNs from the rising
+// edges of its step pin in the pin log (linear between steps)
+static inline std::vector<double> sampleStepPosition(int stepPin, uint64_t sampleNs)
+{
+    std::vector<uint64_t> stepTimesNs;
+    for (const HostHal::PinEvent& ev : HostHal::pinEvents())
+        if ((ev._pin == stepPin) && ev._level)
+            stepTimesNs.push_back(ev._timeNs);
+    std::vector<double> posns;
+    if (stepTimesNs.size() < 2)
+        return posns;
+    size_t stepIdx = 0;
+    for (uint64_t t = stepTimesNs.front(); t <= stepTimesNs.back(); t += sampleNs)
+    {
+        while ((stepIdx + 1 < stepTimesNs.size()) && (stepTimesNs[stepIdx + 1] <= t))
+            stepIdx++;
+        double frac = 0;
+        if (stepIdx + 1 < stepTimesNs.size())
+            frac = double(t - stepTimesNs[stepIdx]) / double(stepTimesNs[stepIdx + 1] - stepTimesNs[stepIdx]);
+        posns.push_back(stepIdx + frac);
+    }
+    return posns;
+}
+
+// Peak of the nth derivative (1 = rate, 2 = acceleration, 3 = jerk) of sampled positions
+// using differences over windows of h samples
+static inline double peakDerivative(const std::vector<double>& posns, double sampleSecs, int h, int order)
+{
+    static const int coeffs[4][4] = {{1, 0, 0, 0}, {-1, 1, 0, 0}, {1, -2, 1, 0}, {-1, 3, -3, 1}};
+    double hSecs = h * sampleSecs;
+    double peak = 0;
+    for (size_t i = 0; i + order * h < posns.size(); i++)
+    {
+        double diff = 0;
+        for (int k = 0; k <= order; k++)
+            diff += coeffs[order][k] * posns[i + k * h];
+        peak = std::max(peak, fabs(diff / pow(hSecs, order)));
+    }
+    return peak;
+}
+
+// Robot running on the simulated hardware - the ramp generator runs from its virtual
+// timer (20us ticks) as virtual time is advanced between calls to service()
+class HostRobot
+{
+public:
+    RobotController _robotController;
+
+    // Robot config (as stored under robotConfig) for a built-in robot type with
+    // optional text replacements to change settings
+    static std::string getConfig(const char* robotType,
+                                 std::initializer_list<std::pair<const char*, const char*>> replacements = {})
+    {
+        std::string configStr = RdJson::getString("/robotConfig", "{}", RobotConfigurations::getConfig(robotType)).c_str();
+        for (auto& replacement : replacements)
+        {
+            size_t pos = configStr.find(replacement.first);
+            if (pos != std::string::npos)
+                configStr.replace(pos, strlen(replacement.first), replacement.second);
+            else
+                printf("HostRobot: config has no %s\n", replacement.first);
+        }
+        return configStr;
+    }
+
+    // Pins of the built-in robots
+    static constexpr int AXIS0_STEP_PIN = 19;
+    static constexpr int AXIS0_DIRN_PIN = 21;
+    static constexpr int AXIS0_ENDSTOP_PIN = 22;
+    static constexpr int AXIS1_STEP_PIN = 27;
+    static constexpr int AXIS1_DIRN_PIN = 3;
+    static constexpr int AXIS1_ENDSTOP_PIN = 23;
+
+    // End-stops of the built-in robots are active low so they start off not hit
+    bool init(const std::string& configStr)
+    {
+        HostHal::reset();
+        setEndStop(0, false);
+        setEndStop(1, false);
+        return _robotController.init(configStr.c_str());
+    }
+
+    void setEndStop(int axisIdx, bool hit)
+    {
+        HostHal::setInput(axisIdx == 0 ? AXIS0_ENDSTOP_PIN : AXIS1_ENDSTOP_PIN, !hit);
+    }
+
+    // Run for a time advancing virtual time by stepUs between services
+    void run(uint64_t timeUs, uint32_t stepUs = 20)
+    {
+        for (uint64_t t = 0; t < timeUs; t += stepUs)
+        {
+            HostHal::advanceUs(stepUs);
+            _robotController.service();
+        }
+    }
+
+    // Run until nothing is queued or planned (checked over 50ms so that moves being split
+    // into blocks are not mistaken for idle) - returns false on timeout
+    bool runUntilIdle(uint64_t maxUs, uint32_t stepUs = 20)
+    {
+        uint64_t idleUs = 0;
+        for (uint64_t t = 0; t < maxUs; t += stepUs)
+        {
+            HostHal::advanceUs(stepUs);
+            _robotController.service();
+            RobotCommandArgs status;
+            _robotController.getCurStatus(status);
+            idleUs = (status.getNumQueued() == 0) ? idleUs + stepUs : 0;
+            if (idleUs >= 50000)
+                return true;
+        }
+        return false;
+    }
+
+    // Run until the robot can accept another motion command - returns false on timeout
+    bool runUntilCanAccept(uint64_t maxUs, uint32_t stepUs = 20)
+    {
+        for (uint64_t t = 0; t < maxUs; t += stepUs)
+        {
+            if (_robotController.canAcceptCommand())
+                return true;
+            HostHal::advanceUs(stepUs);
+            _robotController.service();
+        }
+        return false;
+    }
+
+    // Move to a point (mm) - false if the robot's command queue is full
+    bool moveTo(float x, float y, float feedrate = 0)
+    {
+        RobotCommandArgs args;
+        args.setAxisValMM(0, x, true);
+        args.setAxisValMM(1, y, true);
+        if (feedrate > 0)
+            args.setFeedrate(feedrate);
+        return _robotController.moveTo(args);
+    }
+
+    // Stepwise move (steps relative to the current position) - optionally stopping when an
+    // axis's end-stop is hit - false if the robot's command queue is full
+    bool moveSteps(int32_t steps0, int32_t steps1, int endStopAxisIdx = -1)
+    {
+        RobotCommandArgs args;
+        args.setAxisSteps(0, steps0, true);
+        args.setAxisSteps(1, steps1, true);
+        args.setMoveType(RobotMoveTypeArg_Relative);
+        if (endStopAxisIdx >= 0)
+            args.setTestEndStop(endStopAxisIdx, 0, AxisMinMaxBools::END_STOP_HIT);
+        return _robotController.moveTo(args);
+    }
+
+    // Interpret a line of G-code
+    bool gcode(const char* cmdStr)
+    {
+        WorkItem workItem(cmdStr);
+        return EvaluatorGCode::interpretGcode(workItem, &_robotController, true);
+    }
+
+    // Blocks added to the pipeline since the motion stats were reset
+    uint32_t blocksPlanned()
+    {
+        String statsStr;
+        _robotController.motionStats("", statsStr);
+        return uint32_t(RdJson::getLong("blocksPlanned", 0, statsStr.c_str()));
+    }
+
+    AxisInt32s getSteps()
+    {
+        RobotCommandArgs status;
+        _robotController.getCurStatus(status);
+        return status.getPointSteps();
+    }
+};
@@ -0,0 +1,86 @@
+// RBotFirmware host build
+// Actuator limits on a rotary table - a spiral in towards the centre (as XY points or as a
+// native polar move) keeps the rotary motor within its max step rate and acceleration
+
+#include "HostTest.h"
+
+static const float SPIRAL_START_RHO_MM = 140;
+static const float SPIRAL_END_RHO_MM = 4;
+static const int SPIRAL_TURNS = 3;
+
+// TranquilSmall rotary axis - maxRPM 4 at 38400 steps/rot and by default reaching that in
+// maxSpeed / maxAcc (0.6s)
+static const double ROTARY_MAX_STEP_RATE = 4 * 38400 / 60.0;
+static const double ROTARY_MAX_STEP_ACC = ROTARY_MAX_STEP_RATE / 0.6;
+
+struct SpiralResult
+{
+    uint32_t _blocks;
+    double _secs;
+    double _peakRate;
+    double _peakAcc;
+};
+
+static SpiralResult drawSpiral(bool polarNative, bool actuatorLimits)
+{
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall", {{"\"blockDistanceMM\":1",
+                actuatorLimits ? "\"blockDistanceMM\":1,\"actuatorLimits\":1" : "\"blockDistanceMM\":1"}})));
+    char cmdStr[100];
+    snprintf(cmdStr, sizeof(cmdStr), "G0 X%.3f Y0", SPIRAL_START_RHO_MM);
+    CHECK(robot.gcode(cmdStr));
+    CHECK(robot.runUntilIdle(60000000, 100));
+
+    String respStr;
+    robot._robotController.motionStats("reset", respStr);
+    HostHal::clearLogs();
+    uint64_t startNs = HostHal::nowNs();
+    if (polarNative)
+    {
+        snprintf(cmdStr, sizeof(cmdStr), "G0 X%.3f Y0 W%d", SPIRAL_END_RHO_MM, SPIRAL_TURNS * 360);
+        CHECK(robot.gcode(cmdStr));
+    }
+    else
+    {
+        const int numPoints = SPIRAL_TURNS * 180;
+        for (int i = 1; i <= numPoints; i++)
+        {
+            float angle = i * 2 * M_PI / 180;
+            float rho = SPIRAL_START_RHO_MM + (SPIRAL_END_RHO_MM - SPIRAL_START_RHO_MM) * i / numPoints;
+            snprintf(cmdStr, sizeof(cmdStr), "G0 X%.3f Y%.3f", rho * cosf(angle), rho * sinf(angle));
+            CHECK(robot.runUntilCanAccept(10000000, 100));
+            CHECK(robot.gcode(cmdStr));
+        }
+    }
+    CHECK(robot.runUntilIdle(600000000, 100));
+    SpiralResult result;
+    result._blocks = robot.blocksPlanned();
+    result._secs = (HostHal::nowNs() - startNs) / 1e9 - 0.05;
+    const uint64_t SAMPLE_NS = 1000000;
+    std::vector<double> posns = sampleStepPosition(HostRobot::AXIS0_STEP_PIN, SAMPLE_NS);
+    result._peakRate = peakDerivative(posns, SAMPLE_NS / 1e9, 20, 1);
+    // Acceleration is measured over 50ms so the small jumps in rate allowed at junctions
+    // don't swamp it
+    result._peakAcc = peakDerivative(posns, SAMPLE_NS / 1e9, 50, 2);
+    return result;
+}
+
+int main()
+{
+    printf("rotary max %.0f steps/s, %.0f steps/s^2\n", ROTARY_MAX_STEP_RATE, ROTARY_MAX_STEP_ACC);
+    for (bool actuatorLimits : {false, true})
+    {
+        SpiralResult xyResult = drawSpiral(false, actuatorLimits);
+        SpiralResult polarResult = drawSpiral(true, actuatorLimits);
+        for (const SpiralResult* pResult : {&xyResult, &polarResult})
+        {
+            printf("actuatorLimits %d %s: %u blocks %.1fs, rotary peak %.0f steps/s %.0f steps/s^2\n", actuatorLimits,
+                   pResult == &xyResult ? "XY points" : "polar move", pResult->_blocks, pResult->_secs,
+                   pResult->_peakRate, pResult->_peakAcc);
+            CHECK(pResult->_peakRate < ROTARY_MAX_STEP_RATE * 1.03);
+            CHECK(pResult->_peakAcc < ROTARY_MAX_STEP_ACC * 1.1);
+        }
+        CHECK(polarResult._secs < xyResult._secs * 1.02);
+    }
+    return hostTestResult("test_actuator_limits");
+}
@@ -0,0 +1,61 @@
+// RBotFirmware host build
+// Axis values in a build with fewer axes than the XYZ accessors - a value for an axis that isn't
+// built is dropped (reported once when G-code gives one) and the status keeps 3 values per axis array
+
+#include "HostTest.h"
+
+static int statusArrayLen(const String& statusStr, const char* key)
+{
+    int arrayLen = 0;
+    String arrayStr = RdJson::getString(key, "", statusStr.c_str());
+    if (RdJson::getType(arrayLen, arrayStr.c_str()) != JSMNR_ARRAY)
+        return -1;
+    return arrayLen;
+}
+
+int main()
+{
+    CHECK(RobotConsts::MAX_AXES == 2);
+
+    // Value types drop Z without logging (they are used in the planner and ISR)
+    unsigned numWarnings = Log._numWarnings;
+    AxisFloats pt(1, 2, 3);
+    pt.set(3, 4, 5);
+    pt.Z(6);
+    AxisInt32s steps(5, 6, 7);
+    steps.set(7, 8, 9);
+    AxisFloats ptValid(1, 2, 3, true, true, true);
+    CHECK(Log._numWarnings == numWarnings);
+    CHECK(pt.X() == 3);
+    CHECK(pt.Y() == 4);
+    CHECK(pt.Z() == 0);
+    CHECK(pt._validityFlags == 0x03);
+    CHECK(steps.X() == 7);
+    CHECK(steps.Y() == 8);
+    CHECK(steps.Z() == 0);
+    CHECK(ptValid._validityFlags == 0x03);
+
+    // G-code with Z is reported once and moves X and Y
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall")));
+    numWarnings = Log._numWarnings;
+    CHECK(robot.gcode("G0 X10 Y10 Z5"));
+    CHECK(Log._numWarnings == numWarnings + 1);
+    CHECK(robot.gcode("G0 X20 Y10 Z5"));
+    CHECK(robot.gcode("G0 X20 Y20 C100"));
+    CHECK(Log._numWarnings == numWarnings + 1);
+    CHECK(robot.runUntilIdle(60000000, 100));
+    CHECK(Log._numErrors == 0);
+
+    // Status arrays keep 3 entries with 0 for the axis that isn't built
+    RobotCommandArgs status;
+    robot._robotController.getCurStatus(status);
+    String statusStr = status.toJSON();
+    printf("status %s\n", statusStr.c_str());
+    CHECK(statusArrayLen(statusStr, "XYZ") == 3);
+    CHECK(statusArrayLen(statusStr, "ABC") == 3);
+    CHECK(statusArrayLen(statusStr, "end") == 3);
+    CHECK(statusStr.indexOf("\"XYZ\":[20.00,20.00,0.00]") >= 0);
+
+    return hostTestResult("test_axis_values");
+}
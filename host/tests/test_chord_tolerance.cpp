@@ -0,0 +1,100 @@
+// RBotFirmware host build
+// Straight lines split by chord tolerance - the path the ball takes (from the steps made by
+// the motors) stays within the tolerance of each line, plus the distance of a step, and lines
+// need fewer blocks than with the fixed block distance
+
+#include "HostTest.h"
+
+// TranquilSmall geometry
+static const float THETA_STEPS_PER_ROT = 38400;
+static const float RHO_STEPS_PER_ROT = 3200;
+static const float RHO_STEPS_PER_MM = 3200 / 40.5f;
+static const float CHORD_TOLERANCE_MM = 0.05f;
+
+// Position of the ball from motor steps (as RobotSandTableRotary::actuatorToPt)
+static void stepsToPt(int32_t steps0, int32_t steps1, float& x, float& y)
+{
+    float theta = steps0 * 2 * M_PI / THETA_STEPS_PER_ROT;
+    float rho = (steps1 - steps0 * (RHO_STEPS_PER_ROT / THETA_STEPS_PER_ROT)) / RHO_STEPS_PER_MM;
+    x = rho * cosf(theta);
+    y = rho * sinf(theta);
+}
+
+// Distance from a point to the line segment between two points
+static float distToLine(float x, float y, float x0, float y0, float x1, float y1)
+{
+    float dx = x1 - x0, dy = y1 - y0;
+    float t = ((x - x0) * dx + (y - y0) * dy) / (dx * dx + dy * dy);
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    return hypotf(x - (x0 + t * dx), y - (y0 + t * dy));
+}
+
+// Draw a line and find the furthest the ball gets from it - direction pin levels for
+// positive steps are found from a short move first
+static float lineDeviationMM(float chordToleranceMM, float x0, float y0, float x1, float y1, uint32_t& numBlocks)
+{
+    char chordStr[100];
+    snprintf(chordStr, sizeof(chordStr), "\"blockDistanceMM\":1,\"chordToleranceMM\":%g", chordToleranceMM);
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall", {{"\"blockDistanceMM\":1", chordStr}})));
+    HostHal::clearLogs();
+    robot.moveSteps(10, 10);
+    CHECK(robot.runUntilIdle(10000000));
+    bool posLevel0 = HostHal::getLevel(HostRobot::AXIS0_DIRN_PIN);
+    bool posLevel1 = HostHal::getLevel(HostRobot::AXIS1_DIRN_PIN);
+
+    CHECK(robot.moveTo(x0, y0));
+    CHECK(robot.runUntilIdle(60000000, 100));
+    AxisInt32s startSteps = robot.getSteps();
+    int32_t steps0 = startSteps.getVal(0), steps1 = startSteps.getVal(1);
+    bool dirnLevel0 = HostHal::getLevel(HostRobot::AXIS0_DIRN_PIN);
+    bool dirnLevel1 = HostHal::getLevel(HostRobot::AXIS1_DIRN_PIN);
+    String respStr;
+    robot._robotController.motionStats("reset", respStr);
+    HostHal::clearLogs();
+    CHECK(robot.moveTo(x1, y1));
+    CHECK(robot.runUntilIdle(60000000, 100));
+    numBlocks = robot.blocksPlanned();
+
+    float maxDevMM = 0;
+    for (const HostHal::PinEvent& ev : HostHal::pinEvents())
+    {
+        if (ev._pin == HostRobot::AXIS0_DIRN_PIN)
+            dirnLevel0 = ev._level;
+        else if (ev._pin == HostRobot::AXIS1_DIRN_PIN)
+            dirnLevel1 = ev._level;
+        else if ((ev._pin == HostRobot::AXIS0_STEP_PIN) && ev._level)
+            steps0 += (dirnLevel0 == posLevel0) ? 1 : -1;
+        else if ((ev._pin == HostRobot::AXIS1_STEP_PIN) && ev._level)
+            steps1 += (dirnLevel1 == posLevel1) ? 1 : -1;
+        else
+            continue;
+        float x = 0, y = 0;
+        stepsToPt(steps0, steps1, x, y);
+        maxDevMM = std::max(maxDevMM, distToLine(x, y, x0, y0, x1, y1));
+    }
+    CHECK(steps0 == robot.getSteps().getVal(0));
+    CHECK(steps1 == robot.getSteps().getVal(1));
+    return maxDevMM;
+}
+
+int main()
+{
+    // Distance moved by one step of each motor at the rim
+    float stepMM = hypotf(2 * M_PI * 145 / THETA_STEPS_PER_ROT, 1 / RHO_STEPS_PER_MM);
+
+    // Lines near the rim, part way in and passing close to the centre
+    const float lines[][4] = {{-100, 100, 100, 100}, {140, 0, 0, 140}, {-120, 30, 120, 30}, {-80, 8, 80, 8}};
+    for (auto& line : lines)
+    {
+        uint32_t fixedBlocks = 0, chordBlocks = 0;
+        float fixedDevMM = lineDeviationMM(0, line[0], line[1], line[2], line[3], fixedBlocks);
+        float chordDevMM = lineDeviationMM(CHORD_TOLERANCE_MM, line[0], line[1], line[2], line[3], chordBlocks);
+        printf("line (%g,%g) to (%g,%g): blockDistanceMM %u blocks max deviation %.3fmm, "
+               "chordToleranceMM %u blocks max deviation %.3fmm\n", line[0], line[1], line[2], line[3],
+               fixedBlocks, fixedDevMM, chordBlocks, chordDevMM);
+        CHECK(chordDevMM <= CHORD_TOLERANCE_MM + stepMM);
+        CHECK(chordBlocks < fixedBlocks);
+    }
+    return hostTestResult("test_chord_tolerance");
+}
@@ -0,0 +1,52 @@
+// RBotFirmware host build
+// Robot command queue - commands are refused (rather than silently dropped) when the queue is
+// full and stopping discards queued commands so that new ones are accepted
+
+#include "HostTest.h"
+
+int main()
+{
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall")));
+
+    // Fill the queue without servicing the robot
+    int numAccepted = 0;
+    while (robot._robotController.canAcceptCommand() && (numAccepted < 1000))
+    {
+        CHECK(robot.moveSteps(10, 10));
+        numAccepted++;
+    }
+    CHECK(numAccepted > 0);
+    CHECK(!robot.moveSteps(10, 10));
+    CHECK(!robot.gcode("G0 X10 Y0"));
+    CHECK(!robot.gcode("G90"));
+    RobotCommandArgs args;
+    CHECK(!robot._robotController.setHome(args));
+    CHECK(!robot._robotController.goHome(args));
+
+    // Commands which don't need the queue are still handled
+    CHECK(robot.gcode("M220 S100"));
+
+    // Every accepted command is executed
+    CHECK(robot.runUntilIdle(60000000));
+    CHECK(robot.getSteps().getVal(0) == numAccepted * 10);
+    CHECK(robot.getSteps().getVal(1) == numAccepted * 10);
+
+    // Stopping discards queued commands and the queue accepts new ones (moves are planned again
+    // once the stop has completed)
+    for (int i = 0; i < 5; i++)
+        CHECK(robot.moveSteps(1000, 0));
+    robot._robotController.stop();
+    RobotCommandArgs status;
+    robot._robotController.getCurStatus(status);
+    CHECK(status.getNumQueued() == 0);
+    CHECK(robot._robotController.canAcceptCommand());
+    robot.run(600000);
+    AxisInt32s stepsAtStop = robot.getSteps();
+    CHECK(robot.moveSteps(0, 50));
+    CHECK(robot.runUntilIdle(60000000));
+    CHECK(robot.getSteps().getVal(0) == stepsAtStop.getVal(0));
+    CHECK(robot.getSteps().getVal(1) == stepsAtStop.getVal(1) + 50);
+
+    return hostTestResult("test_command_queue");
+}
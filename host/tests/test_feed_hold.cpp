@@ -0,0 +1,86 @@
+// RBotFirmware host build
+// Feed hold - pausing part way through a move decelerates to a stop (rather than stopping
+// dead) and resuming finishes the move with exactly the same steps, in every ramp generator mode
+
+#include "HostTest.h"
+
+static std::string modeConfig(const char* rampGenMode)
+{
+    std::string rampGenStr = std::string("\"rampGen\":{\"mode\":\"") + rampGenMode + "\"},\"blockDistanceMM\":1";
+    return HostRobot::getConfig("TranquilSmall", {{"\"blockDistanceMM\":1", rampGenStr.c_str()}});
+}
+
+// Radial line of 40mm (only the linear axis moves) or a path of 80 1mm blocks with a hold
+// of holdSecs starting at holdAtSecs (no hold if holdSecs is 0)
+// Returns the peak acceleration of the linear axis (mm/s^2)
+static double drawWithHold(const char* rampGenMode, bool path, double holdAtSecs, double holdSecs,
+                           AxisInt32s& endSteps)
+{
+    HostRobot robot;
+    CHECK(robot.init(modeConfig(rampGenMode)));
+    CHECK(robot.gcode("G0 X20 Y0"));
+    CHECK(robot.runUntilIdle(60000000, 100));
+    HostHal::clearLogs();
+
+    uint64_t startNs = HostHal::nowNs();
+    int blocksToSend = path ? 80 : 0;
+    if (!path)
+        CHECK(robot.gcode("G1 X60 Y0"));
+    int blockIdx = 0;
+    bool held = (holdSecs == 0);
+    while ((blockIdx < blocksToSend) || !held)
+    {
+        if (!held && (HostHal::nowNs() - startNs >= uint64_t(holdAtSecs * 1e9)))
+        {
+            // Stopped (no steps) after the deceleration (as long as the block's 0.6s ramp)
+            robot._robotController.pause(true);
+            robot.run(uint64_t(holdSecs * 1e6 * 0.7), 100);
+            uint32_t stepsBeforeEnd = HostHal::countRisingEdges(HostRobot::AXIS0_STEP_PIN) +
+                        HostHal::countRisingEdges(HostRobot::AXIS1_STEP_PIN);
+            robot.run(uint64_t(holdSecs * 1e6 * 0.3), 100);
+            CHECK(robot._robotController.isPaused());
+            CHECK(HostHal::countRisingEdges(HostRobot::AXIS0_STEP_PIN) +
+                        HostHal::countRisingEdges(HostRobot::AXIS1_STEP_PIN) == stepsBeforeEnd);
+            robot._robotController.pause(false);
+            held = true;
+        }
+        if ((blockIdx < blocksToSend) && robot._robotController.canAcceptCommand())
+        {
+            blockIdx++;
+            float angle = blockIdx * 0.01f;
+            char cmdStr[50];
+            snprintf(cmdStr, sizeof(cmdStr), "G1 X%.3f Y%.3f", 20 + 100 * sinf(angle), 100 * (1 - cosf(angle)));
+            CHECK(robot.gcode(cmdStr));
+        }
+        robot.run(100, 100);
+    }
+    CHECK(robot.runUntilIdle(600000000, 100));
+    endSteps = robot.getSteps();
+
+    // Linear axis - TranquilSmall has 3200 steps per 40.5mm
+    const uint64_t SAMPLE_NS = 1000000;
+    std::vector<double> posns = sampleStepPosition(HostRobot::AXIS1_STEP_PIN, SAMPLE_NS);
+    return peakDerivative(posns, SAMPLE_NS / 1e9, 10, 2) * 40.5 / 3200;
+}
+
+int main()
+{
+    const double MAX_ACC_MMPS2 = 25;
+    for (const char* rampGenMode : {"accumulator", "stepEvents", "stepTimer"})
+    {
+        AxisInt32s steps, stepsHeld;
+        double peakAcc = drawWithHold(rampGenMode, false, 0, 0, steps);
+        double peakAccHeld = drawWithHold(rampGenMode, false, 0.9, 1, stepsHeld);
+        printf("%s: 40mm line peak acceleration %.0fmm/s^2, with hold at 0.9s %.0fmm/s^2\n", rampGenMode,
+               peakAcc, peakAccHeld);
+        CHECK(peakAccHeld < MAX_ACC_MMPS2 * 5);
+        CHECK(stepsHeld.getVal(0) == steps.getVal(0));
+        CHECK(stepsHeld.getVal(1) == steps.getVal(1));
+
+        drawWithHold(rampGenMode, true, 0, 0, steps);
+        drawWithHold(rampGenMode, true, 2, 1, stepsHeld);
+        CHECK(stepsHeld.getVal(0) == steps.getVal(0));
+        CHECK(stepsHeld.getVal(1) == steps.getVal(1));
+    }
+    return hostTestResult("test_feed_hold");
+}
@@ -0,0 +1,80 @@
+// RBotFirmware host build
+// Feed override - a path of 1mm blocks is drawn in time scaled by the override (including
+// when it is changed part way through) and ends at the same steps, in every ramp generator mode
+
+#include "HostTest.h"
+
+static const int PATH_BLOCKS = 80;
+
+static std::string modeConfig(const char* rampGenMode)
+{
+    std::string rampGenStr = std::string("\"rampGen\":{\"mode\":\"") + rampGenMode + "\"},\"blockDistanceMM\":1";
+    return HostRobot::getConfig("TranquilSmall", {{"\"blockDistanceMM\":1", rampGenStr.c_str()}});
+}
+
+// Draw time of the path with the override set at the start and changed to switchPercent
+// after switchSecs (if switchPercent isn't 0)
+static double drawPath(const char* rampGenMode, int percent, AxisInt32s& endSteps,
+                       double switchSecs = 0, int switchPercent = 0)
+{
+    HostRobot robot;
+    CHECK(robot.init(modeConfig(rampGenMode)));
+    CHECK(robot.gcode("G0 X60 Y0"));
+    CHECK(robot.runUntilIdle(60000000, 100));
+    char cmdStr[50];
+    snprintf(cmdStr, sizeof(cmdStr), "M220 S%d", percent);
+    CHECK(robot.gcode(cmdStr));
+
+    // Points 1mm apart on a gentle curve
+    uint64_t startNs = HostHal::nowNs();
+    bool switched = (switchPercent == 0);
+    int blockIdx = 0;
+    while (true)
+    {
+        if (!switched && (HostHal::nowNs() - startNs >= uint64_t(switchSecs * 1e9)))
+        {
+            snprintf(cmdStr, sizeof(cmdStr), "M220 S%d", switchPercent);
+            CHECK(robot.gcode(cmdStr));
+            switched = true;
+        }
+        if ((blockIdx < PATH_BLOCKS) && robot._robotController.canAcceptCommand())
+        {
+            blockIdx++;
+            float angle = blockIdx * 0.01f;
+            snprintf(cmdStr, sizeof(cmdStr), "G1 X%.3f Y%.3f", 60 + 100 * sinf(angle), 100 * (1 - cosf(angle)));
+            CHECK(robot.gcode(cmdStr));
+        }
+        if (blockIdx >= PATH_BLOCKS && switched)
+            break;
+        robot.run(100, 100);
+    }
+    CHECK(robot.runUntilIdle(600000000, 100));
+    endSteps = robot.getSteps();
+    return (HostHal::nowNs() - startNs) / 1e9 - 0.05;
+}
+
+int main()
+{
+    for (const char* rampGenMode : {"accumulator", "stepEvents", "stepTimer"})
+    {
+        AxisInt32s steps100, steps50, steps150, stepsSwitch;
+        double secs100 = drawPath(rampGenMode, 100, steps100);
+        double secs50 = drawPath(rampGenMode, 50, steps50);
+        double secs150 = drawPath(rampGenMode, 150, steps150);
+        const double SWITCH_SECS = 2;
+        double secsSwitch = drawPath(rampGenMode, 100, stepsSwitch, SWITCH_SECS, 50);
+        double expectedSwitch = SWITCH_SECS + (secs100 - SWITCH_SECS) * 2;
+        printf("%s: 100%% %.2fs, 50%% %.2fs, 150%% %.2fs, 100%%->50%% at %.0fs %.2fs (expected %.2fs)\n", rampGenMode,
+               secs100, secs50, secs150, SWITCH_SECS, secsSwitch, expectedSwitch);
+        CHECK(secs100 > SWITCH_SECS * 1.5);
+        CHECK_NEAR(secs50, secs100 * 2, secs100 * 0.1);
+        CHECK_NEAR(secs150, secs100 / 1.5, secs100 * 0.05);
+        CHECK_NEAR(secsSwitch, expectedSwitch, expectedSwitch * 0.05);
+        for (AxisInt32s* pSteps : {&steps50, &steps150, &stepsSwitch})
+        {
+            CHECK(pSteps->getVal(0) == steps100.getVal(0));
+            CHECK(pSteps->getVal(1) == steps100.getVal(1));
+        }
+    }
+    return hostTestResult("test_feed_override");
+}
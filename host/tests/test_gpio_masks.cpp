@@ -0,0 +1,170 @@
+// RBotFirmware host build
+// Step and direction pins driven with GPIO register masks match what StepperMotor would do -
+// for both GPIO banks, reversed axes, changes of direction and axes with multiplexed direction
+
+#include "HostTest.h"
+#include "RobotMotion/MotionControl/RampGenerator/RampGenIO.h"
+#include "RobotMotion/MotionControl/RampGenerator/StepperMotor.h"
+#include "soc/gpio_reg.h"
+
+// Masks and direction levels of a configured axis against a StepperMotor on the same pins
+static void checkAxisMasks(int stepPin, int dirnPin, bool dirnRev)
+{
+    char axisJSON[100];
+    snprintf(axisJSON, sizeof(axisJSON), "{\"stepPin\":\"%d\",\"dirnPin\":\"%d\",\"dirnRev\":%d}",
+             stepPin, dirnPin, dirnRev ? 1 : 0);
+    HostHal::reset();
+    RampGenIO rampGenIO;
+    CHECK(rampGenIO.configureAxis(0, axisJSON));
+    CHECK(rampGenIO.getStepPinMask(0) == (1ULL << stepPin));
+    CHECK(rampGenIO.getDirnPinMask(0) == (1ULL << dirnPin));
+    StepperMotor refMotor(RobotConsts::MOTOR_TYPE_DRIVER, stepPin, dirnPin, -1, -1, -1, 0, dirnRev);
+    for (bool dirn : {true, false})
+    {
+        refMotor.setDirection(dirn);
+        CHECK(rampGenIO.getDirnPinLevel(0, dirn) == HostHal::getLevel(dirnPin));
+    }
+
+    // One write to the register of the pin's bank sets or clears it
+    int bankBit = stepPin % 32;
+    HostHal::clearLogs();
+    RampGenIO::setPinsInMask(rampGenIO.getStepPinMask(0));
+    CHECK(HostHal::getLevel(stepPin));
+    CHECK(HostHal::regWrites().size() == 1);
+    CHECK(HostHal::regWrites()[0]._reg == int(stepPin < 32 ? GPIO_OUT_W1TS_REG : GPIO_OUT1_W1TS_REG));
+    CHECK(HostHal::regWrites()[0]._val == (1u << bankBit));
+    RampGenIO::clearPinsInMask(rampGenIO.getStepPinMask(0));
+    CHECK(!HostHal::getLevel(stepPin));
+    CHECK(HostHal::regWrites().size() == 2);
+    CHECK(HostHal::regWrites()[1]._reg == int(stepPin < 32 ? GPIO_OUT_W1TC_REG : GPIO_OUT1_W1TC_REG));
+    CHECK(HostHal::regWrites()[1]._val == (1u << bankBit));
+}
+
+// Steps made by an axis from the pin log - each rising edge of the step pin counts in the
+// direction given by the direction pin (or the multiplexer pins) at the time
+struct AxisPins
+{
+    int _stepPin;
+    int _dirnPin;
+    bool _dirnRev;
+    int _muxPin1;
+    int _muxPin2;
+    int _muxDirnIdx;
+};
+
+// Levels StepperMotor sets on the direction pin (or multiplexer pins) when stepping an axis in
+// a direction - found using a motor on spare pins
+static const int REF_STEP_PIN = 39, REF_DIRN_PIN = 38, REF_MUX_PIN1 = 36, REF_MUX_PIN2 = 37;
+static void refDirnLevels(const AxisPins& pins, bool dirn, bool& level1, bool& level2)
+{
+    bool muxed = pins._dirnPin < 0;
+    StepperMotor refMotor(RobotConsts::MOTOR_TYPE_DRIVER, REF_STEP_PIN, muxed ? -1 : REF_DIRN_PIN,
+                          muxed ? REF_MUX_PIN1 : -1, muxed ? REF_MUX_PIN2 : -1, -1, pins._muxDirnIdx, pins._dirnRev);
+    refMotor.setDirection(dirn);
+    refMotor.stepStart();
+    refMotor.stepEnd();
+    level1 = HostHal::getLevel(muxed ? REF_MUX_PIN1 : REF_DIRN_PIN);
+    level2 = muxed ? HostHal::getLevel(REF_MUX_PIN2) : false;
+}
+
+static void countSteps(const AxisPins& pins, const bool* startLevels, int32_t& posSteps, int32_t& negSteps,
+                       int& badSteps)
+{
+    bool posLevel1 = false, posLevel2 = false, negLevel1 = false, negLevel2 = false;
+    refDirnLevels(pins, true, posLevel1, posLevel2);
+    refDirnLevels(pins, false, negLevel1, negLevel2);
+    posSteps = 0;
+    negSteps = 0;
+    badSteps = 0;
+    bool pinLevels[HostHal::NUM_GPIO_PINS];
+    for (int pin = 0; pin < HostHal::NUM_GPIO_PINS; pin++)
+        pinLevels[pin] = startLevels[pin];
+    const std::vector<HostHal::PinEvent> pinEvents = HostHal::pinEvents();
+    for (const HostHal::PinEvent& ev : pinEvents)
+    {
+        pinLevels[ev._pin] = ev._level;
+        if ((ev._pin != pins._stepPin) || !ev._level)
+            continue;
+        bool level1 = pinLevels[pins._dirnPin >= 0 ? pins._dirnPin : pins._muxPin1];
+        bool level2 = (pins._dirnPin >= 0) ? false : pinLevels[pins._muxPin2];
+        if ((level1 == posLevel1) && (level2 == posLevel2))
+            posSteps++;
+        else if ((level1 == negLevel1) && (level2 == negLevel2))
+            negSteps++;
+        else
+            badSteps++;
+    }
+}
+
+static uint32_t countRegWritesWithPin(uint32_t reg, int pin)
+{
+    uint32_t count = 0;
+    for (const HostHal::RegWrite& regWrite : HostHal::regWrites())
+        if ((regWrite._reg == int(reg)) && (regWrite._val & (1u << (pin % 32))))
+            count++;
+    return count;
+}
+
+static void checkMoves(HostRobot& robot, const AxisPins& axis0, const AxisPins& axis1)
+{
+    const int32_t moves[][2] = {{300, -200}, {-450, 120}, {80, 80}, {-80, -310}};
+    for (auto& move : moves)
+    {
+        AxisInt32s startSteps = robot.getSteps();
+        bool startLevels[HostHal::NUM_GPIO_PINS];
+        for (int pin = 0; pin < HostHal::NUM_GPIO_PINS; pin++)
+            startLevels[pin] = HostHal::getLevel(pin);
+        HostHal::clearLogs();
+        robot.moveSteps(move[0], move[1]);
+        CHECK(robot.runUntilIdle(20000000));
+        CHECK(robot.getSteps().getVal(0) - startSteps.getVal(0) == move[0]);
+        CHECK(robot.getSteps().getVal(1) - startSteps.getVal(1) == move[1]);
+        int32_t posSteps = 0, negSteps = 0;
+        int badSteps = 0;
+        countSteps(axis0, startLevels, posSteps, negSteps, badSteps);
+        CHECK(posSteps - negSteps == move[0]);
+        CHECK(posSteps + negSteps == abs(move[0]));
+        CHECK(badSteps == 0);
+        countSteps(axis1, startLevels, posSteps, negSteps, badSteps);
+        CHECK(posSteps - negSteps == move[1]);
+        CHECK(posSteps + negSteps == abs(move[1]));
+        CHECK(badSteps == 0);
+
+        // Axis 0 is stepped by register writes to the second bank
+        CHECK(countRegWritesWithPin(GPIO_OUT1_W1TS_REG, axis0._stepPin) == uint32_t(abs(move[0])));
+        CHECK(countRegWritesWithPin(GPIO_OUT1_W1TC_REG, axis0._stepPin) == uint32_t(abs(move[0])));
+    }
+}
+
+int main()
+{
+    // Masks for pins in both banks
+    checkAxisMasks(19, 21, false);
+    checkAxisMasks(19, 21, true);
+    checkAxisMasks(33, 32, true);
+    checkAxisMasks(4, 33, false);
+
+    // Robot with axis 0 in the second GPIO bank and reversed, axis 1 in the first
+    AxisPins axis0Pins = {33, 32, true, -1, -1, 0};
+    AxisPins axis1Pins = {27, 3, false, -1, -1, 0};
+    {
+        HostRobot robot;
+        CHECK(robot.init(HostRobot::getConfig("TranquilSmall", {
+                    {"\"stepPin\":\"19\",\"dirnPin\":\"21\",\"dirnRev\":\"1\"", "\"stepPin\":\"33\",\"dirnPin\":\"32\",\"dirnRev\":\"1\""},
+                    {"\"stepPin\":\"27\",\"dirnRev\":\"1\"", "\"stepPin\":\"27\",\"dirnRev\":\"0\""}})));
+        checkMoves(robot, axis0Pins, axis1Pins);
+    }
+
+    // Axis 1 with multiplexed direction is stepped by StepperMotor (no register writes for its pins)
+    AxisPins axis1MuxPins = {27, -1, false, 12, 13, 2};
+    {
+        HostRobot robot;
+        CHECK(robot.init(HostRobot::getConfig("TranquilSmall", {
+                    {"\"stepPin\":\"19\",\"dirnPin\":\"21\",\"dirnRev\":\"1\"", "\"stepPin\":\"33\",\"dirnPin\":\"32\",\"dirnRev\":\"1\""},
+                    {"\"stepPin\":\"27\",\"dirnRev\":\"1\",\"dirnPin\":\"3\"", "\"stepPin\":\"27\",\"muxPin1\":\"12\",\"muxPin2\":\"13\",\"muxDirnIdx\":\"2\""}})));
+        checkMoves(robot, axis0Pins, axis1MuxPins);
+        CHECK(countRegWritesWithPin(GPIO_OUT_W1TS_REG, 27) == 0);
+    }
+
+    return hostTestResult("test_gpio_masks");
+}
@@ -0,0 +1,161 @@
+// RBotFirmware host build
+// Homing several axes in one move - each axis stops at its own end-stop and the move ends when
+// all have been hit - and the README homing sequence (which moves both axes off their end-stops
+// in one move) homes a simulated table to the same place as the built-in sequence
+
+#include "HostTest.h"
+
+// Built-in TranquilSmall sequence and the README one
+static const char* BUILT_IN_HOMING_SEQ = "FR3;A+38400n;B+3200;#;A+38400N;B+3200;#;A+200;#B+400;#;B+30000n;#;B-30000N;#;B-340;#;A=h;B=h;$";
+static const char* README_HOMING_SEQ = "FR3;A+38400n;B+30000n;#;A+38400N;B+3200;#;A+200;#B+400;#;B-30000N;#;B-340;#;A=h;B=h;$";
+
+// Simulated TranquilSmall table - the theta sensor covers a few degrees of the arm's rotation and
+// the rho sensor is at the centre, rho in steps being the linear axis less the rotation's coupling
+static const int32_t THETA_STEPS_PER_ROT = 38400;
+static const int32_t RHO_STEPS_PER_ROT_OF_THETA = 3200;
+static const int32_t THETA_SENSOR_START = 9000;
+static const int32_t THETA_SENSOR_WIDTH = 400;
+static const int32_t RHO_SENSOR_START = -300;
+
+// Services are 100us apart
+static const int32_t MAX_STEPS_PER_SERVICE = 10;
+
+static int32_t thetaOf(int32_t steps0)
+{
+    return ((steps0 % THETA_STEPS_PER_ROT) + THETA_STEPS_PER_ROT) % THETA_STEPS_PER_ROT;
+}
+
+static int32_t rhoOf(int32_t steps0, int32_t steps1)
+{
+    return steps1 - int32_t(int64_t(steps0) * RHO_STEPS_PER_ROT_OF_THETA / THETA_STEPS_PER_ROT);
+}
+
+static void setSensors(HostRobot& robot, int32_t steps0, int32_t steps1)
+{
+    int32_t theta = thetaOf(steps0);
+    int32_t rho = rhoOf(steps0, steps1);
+    robot.setEndStop(0, (theta >= THETA_SENSOR_START) && (theta < THETA_SENSOR_START + THETA_SENSOR_WIDTH));
+    robot.setEndStop(1, (rho >= RHO_SENSOR_START) && (rho <= 0));
+}
+
+// Home from a starting position (in steps) - returns false if homing fails and gives the
+// position just before the axes were set as home and the time taken
+static bool homeTable(const char* homingSeq, int32_t startSteps0, int32_t startSteps1,
+                      int32_t& endSteps0, int32_t& endSteps1, double& homingSecs)
+{
+    std::string seqStr = std::string("\"homingSeq\":\"") + homingSeq + "\"";
+    std::string builtInStr = std::string("\"homingSeq\":\"") + BUILT_IN_HOMING_SEQ + "\"";
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall", {{builtInStr.c_str(), seqStr.c_str()}})));
+    setSensors(robot, startSteps0, startSteps1);
+    CHECK(robot.gcode("G28"));
+    uint64_t startNs = HostHal::nowNs();
+    endSteps0 = startSteps0;
+    endSteps1 = startSteps1;
+    AxisInt32s prevSteps = robot.getSteps();
+    bool homingStarted = false;
+    for (int i = 0; i < 1000000; i++)
+    {
+        // Axes are set as home at the end of the sequence - the position jumps when that is done
+        // so larger changes than the axes can step between services are ignored
+        for (int j = 0; j < 10; j++)
+        {
+            AxisInt32s steps = robot.getSteps();
+            int32_t change0 = steps.getVal(0) - prevSteps.getVal(0);
+            int32_t change1 = steps.getVal(1) - prevSteps.getVal(1);
+            prevSteps = steps;
+            if ((abs(change0) < MAX_STEPS_PER_SERVICE) && (abs(change1) < MAX_STEPS_PER_SERVICE))
+            {
+                endSteps0 += change0;
+                endSteps1 += change1;
+            }
+            setSensors(robot, endSteps0, endSteps1);
+            robot.run(100, 100);
+        }
+        String homingStr;
+        robot._robotController.homingStatus(homingStr);
+        bool homing = RdJson::getLong("homing", 0, homingStr.c_str()) != 0;
+        homingStarted |= homing;
+        if (homingStarted && !homing)
+        {
+            homingSecs = (HostHal::nowNs() - startNs) / 1e9;
+            return RdJson::getLong("homed", 0, homingStr.c_str()) != 0;
+        }
+    }
+    return false;
+}
+
+// Move both axes with a check on each axis's end-stop - the end-stops are hit at different
+// times and each axis stops at its own
+static void checkEachAxisStops()
+{
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall")));
+    RobotCommandArgs args;
+    args.setAxisSteps(0, 20000, true);
+    args.setAxisSteps(1, 20000, true);
+    args.setMoveType(RobotMoveTypeArg_Relative);
+    args.setTestEndStop(0, 0, AxisMinMaxBools::END_STOP_HIT);
+    args.setTestEndStop(1, 0, AxisMinMaxBools::END_STOP_HIT);
+    CHECK(robot._robotController.moveTo(args));
+
+    // Axis 1 stops at its end-stop and axis 0 carries on
+    robot.run(500000);
+    robot.setEndStop(1, true);
+    robot.run(2000);
+    int32_t axis1Stop = robot.getSteps().getVal(1);
+    int32_t axis0AtAxis1Stop = robot.getSteps().getVal(0);
+    CHECK(axis1Stop > 0);
+    CHECK(axis1Stop < 20000);
+    robot.run(500000);
+    CHECK(robot.getSteps().getVal(1) == axis1Stop);
+    CHECK(robot.getSteps().getVal(0) > axis0AtAxis1Stop + 100);
+
+    // Move ends when axis 0's end-stop is hit too
+    robot.setEndStop(0, true);
+    robot.run(2000);
+    int32_t axis0Stop = robot.getSteps().getVal(0);
+    CHECK(axis0Stop < 20000);
+    CHECK(robot.runUntilIdle(1000000));
+    CHECK(robot.getSteps().getVal(0) == axis0Stop);
+    CHECK(robot.getSteps().getVal(1) == axis1Stop);
+    CHECK(HostHal::countRisingEdges(HostRobot::AXIS0_STEP_PIN) == uint32_t(axis0Stop));
+    CHECK(HostHal::countRisingEdges(HostRobot::AXIS1_STEP_PIN) == uint32_t(axis1Stop));
+}
+
+int main()
+{
+    checkEachAxisStops();
+
+    // Start with both axes on their end-stops, with neither and with each on its own - both
+    // sequences end with the arm just past the theta sensor and rho just inside the centre sensor
+    // and the README sequence, which has one move fewer, takes about as long
+    const int32_t starts[][2] = {
+        {THETA_SENSOR_START + 100, RHO_SENSOR_START / 2},
+        {THETA_SENSOR_START + 20000, 4000},
+        {THETA_SENSOR_START + 100, 4000},
+        {THETA_SENSOR_START - 5000, -100},
+    };
+    for (auto& start : starts)
+    {
+        // Rho of the start position is given relative to the rotation
+        int32_t startSteps1 = start[1] + int32_t(int64_t(start[0]) * RHO_STEPS_PER_ROT_OF_THETA / THETA_STEPS_PER_ROT);
+        double builtInSecs = 0;
+        for (const char* homingSeq : {BUILT_IN_HOMING_SEQ, README_HOMING_SEQ})
+        {
+            int32_t endSteps0 = 0, endSteps1 = 0;
+            double homingSecs = 0;
+            CHECK(homeTable(homingSeq, start[0], startSteps1, endSteps0, endSteps1, homingSecs));
+            printf("start theta %d rho %d: %s seq homed in %.2fs, theta %d rho %d\n", start[0], start[1],
+                   homingSeq == README_HOMING_SEQ ? "README" : "built-in", homingSecs, thetaOf(endSteps0),
+                   rhoOf(endSteps0, endSteps1));
+            CHECK_NEAR(thetaOf(endSteps0), THETA_SENSOR_START + 200, 3);
+            CHECK_NEAR(rhoOf(endSteps0, endSteps1), -340, 3);
+            if (homingSeq == BUILT_IN_HOMING_SEQ)
+                builtInSecs = homingSecs;
+            else
+                CHECK(homingSecs < builtInSecs * 1.1);
+        }
+    }
+    return hostTestResult("test_homing_multi_axis");
+}
@@ -0,0 +1,171 @@
+// RBotFirmware host build
+// Homing sequence compiler - errors are reported with their position - and two-speed seeks on
+// simulated end-stops: the latch keeps the end-stop checks of the other axes in the move and
+// homing fails if the seek or the latch ends without reaching its end-stop
+
+#include "HostTest.h"
+
+static std::string homingConfig(const char* homingSeq)
+{
+    std::string seqStr = std::string("\"homingSeq\":\"") + homingSeq + "\"";
+    return HostRobot::getConfig("TranquilSmall", {{"\"homingSeq\":\"FR3;A+38400n;B+3200;#;A+38400N;B+3200;#;"
+                                                   "A+200;#B+400;#;B+30000n;#;B-30000N;#;B-340;#;A=h;B=h;$\"",
+                                                   seqStr.c_str()}});
+}
+
+// Compile a sequence and check the number of instructions or the error and its position
+static void checkCompile(const char* homingSeq, int instrs, const char* err = NULL, int errPos = 0)
+{
+    HostRobot robot;
+    CHECK(robot.init(homingConfig(homingSeq)));
+    String homingStr;
+    robot._robotController.homingStatus(homingStr);
+    bool compiledOk = homingStr.indexOf("\"err\"") < 0;
+    if (compiledOk != (err == NULL))
+        printf("%s: %s\n", homingSeq, homingStr.c_str());
+    CHECK(compiledOk == (err == NULL));
+    if (err)
+    {
+        CHECK(homingStr.indexOf(err) >= 0);
+        CHECK(RdJson::getLong("errPos", -1, homingStr.c_str()) == errPos);
+
+        // Homing doesn't start
+        CHECK(robot.gcode("G28"));
+        robot.run(10000, 100);
+        robot._robotController.homingStatus(homingStr);
+        CHECK(RdJson::getLong("homing", 1, homingStr.c_str()) == 0);
+        return;
+    }
+    CHECK(RdJson::getLong("instrs", 0, homingStr.c_str()) == instrs);
+}
+
+// Simulated end-stops - each is hit when its axis is at or past a position (the seeks are
+// in the positive direction) and a faulty one only works until it is first released
+struct SimEndStops
+{
+    int32_t _hitPos[2];
+    bool _faulty[2];
+    bool _released[2];
+};
+
+// Home with end-stops simulated from the step position - the sequences don't set home so the
+// position is the robot's step count - returns whether homing succeeded
+static bool runHoming(HostRobot& robot, SimEndStops& endStops, double& homingSecs)
+{
+    CHECK(robot.gcode("G28"));
+    uint64_t startNs = HostHal::nowNs();
+    bool homingStarted = false;
+    bool wasHit[2] = {false, false};
+    for (int i = 0; i < 1000000; i++)
+    {
+        for (int j = 0; j < 10; j++)
+        {
+            AxisInt32s steps = robot.getSteps();
+            for (int axisIdx = 0; axisIdx < 2; axisIdx++)
+            {
+                bool hit = steps.getVal(axisIdx) >= endStops._hitPos[axisIdx];
+                if (wasHit[axisIdx] && !hit)
+                    endStops._released[axisIdx] = true;
+                wasHit[axisIdx] = hit;
+                robot.setEndStop(axisIdx, hit && !(endStops._faulty[axisIdx] && endStops._released[axisIdx]));
+            }
+            robot.run(100, 100);
+        }
+        String homingStr;
+        robot._robotController.homingStatus(homingStr);
+        bool homing = RdJson::getLong("homing", 0, homingStr.c_str()) != 0;
+        homingStarted |= homing;
+        if (homingStarted && !homing)
+        {
+            homingSecs = (HostHal::nowNs() - startNs) / 1e9;
+            return RdJson::getLong("homed", 0, homingStr.c_str()) != 0;
+        }
+    }
+    return false;
+}
+
+int main()
+{
+    // Built-in sequence and two-speed seeks (a seek becomes three moves)
+    checkCompile("FR3;A+38400n;B+3200;#;A+38400N;B+3200;#;A+200;#B+400;#;B+30000n;#;B-30000N;#;B-340;#;A=h;B=h;$", 10);
+    checkCompile("A+1000N/100;#;A=h;$", 5);
+    checkCompile("FS2000;A+20000N/400S50;B+20000N;#;$", 4);
+
+    // Steps can be left out
+    checkCompile("AN;#;B;#;$", 3);
+
+    // Errors and their positions
+    checkCompile("A+100;$", 0, "move without #", 6);
+    checkCompile("A+100;#", 0, "missing $ at end", 7);
+    checkCompile("A+100;#;$;B+1", 0, "text after $", 10);
+    checkCompile("A+100N/0;#;$", 0, "back-off steps must be positive", 7);
+    checkCompile("A+100n/400;#;$", 0, "back-off needs an end-stop hit check", 6);
+    if (RobotConsts::MAX_AXES < 3)
+        checkCompile("C+100;#;$", 0, "axis not in this build", 0);
+    else
+        checkCompile("C+100;#;$", 2);
+    checkCompile("FR0;A+1;#;$", 0, "F needs R or S and a positive rate", 0);
+    checkCompile("A+100S0;#;$", 0, "rate must be positive", 5);
+    checkCompile("A+100?;#;$", 0, "unexpected character", 5);
+    checkCompile("A+100;B+100;A+5;#;$", 0, "axis repeated in move", 12);
+    checkCompile("#;$", 0, "# without a move", 0);
+
+    // Two-speed seek - the latch is slow and stops at the end-stop
+    {
+        HostRobot robot;
+        CHECK(robot.init(homingConfig("FS2000;A+20000N/400;#;$")));
+        SimEndStops endStops = {{5000, 100000}, {false, false}, {false, false}};
+        double homingSecs = 0;
+        CHECK(runHoming(robot, endStops, homingSecs));
+        CHECK_NEAR(robot.getSteps().getVal(0), 5000, 1);
+        printf("two-speed seek: homed in %.2fs at %d\n", homingSecs, robot.getSteps().getVal(0));
+        // Fast seek of 5000 steps at 2000 steps/s then 400 steps at 200 steps/s
+        CHECK(homingSecs > 2.5 + 2.0);
+    }
+
+    // Another axis checking its own end-stop in the move stops at it in the seek and the latch
+    {
+        HostRobot robot;
+        CHECK(robot.init(homingConfig("FS2000;A+20000N/400;B+20000N;#;$")));
+        SimEndStops endStops = {{5000, 3000}, {false, false}, {false, false}};
+        double homingSecs = 0;
+        CHECK(runHoming(robot, endStops, homingSecs));
+        CHECK_NEAR(robot.getSteps().getVal(0), 5000, 1);
+        CHECK_NEAR(robot.getSteps().getVal(1), 3000, 1);
+    }
+
+    // Seek which runs out of steps before the end-stop - homing fails without backing off
+    {
+        HostRobot robot;
+        CHECK(robot.init(homingConfig("FS2000;A+3000N/400;#;$")));
+        SimEndStops endStops = {{5000, 100000}, {false, false}, {false, false}};
+        double homingSecs = 0;
+        CHECK(!runHoming(robot, endStops, homingSecs));
+        CHECK(robot.getSteps().getVal(0) == 3000);
+    }
+
+    // End-stop which stops working after the seek - the latch runs out of steps and homing fails
+    // while the other axis in the move still stops at its own end-stop (rather than carrying on
+    // for the latch's steps)
+    {
+        HostRobot robot;
+        CHECK(robot.init(homingConfig("FS2000;A+20000N/400;B+20000N;#;$")));
+        SimEndStops endStops = {{5000, 3000}, {true, false}, {false, false}};
+        double homingSecs = 0;
+        CHECK(!runHoming(robot, endStops, homingSecs));
+        CHECK_NEAR(robot.getSteps().getVal(0), 5000 - 400 + 800, 1);
+        CHECK_NEAR(robot.getSteps().getVal(1), 3000, 1);
+    }
+
+    // Steps left out are the default distance (more than a turn of the arm)
+    {
+        HostRobot robot;
+        CHECK(robot.init(homingConfig("FS2000;AN;#;$")));
+        SimEndStops endStops = {{60000, 100000}, {false, false}, {false, false}};
+        double homingSecs = 0;
+        CHECK(runHoming(robot, endStops, homingSecs));
+        CHECK_NEAR(robot.getSteps().getVal(0), 60000, 1);
+    }
+
+    return hostTestResult("test_homing_sequence");
+}
@@ -0,0 +1,100 @@
+// RBotFirmware host build
+// Input shaping - the residual vibration of a simulated arm (a damped second order system
+// driven by the physical steps of the rotary axis) after a move is much lower with a ZVD shaper
+// on TranquilLarge (which ships with shaping off) than without shaping, at the shaper's frequency
+// and with the arm's frequency 20% out
+
+#include "HostTest.h"
+
+static const float SHAPER_FREQ_HZ = 8;
+static const float SHAPER_DAMPING = 0.1f;
+static const uint64_t SIM_STEP_NS = 10000;
+static const uint64_t SETTLE_NS = 2000000000;
+// Shaped steps continue for up to a period of the resonance after the commanded motion
+static const uint64_t SHAPED_TAIL_US = 500000;
+
+// Physical position of axis 0 (steps) at each of its steps from the pin log - the direction
+// pin level for positive steps is given
+static std::vector<std::pair<uint64_t, int32_t>> axis0Steps(bool posLevel)
+{
+    std::vector<std::pair<uint64_t, int32_t>> steps;
+    bool dirnLevel = posLevel;
+    int32_t pos = 0;
+    for (const HostHal::PinEvent& ev : HostHal::pinEvents())
+    {
+        if (ev._pin == HostRobot::AXIS0_DIRN_PIN)
+            dirnLevel = ev._level;
+        else if ((ev._pin == HostRobot::AXIS0_STEP_PIN) && ev._level)
+        {
+            pos += (dirnLevel == posLevel) ? 1 : -1;
+            steps.push_back({ev._timeNs, pos});
+        }
+    }
+    return steps;
+}
+
+// Largest distance (steps) of the arm from the final position after the motor stops - the
+// arm is x'' + 2 zeta w x' + w^2 x = w^2 u where u is the motor position
+static double residualVibration(const std::vector<std::pair<uint64_t, int32_t>>& steps, float freqHz)
+{
+    double omega = 2 * M_PI * freqHz;
+    double dt = SIM_STEP_NS / 1e9;
+    double x = 0, v = 0;
+    int32_t u = 0;
+    size_t stepIdx = 0;
+    uint64_t endNs = steps.back().first + SETTLE_NS;
+    double residual = 0;
+    for (uint64_t t = steps.front().first; t < endNs; t += SIM_STEP_NS)
+    {
+        while ((stepIdx < steps.size()) && (steps[stepIdx].first <= t))
+            u = steps[stepIdx++].second;
+        double acc = omega * omega * (u - x) - 2 * SHAPER_DAMPING * omega * v;
+        v += acc * dt;
+        x += v * dt;
+        if (t > steps.back().first)
+            residual = std::max(residual, fabs(x - steps.back().second));
+    }
+    return residual;
+}
+
+// Move axis 0 of TranquilLarge with or without a shaper and simulate arms with the
+// shaper's frequency scaled by each of the factors - the acceleration is raised so the
+// vibration is well above the size of a step
+static void moveAndSimulate(bool shaped, const float* freqFactors, int numFreqs, double* residuals)
+{
+    HostRobot robot;
+    const char* ACC_SETTING = "\"maxSpeed\":15,\"maxAcc\":10";
+    const char* FAST_ACC_SETTING = "\"maxSpeed\":15,\"maxAcc\":300";
+    CHECK(robot.init(HostRobot::getConfig("TranquilLarge", {{ACC_SETTING, FAST_ACC_SETTING},
+                {"\"shaper\":\"none\",\"shaperFreqHz\":0", shaped ? "\"shaper\":\"zvd\",\"shaperFreqHz\":8" :
+                                                                   "\"shaper\":\"none\",\"shaperFreqHz\":0"}})));
+    robot.moveSteps(10, 0);
+    CHECK(robot.runUntilIdle(10000000));
+    robot.run(SHAPED_TAIL_US);
+    bool posLevel = HostHal::getLevel(HostRobot::AXIS0_DIRN_PIN);
+    HostHal::clearLogs();
+    robot.moveSteps(3000, 0);
+    CHECK(robot.runUntilIdle(60000000));
+    robot.run(SHAPED_TAIL_US);
+    std::vector<std::pair<uint64_t, int32_t>> steps = axis0Steps(posLevel);
+    CHECK(steps.size() == 3000);
+    CHECK(!steps.empty() && (steps.back().second == 3000));
+    for (int i = 0; i < numFreqs; i++)
+        residuals[i] = steps.empty() ? 0 : residualVibration(steps, SHAPER_FREQ_HZ * freqFactors[i]);
+}
+
+int main()
+{
+    const float freqFactors[] = {0.8f, 1.0f, 1.2f};
+    const int numFreqs = sizeof(freqFactors) / sizeof(freqFactors[0]);
+    double unshaped[numFreqs], shaped[numFreqs];
+    moveAndSimulate(false, freqFactors, numFreqs, unshaped);
+    moveAndSimulate(true, freqFactors, numFreqs, shaped);
+    for (int i = 0; i < numFreqs; i++)
+    {
+        printf("arm %.1fHz: residual vibration unshaped %.3f steps, ZVD %.3f steps (%.1f%%)\n",
+               SHAPER_FREQ_HZ * freqFactors[i], unshaped[i], shaped[i], shaped[i] / unshaped[i] * 100);
+        CHECK(shaped[i] < unshaped[i] * (freqFactors[i] == 1.0f ? 0.1 : 0.3));
+    }
+    return hostTestResult("test_input_shaper");
+}
@@ -0,0 +1,41 @@
+// RBotFirmware host build
+// Step rate change limit at junctions - a straight line split into short blocks (where rounding
+// each block to whole steps changes the step rates a lot) is not slowed by the limit, which is
+// found from the unrounded steps, while a gentle (10 degree) corner which junction deviation
+// alone would take faster is slowed - and the limit can be turned off
+
+#include "HostTest.h"
+
+// Time to draw a path with short blocks and the ball free to go faster than axis0 maxSpeed
+static double pathSecs(const char* junctionMaxRateChange, const float (*pts)[2], int numPts)
+{
+    char settingsStr[200];
+    snprintf(settingsStr, sizeof(settingsStr),
+             "\"blockDistanceMM\":0.2,\"actuatorLimits\":1,\"pathSpeed\":40,\"junctionMaxRateChange\":%s",
+             junctionMaxRateChange);
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall", {{"\"blockDistanceMM\":1", settingsStr}})));
+    CHECK(robot.moveTo(pts[0][0], pts[0][1]));
+    CHECK(robot.runUntilIdle(60000000, 100));
+    uint64_t startNs = HostHal::nowNs();
+    for (int i = 1; i < numPts; i++)
+        CHECK(robot.moveTo(pts[i][0], pts[i][1]));
+    CHECK(robot.runUntilIdle(120000000, 100));
+    return (HostHal::nowNs() - startNs) / 1e9;
+}
+
+int main()
+{
+    const float line[][2] = {{-100, 100}, {100, 100}};
+    double lineSecs = pathSecs("0.05", line, 2);
+    double lineNoLimitSecs = pathSecs("0", line, 2);
+    // Turning 10 degrees changes the rotary step rate by about 10 steps/s per mm/s
+    const float corner[][2] = {{-100, 100}, {0, 100}, {100, 82.4f}};
+    double cornerSecs = pathSecs("0.05", corner, 3);
+    double cornerNoLimitSecs = pathSecs("0", corner, 3);
+    printf("line: %.3fs (no limit %.3fs), corner: %.3fs (no limit %.3fs)\n", lineSecs, lineNoLimitSecs,
+           cornerSecs, cornerNoLimitSecs);
+    CHECK(lineSecs < lineNoLimitSecs * 1.02);
+    CHECK(cornerSecs > cornerNoLimitSecs * 1.02);
+    return hostTestResult("test_junction_rate_change");
+}
@@ -0,0 +1,101 @@
+// RBotFirmware host build
+// Full stops while drawing a pattern - moves (which can each be split into blocks) streamed as
+// G-code run without stopping between them - measured both from the step pins and by the ramp
+// generator's followedStops count
+
+#include "HostTest.h"
+
+// Full stops from the step pins - gaps with no steps on either axis which are longer than the
+// gaps seen while moving at the minimum step rate (and slowly on one axis near the start and
+// end of a move)
+static const uint64_t STOP_MIN_GAP_NS = 50000000;
+
+static int countPinStops()
+{
+    int numStops = 0;
+    uint64_t lastStepNs = 0;
+    for (const HostHal::PinEvent& ev : HostHal::pinEvents())
+    {
+        if (!ev._level || ((ev._pin != HostRobot::AXIS0_STEP_PIN) && (ev._pin != HostRobot::AXIS1_STEP_PIN)))
+            continue;
+        if ((lastStepNs != 0) && (ev._timeNs - lastStepNs >= STOP_MIN_GAP_NS))
+            numStops++;
+        lastStepNs = ev._timeNs;
+    }
+    return numStops;
+}
+
+// Draw a pattern of moves streamed as the work manager would - a command is sent whenever the
+// robot can accept one - optionally waiting for the robot to go idle part way through (with
+// work still queued) - returns the full stops counted from the pins and by the ramp generator
+static void drawPattern(const char* patternName, int numMoves, void (*moveDest)(int, float&, float&),
+                        int starveAfterMove, int& pinStops, int& followedStops)
+{
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall")));
+    float x = 0, y = 0;
+    moveDest(0, x, y);
+    CHECK(robot.moveTo(x, y));
+    CHECK(robot.runUntilIdle(60000000, 100));
+    String respStr;
+    robot._robotController.motionStats("reset", respStr);
+    HostHal::clearLogs();
+
+    int moveIdx = 0;
+    while (moveIdx < numMoves)
+    {
+        if (robot._robotController.canAcceptCommand())
+        {
+            moveIdx++;
+            moveDest(moveIdx, x, y);
+            robot._robotController.setWorkItemsQueued(moveIdx < numMoves);
+            char cmdStr[50];
+            snprintf(cmdStr, sizeof(cmdStr), "G1 X%.3f Y%.3f", x, y);
+            CHECK(robot.gcode(cmdStr));
+            if (moveIdx == starveAfterMove)
+                CHECK(robot.runUntilIdle(600000000, 100));
+        }
+        robot.run(1000, 100);
+    }
+    CHECK(robot.runUntilIdle(600000000, 100));
+
+    robot._robotController.motionStats("", respStr);
+    followedStops = RdJson::getLong("followedStops", -1, respStr.c_str());
+    pinStops = countPinStops();
+    printf("%s%s: %d moves, %u blocks, full stops %d (from pins), followedStops %d\n", patternName,
+           starveAfterMove > 0 ? " (starved)" : "", numMoves, robot.blocksPlanned(), pinStops, followedStops);
+}
+
+// Two laps of a 36 sided polygon (each ~7mm edge is split into blocks)
+static void polygonDest(int moveIdx, float& x, float& y)
+{
+    float angle = moveIdx * 2 * M_PI / 36;
+    x = 60 + 40 * cosf(angle);
+    y = 40 * sinf(angle);
+}
+
+// Flower with five petals drawn as 2 degree segments
+static void flowerDest(int moveIdx, float& x, float& y)
+{
+    float angle = moveIdx * 2 * M_PI / 180;
+    float rho = 30 + 10 * sinf(5 * angle);
+    x = 60 + rho * cosf(angle);
+    y = rho * sinf(angle);
+}
+
+int main()
+{
+    int pinStops = 0, followedStops = 0;
+    drawPattern("polygon", 72, polygonDest, 0, pinStops, followedStops);
+    CHECK(pinStops == 0);
+    CHECK(followedStops == 0);
+    drawPattern("flower", 180, flowerDest, 0, pinStops, followedStops);
+    CHECK(pinStops == 0);
+    CHECK(followedStops == 0);
+
+    // Running out of moves part way through is one full stop by both measures
+    drawPattern("polygon", 72, polygonDest, 36, pinStops, followedStops);
+    CHECK(pinStops == 1);
+    CHECK(followedStops == 1);
+    return hostTestResult("test_pattern_stops");
+}
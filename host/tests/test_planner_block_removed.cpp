@@ -0,0 +1,72 @@
+// RBotFirmware host build
+// Blocks removed by the ISR while the planner recalculates - the oldest block is executing and
+// is removed just after the planner reads the pipeline count, and every block added (including
+// the last) must still be prepared so that it can execute
+
+#include "HostTest.h"
+#include "RobotMotion/MotionControl/MotionPlanner.h"
+
+static const char* AXES_CONFIG =
+    "{\"axis0\":{\"maxSpeed\":100,\"maxAcc\":100,\"stepsPerRot\":3200,\"unitsPerRot\":40},"
+    "\"axis1\":{\"maxSpeed\":100,\"maxAcc\":100,\"stepsPerRot\":3200,\"unitsPerRot\":40}}";
+
+// Add blocks along a path - before each add the oldest block is locked for execution and it is
+// removed during the add if removeDuringAdd is set - returns the number of blocks checked
+static int addBlocks(const float (*pts)[2], int numPts, bool removeDuringAdd)
+{
+    AxesParams axesParams;
+    String axisJSON;
+    for (int axisIdx = 0; axisIdx < 2; axisIdx++)
+        axesParams.configureAxis(AXES_CONFIG, axisIdx, axisJSON);
+    MotionPipeline motionPipeline;
+    motionPipeline.init(10);
+    MotionPlanner motionPlanner;
+    motionPlanner.configure(0.05f, 0.05f, false, 0);
+    AxisPosition curAxisPositions;
+
+    int numChecked = 0;
+    for (int ptIdx = 0; ptIdx < numPts; ptIdx++)
+    {
+        MotionBlock* pOldest = motionPipeline.peekGet();
+        if (pOldest)
+        {
+            pOldest->_isExecuting = true;
+            motionPipeline._testRemovesAfterCount = removeDuringAdd ? 1 : 0;
+        }
+        float x = pts[ptIdx][0], y = pts[ptIdx][1];
+        RobotCommandArgs args;
+        args.setAxisValMM(0, x, true);
+        args.setAxisValMM(1, y, true);
+        args.setMoreMovesComing(ptIdx + 1 < numPts);
+        AxisFloats actuatorCoords(x * axesParams.getStepsPerUnit(0), y * axesParams.getStepsPerUnit(1));
+        CHECK(motionPlanner.moveTo(args, actuatorCoords, curAxisPositions, axesParams, motionPipeline));
+        curAxisPositions._axisPositionMM = args.getPointMM();
+
+        // Every block not yet executing can execute and the newest stops at the end
+        for (unsigned int blockIdx = 0; blockIdx < motionPipeline.count(); blockIdx++)
+        {
+            MotionBlock* pBlock = motionPipeline.peekNthFromPut(blockIdx);
+            if (pBlock->isLocked())
+                continue;
+            CHECK(pBlock->_canExecute);
+            numChecked++;
+        }
+        CHECK(motionPipeline.peekNthFromPut(0)->_exitSpeedMMps == 0);
+    }
+    return numChecked;
+}
+
+int main()
+{
+    // A single block after the executing one, a straight line and a path with corners
+    const float one[][2] = {{10, 0}, {20, 0}};
+    const float line[][2] = {{1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0}, {7, 0}, {8, 0}};
+    const float corners[][2] = {{10, 0}, {10, 10}, {0, 10}, {0, 0}, {5, 5}, {10, 0}, {20, 0}};
+    for (bool removeDuringAdd : {false, true})
+    {
+        CHECK(addBlocks(one, 2, removeDuringAdd) > 0);
+        CHECK(addBlocks(line, 8, removeDuringAdd) > 0);
+        CHECK(addBlocks(corners, 7, removeDuringAdd) > 0);
+    }
+    return hostTestResult("test_planner_block_removed");
+}
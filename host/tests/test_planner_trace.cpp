@@ -0,0 +1,65 @@
+// RBotFirmware host build
+// Planner trace - executed blocks are recorded (keeping the most recent), requests are capped
+// at the maximum length and unknown commands are rejected
+
+#include "HostTest.h"
+
+static int countLines(const String& str)
+{
+    int numLines = 0;
+    for (unsigned i = 0; i < str.length(); i++)
+        if (str[i] == '\n')
+            numLines++;
+    return numLines;
+}
+
+int main()
+{
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall")));
+
+    // Record some stepwise blocks
+    String respStr;
+    robot._robotController.plannerTrace("start", 0, respStr);
+    CHECK(respStr.indexOf("ok") >= 0);
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(robot.moveSteps(100, -50));
+        CHECK(robot.runUntilIdle(10000000));
+    }
+    robot._robotController.plannerTrace("get", 0, respStr);
+    CHECK(respStr.startsWith("startUs,endUs,axisMax,followed,steps0,steps1,"));
+    CHECK(countLines(respStr) == 5 + 1);
+    CHECK(respStr.indexOf(",100,-50,") > 0);
+
+    // Recording continues after the CSV is got
+    CHECK(robot.moveSteps(10, 10));
+    CHECK(robot.runUntilIdle(10000000));
+    robot._robotController.plannerTrace("get", 0, respStr);
+    CHECK(countLines(respStr) == 6 + 1);
+
+    // Requests above the maximum are capped and the most recent blocks are kept
+    robot._robotController.plannerTrace("start", 100000, respStr);
+    const int numBlocks = MotionPlannerTrace::TRACE_LEN_MAX + 20;
+    for (int i = 0; i < numBlocks; i++)
+    {
+        CHECK(robot.runUntilCanAccept(10000000));
+        CHECK(robot.moveSteps(i + 1, 0));
+    }
+    CHECK(robot.runUntilIdle(600000000));
+    robot._robotController.plannerTrace("stop", 0, respStr);
+    CHECK(respStr.indexOf("ok") >= 0);
+    robot._robotController.plannerTrace("get", 0, respStr);
+    CHECK(countLines(respStr) == MotionPlannerTrace::TRACE_LEN_MAX + 1);
+    char lastBlockStr[20];
+    snprintf(lastBlockStr, sizeof(lastBlockStr), ",%d,0,", numBlocks);
+    CHECK(respStr.indexOf(lastBlockStr) > 0);
+    CHECK(respStr.indexOf(",1,0,") < 0);
+
+    // Unknown commands are errors rather than the CSV
+    robot._robotController.plannerTrace("dump", 0, respStr);
+    CHECK(respStr.indexOf("fail") >= 0);
+    CHECK(!respStr.startsWith("startUs"));
+
+    return hostTestResult("test_planner_trace");
+}
@@ -0,0 +1,68 @@
+// RBotFirmware host build
+// Native polar moves on a rotary table - a spiral sent as one polar move (as theta-rho lines
+// are) uses far fewer blocks than the same spiral as XY points and ends at the same steps
+
+#include <math.h>
+#include "HostTest.h"
+
+static const float SPIRAL_START_RHO_MM = 29;
+static const float SPIRAL_END_RHO_MM = 116;
+static const int SPIRAL_TURNS = 3;
+
+struct SpiralResult
+{
+    uint32_t _blocks;
+    double _secs;
+    AxisInt32s _endSteps;
+};
+
+static SpiralResult drawSpiral(bool polarNative)
+{
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall")));
+    char cmdStr[100];
+    snprintf(cmdStr, sizeof(cmdStr), "G0 X%.3f Y0", SPIRAL_START_RHO_MM);
+    CHECK(robot.gcode(cmdStr));
+    CHECK(robot.runUntilIdle(60000000, 100));
+
+    String respStr;
+    robot._robotController.motionStats("reset", respStr);
+    uint64_t startNs = HostHal::nowNs();
+    if (polarNative)
+    {
+        snprintf(cmdStr, sizeof(cmdStr), "G0 X%.3f Y0 W%d", SPIRAL_END_RHO_MM, SPIRAL_TURNS * 360);
+        CHECK(robot.gcode(cmdStr));
+    }
+    else
+    {
+        // Points every 2 degrees (as theta-rho lines were split before)
+        const int numPoints = SPIRAL_TURNS * 180;
+        for (int i = 1; i <= numPoints; i++)
+        {
+            float angle = i * 2 * M_PI / 180;
+            float rho = SPIRAL_START_RHO_MM + (SPIRAL_END_RHO_MM - SPIRAL_START_RHO_MM) * i / numPoints;
+            snprintf(cmdStr, sizeof(cmdStr), "G0 X%.3f Y%.3f", rho * cosf(angle), rho * sinf(angle));
+            CHECK(robot.runUntilCanAccept(10000000, 100));
+            CHECK(robot.gcode(cmdStr));
+        }
+    }
+    CHECK(robot.runUntilIdle(600000000, 100));
+    SpiralResult result;
+    result._blocks = robot.blocksPlanned();
+    result._secs = (HostHal::nowNs() - startNs) / 1e9 - 0.05;
+    result._endSteps = robot.getSteps();
+    return result;
+}
+
+int main()
+{
+    SpiralResult xyResult = drawSpiral(false);
+    SpiralResult polarResult = drawSpiral(true);
+    printf("%d turn spiral: XY points %u blocks %.1fs, polar move %u blocks %.1fs\n", SPIRAL_TURNS,
+           xyResult._blocks, xyResult._secs, polarResult._blocks, polarResult._secs);
+    CHECK(polarResult._blocks * 10 < xyResult._blocks);
+    CHECK(polarResult._secs < xyResult._secs * 1.02);
+    CHECK(abs(polarResult._endSteps.getVal(0) - xyResult._endSteps.getVal(0)) <= 1);
+    CHECK(abs(polarResult._endSteps.getVal(1) - xyResult._endSteps.getVal(1)) <= 1);
+    return hostTestResult("test_polar_native");
+}
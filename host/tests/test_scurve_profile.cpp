@@ -0,0 +1,59 @@
+// RBotFirmware host build
+// S-curve acceleration profile against the trapezoid - a stepwise move and a multi-block path
+// take no longer with the S-curve and it has a lower peak jerk
+
+#include "HostTest.h"
+
+static std::string profileConfig(const char* profile)
+{
+    std::string rampGenStr = std::string("\"rampGen\":{\"profile\":\"") + profile + "\"},\"blockDistanceMM\":1";
+    return HostRobot::getConfig("TranquilSmall", {{"\"blockDistanceMM\":1", rampGenStr.c_str()}});
+}
+
+// Time from the first to the last step of axis 1 for a stepwise move, and its peak jerk
+static void stepwiseMove(const char* profile, double& moveSecs, double& jerk)
+{
+    HostRobot robot;
+    CHECK(robot.init(profileConfig(profile)));
+    HostHal::clearLogs();
+    robot.moveSteps(0, 3000);
+    CHECK(robot.runUntilIdle(20000000));
+    CHECK(robot.getSteps().getVal(1) == 3000);
+    const uint64_t SAMPLE_NS = 1000000;
+    std::vector<double> posns = sampleStepPosition(HostRobot::AXIS1_STEP_PIN, SAMPLE_NS);
+    moveSecs = posns.size() * SAMPLE_NS / 1e9;
+    jerk = peakDerivative(posns, SAMPLE_NS / 1e9, 20, 3);
+}
+
+// Time taken to draw a path of many blocks
+static double pathSecs(const char* profile)
+{
+    HostRobot robot;
+    CHECK(robot.init(profileConfig(profile)));
+    uint64_t startNs = HostHal::nowNs();
+    for (int i = 0; i <= 40; i++)
+    {
+        robot.moveTo(20 + 40 * sinf(i * 0.3f), 30 * cosf(i * 0.2f));
+        robot.run(2000, 100);
+    }
+    CHECK(robot.runUntilIdle(120000000, 100));
+    return (HostHal::nowNs() - startNs) / 1e9;
+}
+
+int main()
+{
+    double trapSecs = 0, trapJerk = 0, sCurveSecs = 0, sCurveJerk = 0;
+    stepwiseMove("trapezoid", trapSecs, trapJerk);
+    stepwiseMove("sCurve", sCurveSecs, sCurveJerk);
+    printf("stepwise move: trapezoid %.3fs peak jerk %.0f steps/s^3, sCurve %.3fs peak jerk %.0f steps/s^3\n",
+           trapSecs, trapJerk, sCurveSecs, sCurveJerk);
+    CHECK(sCurveSecs < trapSecs * 1.02);
+    CHECK(sCurveJerk < trapJerk * 0.6);
+
+    double trapPathSecs = pathSecs("trapezoid");
+    double sCurvePathSecs = pathSecs("sCurve");
+    printf("path: trapezoid %.3fs, sCurve %.3fs\n", trapPathSecs, sCurvePathSecs);
+    CHECK(sCurvePathSecs < trapPathSecs * 1.02);
+
+    return hostTestResult("test_scurve_profile");
+}
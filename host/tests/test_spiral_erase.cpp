@@ -0,0 +1,71 @@
+// RBotFirmware host build
+// Full-table spiral erase on a rotary table - a single G3 spiral against the same spiral as
+// XY points every 2 degrees (as theta-rho files are drawn), comparing draw time and blocks
+
+#include "HostTest.h"
+
+// Spiral from rho 1mm to 195mm over 24 turns (8mm pitch)
+static const float SPIRAL_START_RHO_MM = 1;
+static const float SPIRAL_END_RHO_MM = 195;
+static const int SPIRAL_TURNS = 24;
+
+struct SpiralResult
+{
+    int _cmds;
+    uint32_t _blocks;
+    double _secs;
+    AxisInt32s _endSteps;
+};
+
+static SpiralResult drawSpiral(bool arc)
+{
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilLarge")));
+    char cmdStr[100];
+    snprintf(cmdStr, sizeof(cmdStr), "G0 X%.3f Y0", SPIRAL_START_RHO_MM);
+    CHECK(robot.gcode(cmdStr));
+    CHECK(robot.runUntilIdle(60000000, 100));
+
+    String respStr;
+    robot._robotController.motionStats("reset", respStr);
+    uint64_t startNs = HostHal::nowNs();
+    SpiralResult result;
+    result._cmds = 0;
+    if (arc)
+    {
+        snprintf(cmdStr, sizeof(cmdStr), "G3 X%.3f Y0 I%.3f J0 P%d", SPIRAL_END_RHO_MM, -SPIRAL_START_RHO_MM, SPIRAL_TURNS);
+        CHECK(robot.gcode(cmdStr));
+        result._cmds = 1;
+    }
+    else
+    {
+        const int numPoints = SPIRAL_TURNS * 180;
+        for (int i = 1; i <= numPoints; i++)
+        {
+            float angle = i * 2 * M_PI / 180;
+            float rho = SPIRAL_START_RHO_MM + (SPIRAL_END_RHO_MM - SPIRAL_START_RHO_MM) * i / numPoints;
+            snprintf(cmdStr, sizeof(cmdStr), "G0 X%.3f Y%.3f", rho * cosf(angle), rho * sinf(angle));
+            CHECK(robot.runUntilCanAccept(10000000, 100));
+            CHECK(robot.gcode(cmdStr));
+            result._cmds++;
+        }
+    }
+    CHECK(robot.runUntilIdle(2000000000, 100));
+    result._blocks = robot.blocksPlanned();
+    result._secs = (HostHal::nowNs() - startNs) / 1e9 - 0.05;
+    result._endSteps = robot.getSteps();
+    return result;
+}
+
+int main()
+{
+    SpiralResult xyResult = drawSpiral(false);
+    SpiralResult arcResult = drawSpiral(true);
+    printf("THR points as XY lines: %d cmds, %u blocks, %.1fs\n", xyResult._cmds, xyResult._blocks, xyResult._secs);
+    printf("single G3 spiral:       %d cmd, %u blocks, %.1fs\n", arcResult._cmds, arcResult._blocks, arcResult._secs);
+    CHECK(arcResult._blocks * 10 < xyResult._blocks);
+    CHECK(arcResult._secs < xyResult._secs * 1.02);
+    CHECK(abs(arcResult._endSteps.getVal(0) - xyResult._endSteps.getVal(0)) <= 1);
+    CHECK(abs(arcResult._endSteps.getVal(1) - xyResult._endSteps.getVal(1)) <= 1);
+    return hostTestResult("test_spiral_erase");
+}
@@ -0,0 +1,54 @@
+// RBotFirmware host build
+// Step events mode - an end-stop hit while the block is still being compiled ends the block
+// without the compiler touching a block that has been removed, and later moves are exact
+
+#include "HostTest.h"
+
+static void checkEndStopMidCompile(const char* modeStr)
+{
+    char rampGenStr[120];
+    snprintf(rampGenStr, sizeof(rampGenStr),
+             "\"rampGen\":{\"mode\":\"%s\",\"stepCmdQueueLen\":16},\"pipelineLen\":3,\"blockDistanceMM\":1", modeStr);
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall", {{"\"blockDistanceMM\":1", rampGenStr}})));
+
+    // Long move which stops at the axis 1 end-stop followed by moves which don't check it - the
+    // pipeline is short so the slot of the block ended by the end-stop is soon reused
+    // Services are 2ms apart so the long block is still being compiled when the end-stop is hit
+    robot.moveSteps(0, 400000, 1);
+    for (int i = 0; i < 4; i++)
+        robot.moveSteps(25, 25);
+    robot.run(100000, 2000);
+    int32_t stepsBeforeHit = robot.getSteps().getVal(1);
+    CHECK(stepsBeforeHit > 0);
+    robot.setEndStop(1, true);
+    robot.run(4000, 2000);
+    robot.setEndStop(1, false);
+    CHECK(robot.runUntilIdle(10000000));
+
+    // The following moves are complete - their commands weren't discarded with the first block's
+    CHECK(robot.getSteps().getVal(0) == 100);
+    CHECK(HostHal::countRisingEdges(HostRobot::AXIS0_STEP_PIN) == 100);
+    CHECK(robot.getSteps().getVal(1) < 400000);
+    CHECK((int32_t)HostHal::countRisingEdges(HostRobot::AXIS1_STEP_PIN) == robot.getSteps().getVal(1));
+
+    // Moves after the hit are exact
+    for (int i = 0; i < 5; i++)
+    {
+        AxisInt32s startSteps = robot.getSteps();
+        HostHal::clearLogs();
+        robot.moveSteps(400 + i * 77, -(250 + i * 31));
+        CHECK(robot.runUntilIdle(10000000));
+        CHECK(robot.getSteps().getVal(0) - startSteps.getVal(0) == 400 + i * 77);
+        CHECK(robot.getSteps().getVal(1) - startSteps.getVal(1) == -(250 + i * 31));
+        CHECK((int)HostHal::countRisingEdges(HostRobot::AXIS0_STEP_PIN) == 400 + i * 77);
+        CHECK((int)HostHal::countRisingEdges(HostRobot::AXIS1_STEP_PIN) == 250 + i * 31);
+    }
+}
+
+int main()
+{
+    checkEndStopMidCompile("stepEvents");
+    checkEndStopMidCompile("stepTimer");
+    return hostTestResult("test_step_compiler_endstop");
+}
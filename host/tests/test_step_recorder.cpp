@@ -0,0 +1,69 @@
+// RBotFirmware host build
+// Step recorder - recorded steps match the step pins, recording stops before the buffer is
+// read and unknown commands are rejected
+
+#include "HostTest.h"
+
+static int countEvents(const String& csvStr, const char* eventName, int axisIdx)
+{
+    char lineStart[30];
+    snprintf(lineStart, sizeof(lineStart), ",%s,%d,", eventName, axisIdx);
+    int count = 0;
+    int pos = 0;
+    while ((pos = csvStr.indexOf(lineStart, pos)) >= 0)
+    {
+        count++;
+        pos++;
+    }
+    return count;
+}
+
+int main()
+{
+    HostRobot robot;
+    CHECK(robot.init(HostRobot::getConfig("TranquilSmall")));
+
+    // Record a stepwise move and compare with the step pins
+    String respStr;
+    robot._robotController.stepRecorder("start", 1000, respStr);
+    CHECK(respStr.indexOf("ok") >= 0);
+    HostHal::clearLogs();
+    robot.moveSteps(300, -120);
+    CHECK(robot.runUntilIdle(10000000));
+    CHECK(robot.getSteps().getVal(0) == 300);
+    CHECK(robot.getSteps().getVal(1) == -120);
+    robot._robotController.stepRecorder("get", 0, respStr);
+    CHECK(respStr.startsWith("tick,event,axis,val\n"));
+    CHECK(countEvents(respStr, "step", 0) == 300);
+    CHECK(countEvents(respStr, "step", 1) == 120);
+    CHECK(HostHal::countRisingEdges(HostRobot::AXIS0_STEP_PIN) == 300);
+    CHECK(HostHal::countRisingEdges(HostRobot::AXIS1_STEP_PIN) == 120);
+    CHECK(countEvents(respStr, "blkStart", 0) == 1);
+
+    // Getting the record stops recording so the buffer isn't changed while it is read
+    int csvLen = respStr.length();
+    robot.moveSteps(50, 0);
+    CHECK(robot.runUntilIdle(10000000));
+    robot._robotController.stepRecorder("get", 0, respStr);
+    CHECK((int)respStr.length() == csvLen);
+
+    // Requests above the maximum are capped
+    robot._robotController.stepRecorder("start", 1000000, respStr);
+    robot.moveSteps(3000, 0);
+    CHECK(robot.runUntilIdle(60000000));
+    robot._robotController.stepRecorder("stop", 0, respStr);
+    CHECK(respStr.indexOf("ok") >= 0);
+    robot._robotController.stepRecorder("get", 0, respStr);
+    int numLines = 0;
+    for (unsigned i = 0; i < respStr.length(); i++)
+        if (respStr[i] == '\n')
+            numLines++;
+    CHECK(numLines == MotionStepRecorder::STEP_RECORDER_LEN_MAX + 1);
+
+    // Unknown commands are errors rather than the CSV
+    robot._robotController.stepRecorder("dump", 0, respStr);
+    CHECK(respStr.indexOf("fail") >= 0);
+    CHECK(!respStr.startsWith("tick"));
+
+    return hostTestResult("test_step_recorder");
+}
@@ -0,0 +1,112 @@
+// RBotFirmware host build
+// Stepwise moves (homing moves and G6) ramp - they start and end stationary and each axis keeps
+// within its own max step rate and acceleration, scaled by its share of the steps - with both the
+// trapezoid and S-curve profiles
+
+#include "HostTest.h"
+
+// TranquilSmall limits in steps/s and steps/s^2 (maxRPM * stepsPerRot / 60 and that rate scaled
+// by maxAcc / maxSpeed)
+static const double AXIS0_MAX_STEP_RATE = 4 * 38400 / 60.0;
+static const double AXIS0_MAX_STEP_ACC = AXIS0_MAX_STEP_RATE * 25 / 15;
+static const double AXIS1_MAX_STEP_RATE = 30 * 3200 / 60.0;
+static const double AXIS1_MAX_STEP_ACC = AXIS1_MAX_STEP_RATE * 25 / 15;
+
+// The S-curve ramps take the same time as the trapezoid so its peak acceleration is higher
+static const double S_CURVE_PEAK_ACC_RATIO = 1.875;
+
+static const uint64_t SAMPLE_NS = 1000000;
+
+static std::string profileConfig(const char* profile)
+{
+    std::string rampGenStr = std::string("\"rampGen\":{\"profile\":\"") + profile + "\"},\"blockDistanceMM\":1";
+    return HostRobot::getConfig("TranquilSmall", {{"\"blockDistanceMM\":1", rampGenStr.c_str()}});
+}
+
+// Time between the first two and the last two steps of an axis
+static void endStepIntervals(int stepPin, double& firstSecs, double& lastSecs)
+{
+    std::vector<uint64_t> stepTimesNs;
+    for (const HostHal::PinEvent& ev : HostHal::pinEvents())
+        if ((ev._pin == stepPin) && ev._level)
+            stepTimesNs.push_back(ev._timeNs);
+    firstSecs = 0;
+    lastSecs = 0;
+    if (stepTimesNs.size() < 2)
+        return;
+    firstSecs = (stepTimesNs[1] - stepTimesNs[0]) / 1e9;
+    lastSecs = (stepTimesNs.back() - stepTimesNs[stepTimesNs.size() - 2]) / 1e9;
+}
+
+// Stepwise move with no feedrate limit of its own - the axes' limits apply - checking each axis
+// against its expected peak rate and its acceleration limit
+static void checkMove(const char* profile, int32_t steps0, int32_t steps1,
+                      double expRate0, double expRate1, double& moveSecs)
+{
+    double accRatio = (strcmp(profile, "sCurve") == 0) ? S_CURVE_PEAK_ACC_RATIO : 1;
+    HostRobot robot;
+    CHECK(robot.init(profileConfig(profile)));
+    HostHal::clearLogs();
+    RobotCommandArgs args;
+    args.setAxisSteps(0, steps0, true);
+    args.setAxisSteps(1, steps1, true);
+    args.setMoveType(RobotMoveTypeArg_Relative);
+    args.setFeedrate(100000);
+    CHECK(robot._robotController.moveTo(args));
+    CHECK(robot.runUntilIdle(20000000));
+    CHECK(robot.getSteps().getVal(0) == steps0);
+    CHECK(robot.getSteps().getVal(1) == steps1);
+
+    const int stepPins[2] = {HostRobot::AXIS0_STEP_PIN, HostRobot::AXIS1_STEP_PIN};
+    const double expRates[2] = {expRate0, expRate1};
+    const double maxAccs[2] = {AXIS0_MAX_STEP_ACC, AXIS1_MAX_STEP_ACC};
+    moveSecs = 0;
+    for (int axisIdx = 0; axisIdx < 2; axisIdx++)
+    {
+        if (expRates[axisIdx] == 0)
+        {
+            CHECK(HostHal::countRisingEdges(stepPins[axisIdx]) == 0);
+            continue;
+        }
+        std::vector<double> posns = sampleStepPosition(stepPins[axisIdx], SAMPLE_NS);
+        moveSecs = std::max(moveSecs, posns.size() * SAMPLE_NS / 1e9);
+        double rate = peakDerivative(posns, SAMPLE_NS / 1e9, 20, 1);
+        double acc = peakDerivative(posns, SAMPLE_NS / 1e9, 100, 2);
+        double firstSecs = 0, lastSecs = 0;
+        endStepIntervals(stepPins[axisIdx], firstSecs, lastSecs);
+        printf("%s move %d,%d axis %d: peak rate %.0f steps/s (expected %.0f), peak acc %.0f steps/s^2 "
+               "(limit %.0f), first step %.1fms, last step %.1fms\n",
+               profile, steps0, steps1, axisIdx, rate, expRates[axisIdx], acc, maxAccs[axisIdx] * accRatio,
+               firstSecs * 1000, lastSecs * 1000);
+
+        // Reaches the expected rate without exceeding it or the acceleration limit - steps are
+        // timed in 20us ticks so the rate reached is a few percent under the expected one
+        CHECK(rate < expRates[axisIdx] * 1.01);
+        CHECK(rate > expRates[axisIdx] * 0.93);
+        CHECK(acc < maxAccs[axisIdx] * accRatio * 1.1);
+
+        // Starts and ends stationary - the end steps take many times longer than at full speed
+        CHECK(firstSecs > 5 / expRates[axisIdx]);
+        CHECK(lastSecs > 5 / expRates[axisIdx]);
+    }
+}
+
+int main()
+{
+    for (const char* profile : {"trapezoid", "sCurve"})
+    {
+        // Axis 0 has twice the steps of axis 1 and is limited by its own rate
+        double moveSecs = 0;
+        checkMove(profile, 6000, 3000, AXIS0_MAX_STEP_RATE, AXIS0_MAX_STEP_RATE / 2, moveSecs);
+
+        // Axis 1 has nearly as many steps as axis 0 and its rate limits both
+        checkMove(profile, 6000, 5000, AXIS1_MAX_STEP_RATE * 6 / 5, AXIS1_MAX_STEP_RATE, moveSecs);
+
+        // Axis 1 only - the move takes about as long as covering its steps at full rate plus the
+        // time lost to the ramps (which is longer than a move at constant rate would take)
+        checkMove(profile, 0, 3000, 0, AXIS1_MAX_STEP_RATE, moveSecs);
+        printf("%s move 0,3000 took %.3fs\n", profile, moveSecs);
+        CHECK(moveSecs > (3000 / AXIS1_MAX_STEP_RATE + AXIS1_MAX_STEP_RATE / AXIS1_MAX_STEP_ACC) * 0.9);
+    }
+    return hostTestResult("test_stepwise_ramp");
+}
@@ -43,24 +43,32 @@ class AxisFloats
     {
         _pt[0] = x;
         _pt[1] = y;
+#if ROBOT_MAX_AXES > 2
         _pt[2] = 0;
+#endif
         _validityFlags = 0x03;
     }
     AxisFloats(float x, float y, float z)
     {
         _pt[0] = x;
         _pt[1] = y;
+#if ROBOT_MAX_AXES > 2
         _pt[2] = z;
-        _validityFlags = 0x07;
+#endif
+        _validityFlags = (1 << RobotConsts::MAX_AXES) - 1;
     }
     AxisFloats(float x, float y, float z, bool xValid, bool yValid, bool zValid)
     {
         _pt[0] = x;
         _pt[1] = y;
+#if ROBOT_MAX_AXES > 2
         _pt[2] = z;
+#endif
         _validityFlags = xValid ? 0x01 : 0;
         _validityFlags |= yValid ? 0x02 : 0;
+#if ROBOT_MAX_AXES > 2
         _validityFlags |= zValid ? 0x04 : 0;
+#endif
     }
     bool operator==(const AxisFloats& other)
     {
@@ -104,8 +112,10 @@ class AxisFloats
     {
         _pt[0] = val0;
         _pt[1] = val1;
+#if ROBOT_MAX_AXES > 2
         _pt[2] = val2;
-        _validityFlags = 0x07;
+#endif
+        _validityFlags = (1 << RobotConsts::MAX_AXES) - 1;
     }
     void setValid(int axisIdx, bool isValid)
     {
@@ -151,12 +161,18 @@ class AxisFloats
     }
     float Z()
     {
+#if ROBOT_MAX_AXES > 2
         return _pt[2];
+#else
+        return 0;
+#endif
     }
     void Z(float val)
     {
+#if ROBOT_MAX_AXES > 2
         _pt[2] = val;
         _validityFlags |= 0x04;
+#endif
     }
     AxisFloats &operator=(const AxisFloats &other)
     {
@@ -249,11 +265,11 @@ class AxisFloats
     String toJSON()
     {
         String jsonStr = "[";
-        for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+        for (int axisIdx = 0; axisIdx < RobotConsts::JSON_AXES; axisIdx++)
         {
             if (axisIdx != 0)
                 jsonStr += ",";
-            jsonStr += String(_pt[axisIdx], 2);
+            jsonStr += String((axisIdx < RobotConsts::MAX_AXES) ? _pt[axisIdx] : 0, 2);
         }
         jsonStr += "]";
         return jsonStr;
@@ -440,7 +456,7 @@ class AxisMinMaxBools
     String toJSON()
     {
         String jsonStr = "[";
-        for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+        for (int axisIdx = 0; axisIdx < RobotConsts::JSON_AXES; axisIdx++)
         {
             if (axisIdx != 0)
                 jsonStr += ",";
@@ -449,7 +465,7 @@ class AxisMinMaxBools
             {
                 if (endstopIdx != 0)
                     jsonStr += ",";
-                jsonStr += get(axisIdx, endstopIdx);
+                jsonStr += (axisIdx < RobotConsts::MAX_AXES) ? get(axisIdx, endstopIdx) : END_STOP_NONE;
             }
             jsonStr += "]";
         }
@@ -483,7 +499,9 @@ class AxisInt32s
     {
         vals[0] = xVal;
         vals[1] = yVal;
+#if ROBOT_MAX_AXES > 2
         vals[2] = zVal;
+#endif
     }
     bool operator==(const AxisInt32s& other)
     {
@@ -505,7 +523,9 @@ class AxisInt32s
     {
         vals[0] = val0;
         vals[1] = val1;
+#if ROBOT_MAX_AXES > 2
         vals[2] = val2;
+#endif
     }
     int32_t X()
     {
@@ -517,7 +537,11 @@ class AxisInt32s
     }
     int32_t Z()
     {
+#if ROBOT_MAX_AXES > 2
         return vals[2];
+#else
+        return 0;
+#endif
     }
     int32_t getVal(int axisIdx)
     {
@@ -533,11 +557,11 @@ class AxisInt32s
     String toJSON()
     {
         String jsonStr = "[";
-        for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+        for (int axisIdx = 0; axisIdx < RobotConsts::JSON_AXES; axisIdx++)
         {
             if (axisIdx != 0)
                 jsonStr += ",";
-            jsonStr += String(vals[axisIdx]);
+            jsonStr += String((axisIdx < RobotConsts::MAX_AXES) ? vals[axisIdx] : 0);
         }
         jsonStr += "]";
         return jsonStr;
@@ -97,6 +97,39 @@ void RestAPIRobot::apiPlayFile(String &reqStr, String &respStr)
     _workManager.addWorkItem(workItem, respStr);
 }
 
+void RestAPIRobot::apiStepRecord(String &reqStr, String &respStr)
+{
+    Log.notice("%sstepRecord %s\n", MODULE_PREFIX, reqStr.c_str());
+    String cmdStr = RestAPIEndpoints::getNthArgStr(reqStr.c_str(), 1);
+    String maxEventsStr = RestAPIEndpoints::getNthArgStr(reqStr.c_str(), 2);
+    _workManager.stepRecorder(cmdStr.c_str(), maxEventsStr.toInt(), respStr);
+}
+
+void RestAPIRobot::apiMotionStats(String &reqStr, String &respStr)
+{
+    String cmdStr = RestAPIEndpoints::getNthArgStr(reqStr.c_str(), 1);
+    _workManager.motionStats(cmdStr.c_str(), respStr);
+}
+
+void RestAPIRobot::apiISRStats(String &reqStr, String &respStr)
+{
+    String cmdStr = RestAPIEndpoints::getNthArgStr(reqStr.c_str(), 1);
+    _workManager.isrStats(cmdStr.c_str(), respStr);
+}
+
+void RestAPIRobot::apiHomingStatus(String &reqStr, String &respStr)
+{
+    _workManager.homingStatus(respStr);
+}
+
+void RestAPIRobot::apiPlannerTrace(String &reqStr, String &respStr)
+{
+    Log.notice("%splannerTrace %s\n", MODULE_PREFIX, reqStr.c_str());
+    String cmdStr = RestAPIEndpoints::getNthArgStr(reqStr.c_str(), 1);
+    String maxBlocksStr = RestAPIEndpoints::getNthArgStr(reqStr.c_str(), 2);
+    _workManager.plannerTrace(cmdStr.c_str(), maxBlocksStr.toInt(), respStr);
+}
+
 void RestAPIRobot::setup(RestAPIEndpoints &endpoints)
 {
     // Get robot types
@@ -137,6 +170,31 @@ void RestAPIRobot::setup(RestAPIEndpoints &endpoints)
     endpoints.addEndpoint("status", RestAPIEndpointDef::ENDPOINT_CALLBACK, RestAPIEndpointDef::ENDPOINT_GET,
                             std::bind(&RestAPIRobot::apiQueryStatus, this, std::placeholders::_1, std::placeholders::_2),
                             "Query status");
+
+    // Motion statistics
+    endpoints.addEndpoint("motionStats", RestAPIEndpointDef::ENDPOINT_CALLBACK, RestAPIEndpointDef::ENDPOINT_GET,
+                            std::bind(&RestAPIRobot::apiMotionStats, this, std::placeholders::_1, std::placeholders::_2),
+                            "Motion statistics - pipeline underruns and planning time, /reset to clear");
+
+    // ISR timing statistics
+    endpoints.addEndpoint("isrStats", RestAPIEndpointDef::ENDPOINT_CALLBACK, RestAPIEndpointDef::ENDPOINT_GET,
+                            std::bind(&RestAPIRobot::apiISRStats, this, std::placeholders::_1, std::placeholders::_2),
+                            "ISR timing - execution time and step interval deviation histograms, /reset to clear");
+
+    // Homing status
+    endpoints.addEndpoint("homingStatus", RestAPIEndpointDef::ENDPOINT_CALLBACK, RestAPIEndpointDef::ENDPOINT_GET,
+                            std::bind(&RestAPIRobot::apiHomingStatus, this, std::placeholders::_1, std::placeholders::_2),
+                            "Homing status - progress and any error in the homing sequence");
+
+    // Planner trace
+    endpoints.addEndpoint("plannerTrace", RestAPIEndpointDef::ENDPOINT_CALLBACK, RestAPIEndpointDef::ENDPOINT_GET,
+                            std::bind(&RestAPIRobot::apiPlannerTrace, this, std::placeholders::_1, std::placeholders::_2),
+                            "Planner trace ... /start/N to keep the last N blocks executed, /stop to stop, /get for CSV", "text/plain");
+
+    // Step recorder
+    endpoints.addEndpoint("stepRecord", RestAPIEndpointDef::ENDPOINT_CALLBACK, RestAPIEndpointDef::ENDPOINT_GET,
+                            std::bind(&RestAPIRobot::apiStepRecord, this, std::placeholders::_1, std::placeholders::_2),
+                            "Step recorder ... /start/N to record N step events, /stop to stop, /get for CSV", "text/plain");
                             
     //LED Strip
     endpoints.addEndpoint("settings/led", RestAPIEndpointDef::ENDPOINT_CALLBACK, RestAPIEndpointDef::ENDPOINT_GET,
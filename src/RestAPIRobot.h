@@ -34,5 +34,10 @@ class RestAPIRobot
     void apiPattern(String &reqStr, String &respStr);
     void apiSequence(String &reqStr, String &respStr);
     void apiPlayFile(String &reqStr, String &respStr);
+    void apiStepRecord(String &reqStr, String &respStr);
+    void apiMotionStats(String &reqStr, String &respStr);
+    void apiISRStats(String &reqStr, String &respStr);
+    void apiHomingStatus(String &reqStr, String &respStr);
+    void apiPlannerTrace(String &reqStr, String &respStr);
     void setup(RestAPIEndpoints &endpoints);
 };
@@ -27,6 +27,8 @@ private:
     bool _moreMovesComing : 1;
     bool _isHoming: 1;
     bool _hasHomed: 1;
+    bool _polarSweepValid : 1;
+    bool _arcCentreValid : 1;
     // Command control
     int _queuedCommands;
     int _numberedCommandIndex;
@@ -38,6 +40,12 @@ private:
     float _feedrateValue;
     RobotMoveTypeArg _moveType;
     AxisMinMaxBools _endstops;
+    // Angle swept around the origin (degrees, anticlockwise positive) for a move
+    // which is linear in polar coordinates (theta-rho)
+    float _polarSweepDegs;
+    // Arc (G2/G3) centre as an offset from the start point (I and J) and number of turns
+    AxisFloats _arcCentreOffset;
+    int _arcTurns;
 
 public:
     RobotCommandArgs()
@@ -58,6 +66,8 @@ public:
         _moreMovesComing = false;
         _isHoming = false;
         _hasHomed = false;
+        _polarSweepValid = false;
+        _arcCentreValid = false;
         // Command control
         _queuedCommands = 0;
         _numberedCommandIndex = RobotConsts::NUMBERED_COMMAND_NONE;
@@ -69,6 +79,9 @@ public:
         _feedrateValue = 0.0;
         _moveType = RobotMoveTypeArg_None;
         _endstops.none();
+        _polarSweepDegs = 0;
+        _arcCentreOffset.clear();
+        _arcTurns = 1;
     }
 
     RobotCommandArgs& operator=(const RobotCommandArgs& copyFrom)
@@ -90,6 +103,8 @@ public:
             (_allowOutOfBounds == other._allowOutOfBounds) &&
             (_pause == other._pause) &&
             (_moreMovesComing == other._moreMovesComing) &&
+            (_polarSweepValid == other._polarSweepValid) &&
+            (_arcCentreValid == other._arcCentreValid) &&
             // Command control
             (_queuedCommands == other._queuedCommands) &&
             (_numberedCommandIndex == other._numberedCommandIndex) &&
@@ -97,7 +112,10 @@ public:
             (_extrudeValue == other._extrudeValue) &&
             (_feedrateValue == other._feedrateValue) &&
             (_moveType == other._moveType) &&
-            (_endstops == other._endstops);
+            (_endstops == other._endstops) &&
+            (_polarSweepDegs == other._polarSweepDegs) &&
+            (_arcCentreOffset == other._arcCentreOffset) &&
+            (_arcTurns == other._arcTurns);
         if (!isEqual)
             return false;
         // Coords, etc
@@ -133,6 +151,8 @@ private:
         _allowOutOfBounds = copyFrom._allowOutOfBounds;
         _pause = copyFrom._pause;
         _moreMovesComing = copyFrom._moreMovesComing;
+        _polarSweepValid = copyFrom._polarSweepValid;
+        _arcCentreValid = copyFrom._arcCentreValid;
         // Command control
         _queuedCommands = copyFrom._queuedCommands;
         _numberedCommandIndex = copyFrom._numberedCommandIndex;
@@ -144,6 +164,9 @@ private:
         _feedrateValue = copyFrom._feedrateValue;
         _moveType = copyFrom._moveType;
         _endstops = copyFrom._endstops;
+        _polarSweepDegs = copyFrom._polarSweepDegs;
+        _arcCentreOffset = copyFrom._arcCentreOffset;
+        _arcTurns = copyFrom._arcTurns;
     }
 
 public:
@@ -320,6 +343,53 @@ public:
     {
         return _dontSplitMove;
     }
+    void setPolarSweep(float sweepDegs)
+    {
+        _polarSweepDegs = sweepDegs;
+        _polarSweepValid = true;
+    }
+    void clearPolarSweep()
+    {
+        _polarSweepDegs = 0;
+        _polarSweepValid = false;
+    }
+    bool isPolarSweepValid()
+    {
+        return _polarSweepValid;
+    }
+    float getPolarSweep()
+    {
+        return _polarSweepDegs;
+    }
+    void setMoveClockwise(bool moveClockwise)
+    {
+        _moveClockwise = moveClockwise;
+    }
+    bool getMoveClockwise()
+    {
+        return _moveClockwise;
+    }
+    void setArcCentreOffset(int axisIdx, float offsetMM)
+    {
+        _arcCentreOffset.setVal(axisIdx, offsetMM);
+        _arcCentreValid = true;
+    }
+    bool isArc()
+    {
+        return _arcCentreValid;
+    }
+    AxisFloats& getArcCentreOffset()
+    {
+        return _arcCentreOffset;
+    }
+    void setArcTurns(int turns)
+    {
+        _arcTurns = turns;
+    }
+    int getArcTurns()
+    {
+        return _arcTurns;
+    }
     void setNumberedCommandIndex(int cmdIdx)
     {
         _numberedCommandIndex = cmdIdx;
@@ -332,6 +402,10 @@ public:
     {
         _queuedCommands = numQueued;
     }
+    int getNumQueued()
+    {
+        return _queuedCommands;
+    }
     void setPause(bool pause)
     {
         _pause = pause;
@@ -1,8 +1,19 @@
 #pragma once
 
+// Number of axes the motion core is built for - the planner, step ISR and axis values loop
+// over every axis so builds for robots with fewer axes (e.g. the sand tables) can set this to 2
+// in build_flags (the firmware is built for 3 until a gain is measured on the ESP32)
+#ifndef ROBOT_MAX_AXES
+#define ROBOT_MAX_AXES 3
+#endif
+
 namespace RobotConsts
 {
-static constexpr int MAX_AXES = 3;
+static constexpr int MAX_AXES = ROBOT_MAX_AXES;
+static_assert((MAX_AXES >= 2) && (MAX_AXES <= 3), "ROBOT_MAX_AXES must be 2 or 3");
+// Axis arrays in JSON (e.g. /status) have this many entries whatever the build (0 for axes
+// not built) so clients don't depend on ROBOT_MAX_AXES
+static constexpr int JSON_AXES = 3;
 static constexpr int MAX_ENDSTOPS_PER_AXIS = 2;
 
 // MOTOR_TYPE_DRIVER has an A4988 or similar stepper driver chip that just requires step and direction
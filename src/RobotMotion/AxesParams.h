@@ -125,6 +125,20 @@ class AxesParams
         return _maxStepRatesPerSec.getVal(axisIdx);
     }
 
+    // Max acceleration of the actuator in steps per second per second - if not set this is the
+    // acceleration that takes the actuator to its max step rate in the time the axis takes to
+    // reach maxSpeed at maxAcc
+    float getMaxStepAccPerSec2(int axisIdx)
+    {
+        if (axisIdx < 0 || axisIdx >= RobotConsts::MAX_AXES)
+            return AxisParams::maxRPM_default * AxisParams::stepsPerRot_default / 60;
+        if (_axisParams[axisIdx]._maxStepAccPerSec2 > 0)
+            return _axisParams[axisIdx]._maxStepAccPerSec2;
+        if (_axisParams[axisIdx]._maxSpeedMMps <= 0)
+            return getMaxStepRatePerSec(axisIdx);
+        return getMaxStepRatePerSec(axisIdx) * _axisParams[axisIdx]._maxAccelMMps2 / _axisParams[axisIdx]._maxSpeedMMps;
+    }
+
     float getMaxAccel(int axisIdx)
     {
         if (axisIdx < 0 || axisIdx >= RobotConsts::MAX_AXES)
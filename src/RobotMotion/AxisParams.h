@@ -25,6 +25,7 @@ class AxisParams
     float _stepsPerRot;
     float _unitsPerRot;
     float _maxRPM;
+    float _maxStepAccPerSec2;
     bool _minValValid;
     float _minVal;
     bool _maxValValid;
@@ -48,6 +49,7 @@ class AxisParams
         _stepsPerRot = stepsPerRot_default;
         _unitsPerRot = unitsPerRot_default;
         _maxRPM = maxRPM_default;
+        _maxStepAccPerSec2 = 0;
         _minValValid = false;
         _minVal = 0;
         _maxValValid = false;
@@ -91,6 +93,7 @@ class AxisParams
         _stepsPerRot = float(RdJson::getDouble("stepsPerRot", AxisParams::stepsPerRot_default, axisJSON));
         _unitsPerRot = float(RdJson::getDouble("unitsPerRot", AxisParams::unitsPerRot_default, axisJSON));
         _maxRPM = float(RdJson::getDouble("maxRPM", AxisParams::maxRPM_default, axisJSON));
+        _maxStepAccPerSec2 = float(RdJson::getDouble("maxStepAcc", 0, axisJSON));
         _minVal = float(RdJson::getDouble("minVal", 0, _minValValid, axisJSON));
         _maxVal = float(RdJson::getDouble("maxVal", 0, _maxValValid, axisJSON));
         _isDominantAxis = RdJson::getLong("isDominantAxis", 0, axisJSON) != 0;
@@ -17,6 +17,7 @@ void MotionBlock::clear()
     // Clear values
     _feedrate = 0;
     _moveDistPrimaryAxesMM = 0;
+    _maxAccMMps2 = 0;
     _maxEntrySpeedMMps = 0;
     _entrySpeedMMps = 0;
     _exitSpeedMMps = 0;
@@ -24,6 +25,7 @@ void MotionBlock::clear()
     _isExecuting = false;
     _canExecute = false;
     _blockIsFollowed = false;
+    _isStepwise = false;
     _axisIdxWithMaxSteps = 0;
     _unitVecAxisWithMaxDist = 0;
     _accStepsPerTTicksPerMS = 0;
@@ -32,9 +34,15 @@ void MotionBlock::clear()
     _maxStepRatePerTTicks = 0;
     _stepsBeforeDecel = 0;
     _numberedCommandIndex = 0;
+    _stepCompileState = STEP_COMPILE_NONE;
+    _stepCompileDurationUs = 0;
+    _execReady = false;
     _endStopsToCheck.none();
     for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
-        _stepsTotalMaybeNeg[axisIdx] = 0;
+        _exec._stepsTotalAbs[axisIdx] = 0;
+    _exec._dirnPositiveBits = (1 << RobotConsts::MAX_AXES) - 1;
+    _exec._endStopCheckBits = 0;
+    _exec._endStopHitLevelBits = 0;
 }
 
 void MotionBlock::setNumberedCommandIndex(int cmdIdx)
@@ -49,7 +57,8 @@ int32_t MotionBlock::getStepsToTarget(int axisIdx)
 {
     if (axisIdx >= 0 && axisIdx < RobotConsts::MAX_AXES)
     {
-        return _stepsTotalMaybeNeg[axisIdx];
+        int32_t absSteps = int32_t(_exec._stepsTotalAbs[axisIdx]);
+        return (_exec._dirnPositiveBits & (1 << axisIdx)) ? absSteps : -absSteps;
     }
     return 0;
 }
@@ -58,7 +67,7 @@ int32_t MotionBlock::getAbsStepsToTarget(int axisIdx)
 {
     if (axisIdx >= 0 && axisIdx < RobotConsts::MAX_AXES)
     {
-        return abs(_stepsTotalMaybeNeg[axisIdx]);
+        return int32_t(_exec._stepsTotalAbs[axisIdx]);
     }
     return 0;
 }
@@ -67,8 +76,12 @@ void MotionBlock::setStepsToTarget(int axisIdx, int32_t steps)
 {
     if (axisIdx >= 0 && axisIdx < RobotConsts::MAX_AXES)
     {
-        _stepsTotalMaybeNeg[axisIdx] = steps;
-        if (abs(steps) > abs(_stepsTotalMaybeNeg[_axisIdxWithMaxSteps]))
+        _exec._stepsTotalAbs[axisIdx] = abs(steps);
+        if (steps >= 0)
+            _exec._dirnPositiveBits |= (1 << axisIdx);
+        else
+            _exec._dirnPositiveBits &= ~(1 << axisIdx);
+        if (_exec._stepsTotalAbs[axisIdx] > _exec._stepsTotalAbs[_axisIdxWithMaxSteps])
             _axisIdxWithMaxSteps = axisIdx;
     }
 }
@@ -102,12 +115,12 @@ void MotionBlock::setEndStopsToCheck(AxisMinMaxBools &endStopCheck)
 // We now compute the stepping parameters to make motion happen
 bool MotionBlock::prepareForStepping(AxesParams &axesParams, bool isStepwise)
 {
-    // If block is currently being executed don't change it
-    if (_isExecuting)
+    // If block is currently being executed (or compiled for execution) don't change it
+    if (isLocked())
         return false;
 
     // Find the max number of steps for any axis
-    uint32_t absMaxStepsForAnyAxis = abs(_stepsTotalMaybeNeg[_axisIdxWithMaxSteps]);
+    uint32_t absMaxStepsForAnyAxis = _exec._stepsTotalAbs[_axisIdxWithMaxSteps];
 
     // Check if stepwise movement
     float initialStepRatePerSec = 0;
@@ -115,80 +128,83 @@ bool MotionBlock::prepareForStepping(AxesParams &axesParams, bool isStepwise)
     float maxAccStepsPerSec2 = 0;
     float axisMaxStepRatePerSec = 0;
     uint32_t stepsDecelerating = 0; 
-    double stepDistMM = 0;
+    float stepDistMM = 0;
     if (isStepwise)
     {
-        // Feedrate is in steps per second in this case
-        float stepRatePerSec = _feedrate;
-        if (stepRatePerSec > axesParams.getMaxStepRatePerSec(_axisIdxWithMaxSteps))
-            stepRatePerSec = axesParams.getMaxStepRatePerSec(_axisIdxWithMaxSteps);
-        initialStepRatePerSec = stepRatePerSec;
-        finalStepRatePerSec = stepRatePerSec;
-        maxAccStepsPerSec2 = stepRatePerSec;
-        axisMaxStepRatePerSec = stepRatePerSec;
-        stepsDecelerating = 0;
+        // Feedrate is in steps per second of the axis with max steps - the rate and acceleration
+        // are limited by each axis's max step rate and acceleration scaled by its share of the steps
+        // Stepwise blocks start and end stationary
+        axisMaxStepRatePerSec = _feedrate;
+        maxAccStepsPerSec2 = 1e8;
+        for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+        {
+            uint32_t absSteps = _exec._stepsTotalAbs[axisIdx];
+            if (absSteps == 0)
+                continue;
+            float stepsRatio = float(absMaxStepsForAnyAxis) / absSteps;
+            axisMaxStepRatePerSec = fminf(axisMaxStepRatePerSec, axesParams.getMaxStepRatePerSec(axisIdx) * stepsRatio);
+            maxAccStepsPerSec2 = fminf(maxAccStepsPerSec2, axesParams.getMaxStepAccPerSec2(axisIdx) * stepsRatio);
+        }
     }
     else
     {
         // Get the initial step rate, final step rate and max acceleration for the axis with max steps
-        stepDistMM = fabsf(_moveDistPrimaryAxesMM / _stepsTotalMaybeNeg[_axisIdxWithMaxSteps]);
+        stepDistMM = fabsf(_moveDistPrimaryAxesMM / absMaxStepsForAnyAxis);
         initialStepRatePerSec = fabsf(_entrySpeedMMps / stepDistMM);
         if (initialStepRatePerSec > axesParams.getMaxStepRatePerSec(_axisIdxWithMaxSteps))
             initialStepRatePerSec = axesParams.getMaxStepRatePerSec(_axisIdxWithMaxSteps);
         finalStepRatePerSec = fabsf(_exitSpeedMMps / stepDistMM);
         if (finalStepRatePerSec > axesParams.getMaxStepRatePerSec(_axisIdxWithMaxSteps))
             finalStepRatePerSec = axesParams.getMaxStepRatePerSec(_axisIdxWithMaxSteps);
-        maxAccStepsPerSec2 = fabsf(axesParams.getMaxAccel(_axisIdxWithMaxSteps) / stepDistMM);
-
-        // Calculate the distance decelerating and ensure within bounds
-        // Using the facts for the block ... (assuming max accleration followed by max deceleration):
-        //		Vmax * Vmax = Ventry * Ventry + 2 * Amax * Saccelerating
-        //		Vexit * Vexit = Vmax * Vmax - 2 * Amax * Sdecelerating
-        //      Stotal = Saccelerating + Sdecelerating
-        // And solving for Saccelerating (distance accelerating)
-        uint32_t stepsAccelerating = 0;
-        float stepsAcceleratingFloat =
-            ceilf((powf(finalStepRatePerSec, 2) - powf(initialStepRatePerSec, 2)) / 4 /
-                        maxAccStepsPerSec2 +
-                    absMaxStepsForAnyAxis / 2);
-        if (stepsAcceleratingFloat > 0)
-        {
-            stepsAccelerating = uint32_t(stepsAcceleratingFloat);
-            if (stepsAccelerating > absMaxStepsForAnyAxis)
-                stepsAccelerating = absMaxStepsForAnyAxis;
-        }
-
-        // Decelerating steps
-        stepsDecelerating = 0;
+        float maxAccMMps2 = (_maxAccMMps2 > 0) ? _maxAccMMps2 : axesParams.getMaxAccel(_axisIdxWithMaxSteps);
+        maxAccStepsPerSec2 = fabsf(maxAccMMps2 / stepDistMM);
 
         // Find max possible rate for axis with max steps
         axisMaxStepRatePerSec = fabsf(_feedrate / stepDistMM);
         if (axisMaxStepRatePerSec > axesParams.getMaxStepRatePerSec(_axisIdxWithMaxSteps))
             axisMaxStepRatePerSec = axesParams.getMaxStepRatePerSec(_axisIdxWithMaxSteps);
+    }
 
-        // See if max speed will be reached
-        uint32_t stepsToMaxSpeed =
-            uint32_t((powf(axisMaxStepRatePerSec, 2) - powf(initialStepRatePerSec, 2)) /
-                        2 / maxAccStepsPerSec2);
-        if (stepsAccelerating > stepsToMaxSpeed)
-        {
-            // Max speed will be reached
-            stepsAccelerating = stepsToMaxSpeed;
+    // Calculate the distance decelerating and ensure within bounds
+    // Using the facts for the block ... (assuming max accleration followed by max deceleration):
+    //		Vmax * Vmax = Ventry * Ventry + 2 * Amax * Saccelerating
+    //		Vexit * Vexit = Vmax * Vmax - 2 * Amax * Sdecelerating
+    //      Stotal = Saccelerating + Sdecelerating
+    // And solving for Saccelerating (distance accelerating)
+    uint32_t stepsAccelerating = 0;
+    float stepsAcceleratingFloat =
+        ceilf((powf(finalStepRatePerSec, 2) - powf(initialStepRatePerSec, 2)) / 4 /
+                    maxAccStepsPerSec2 +
+                absMaxStepsForAnyAxis / 2);
+    if (stepsAcceleratingFloat > 0)
+    {
+        stepsAccelerating = uint32_t(stepsAcceleratingFloat);
+        if (stepsAccelerating > absMaxStepsForAnyAxis)
+            stepsAccelerating = absMaxStepsForAnyAxis;
+    }
 
-            // Decelerating steps
-            stepsDecelerating =
-                uint32_t((powf(axisMaxStepRatePerSec, 2) - powf(finalStepRatePerSec, 2)) /
-                            2 / maxAccStepsPerSec2);
-        }
-        else
-        {
-            // Calculate max speed that will be reached
-            axisMaxStepRatePerSec =
-                sqrtf(powf(initialStepRatePerSec, 2) + 2.0F * maxAccStepsPerSec2 * stepsAccelerating);
+    // See if max speed will be reached
+    uint32_t stepsToMaxSpeed =
+        uint32_t((powf(axisMaxStepRatePerSec, 2) - powf(initialStepRatePerSec, 2)) /
+                    2 / maxAccStepsPerSec2);
+    if (stepsAccelerating > stepsToMaxSpeed)
+    {
+        // Max speed will be reached
+        stepsAccelerating = stepsToMaxSpeed;
 
-            // Decelerating steps
-            stepsDecelerating = absMaxStepsForAnyAxis - stepsAccelerating;
-        }
+        // Decelerating steps
+        stepsDecelerating =
+            uint32_t((powf(axisMaxStepRatePerSec, 2) - powf(finalStepRatePerSec, 2)) /
+                        2 / maxAccStepsPerSec2);
+    }
+    else
+    {
+        // Calculate max speed that will be reached
+        axisMaxStepRatePerSec =
+            sqrtf(powf(initialStepRatePerSec, 2) + 2.0F * maxAccStepsPerSec2 * stepsAccelerating);
+
+        // Decelerating steps
+        stepsDecelerating = absMaxStepsForAnyAxis - stepsAccelerating;
     }
 
     // Fill in the step values for this axis
@@ -10,6 +10,9 @@
 class MotionBlock
 {
 public:
+    static_assert(RobotConsts::MAX_AXES * RobotConsts::MAX_ENDSTOPS_PER_AXIS <= 8,
+                  "end-stop bits of the execution record are 8 bits");
+
     // Minimum move distance
     static constexpr double MINIMUM_MOVE_DIST_MM = 0.0001;
 
@@ -25,6 +28,11 @@ public:
     // Number of ns in ms
     static constexpr uint32_t NS_IN_A_MS = 1000000;
 
+    // Step command compilation state (only used when the ramp generator is in step event mode)
+    static constexpr uint8_t STEP_COMPILE_NONE = 0;
+    static constexpr uint8_t STEP_COMPILE_STARTED = 1;
+    static constexpr uint8_t STEP_COMPILE_DONE = 2;
+
 public:
     // Max speed for move - either MMps or stepsPerSec depending if move is stepwise
     float _feedrate;
@@ -32,6 +40,8 @@ public:
     float _moveDistPrimaryAxesMM;
     // Unit vector on axis with max movement
     float _unitVecAxisWithMaxDist;
+    // Acceleration limit for the block (0 if the limit of the axis with most steps applies)
+    float _maxAccMMps2;
     // Computed max entry speed for a block based on max junction deviation calculation
     float _maxEntrySpeedMMps;
     // Computed entry speed for this block
@@ -39,13 +49,39 @@ public:
     // Computed exit speed for this block
     float _exitSpeedMMps;
     // Step distance in MM
-    double _debugStepDistMM;
+    float _debugStepDistMM;
     // End-stops to test
     AxisMinMaxBools _endStopsToCheck;
     // Numbered command index - to help keep track of block execution from other processes
     // like homing
     int _numberedCommandIndex;
 
+    // Steps before deceleration
+    uint32_t _stepsBeforeDecel;
+
+    // Stepping acceleration/deceleration profile
+    uint32_t _initialStepRatePerTTicks;
+    uint32_t _maxStepRatePerTTicks;
+    uint32_t _finalStepRatePerTTicks;
+    uint32_t _accStepsPerTTicksPerMS;
+
+    // Step command compilation
+    uint32_t _stepCompileDurationUs;
+
+    // Execution record - what the ISR reads to start the block - the steps are set when the
+    // block is planned and the end-stops (which depend on the directions) are prepared on the
+    // main thread (RampGenerator::prepareBlockExec) once the block can execute
+    struct ExecRecord
+    {
+        uint32_t _stepsTotalAbs[RobotConsts::MAX_AXES];
+        uint8_t _dirnPositiveBits;
+        // End-stops to check (bit axisIdx * MAX_ENDSTOPS_PER_AXIS + endStopIdx) and the ones
+        // checked for a high level
+        uint8_t _endStopCheckBits;
+        uint8_t _endStopHitLevelBits;
+    };
+    ExecRecord _exec;
+
     // Flags
     struct
     {
@@ -55,18 +91,14 @@ public:
         volatile bool _canExecute : 1;
         // Block is followed by others
         bool _blockIsFollowed : 1;
+        // Block is a stepwise move (feedrate in steps per second, starts and ends stationary)
+        bool _isStepwise : 1;
     };
-
-    // Steps to target and before deceleration
-    int32_t _stepsTotalMaybeNeg[RobotConsts::MAX_AXES];
-    int _axisIdxWithMaxSteps;
-    uint32_t _stepsBeforeDecel;
-
-    // Stepping acceleration/deceleration profile
-    uint32_t _initialStepRatePerTTicks;
-    uint32_t _maxStepRatePerTTicks;
-    uint32_t _finalStepRatePerTTicks;
-    uint32_t _accStepsPerTTicksPerMS;
+    uint8_t _axisIdxWithMaxSteps;
+    // Step command compilation state - once started the block's profile is fixed
+    volatile uint8_t _stepCompileState;
+    // Execution record is ready
+    volatile bool _execReady;
 
 public:
     MotionBlock();
@@ -81,6 +113,26 @@ public:
     void forceInBounds(float &val, float lowBound, float highBound);
     void setEndStopsToCheck(AxisMinMaxBools &endStopCheck);
 
+    // S-curve (jerk limited) ramp - fraction (Q16) of a rate change completed after the fraction
+    // uQ16 (Q16) of the ramp time - this is 10u^3 - 15u^4 + 6u^5 which has zero acceleration at
+    // both ends and the same mean rate as a linear ramp so the ramp covers the same distance in
+    // the same time as the trapezoid (with a peak acceleration 1.875 times the trapezoid's)
+    static inline uint32_t IRAM_ATTR sCurveFractionQ16(uint32_t uQ16)
+    {
+        if (uQ16 >= 65536)
+            return 65536;
+        uint64_t u2 = (uint64_t(uQ16) * uQ16) >> 16;
+        uint64_t u3 = (u2 * uQ16) >> 16;
+        uint64_t poly = (10ULL << 16) - 15ULL * uQ16 + 6ULL * u2;
+        return uint32_t((u3 * poly) >> 16);
+    }
+
+    // Check if the block can no longer be changed by the planner
+    bool isLocked()
+    {
+        return _isExecuting || (_stepCompileState != STEP_COMPILE_NONE);
+    }
+
     // The block's entry and exit speed are now known
     // The block can accelerate and decelerate as required as long as these criteria are met
     // We now compute the stepping parameters to make motion happen
@@ -21,6 +21,8 @@ MotionHelper::MotionHelper() :
     _isPaused = false;
     _moveRelative = false;
     _blockDistanceMM = 0;
+    _polarBlockMaxDegs = polarBlockMaxDegs_default;
+    _arcChordToleranceMM = arcChordToleranceMM_default;
     _allowAllOutOfBounds = false;
     // Clear axis current location
     _lastCommandedAxisPos.clear();
@@ -31,12 +33,35 @@ MotionHelper::MotionHelper() :
     _correctStepOverflowFn = NULL;
     // Handling of splitting-up of motion into smaller blocks
     _blocksToAddTotal = 0;    
+    _cmdsQueued = false;
+    _workItemsQueued = false;
+    _startMinBlocks = startMinBlocks_default;
+    _startMaxWaitMs = startMaxWaitMs_default;
+    _startWaitBeginMs = 0;
+    _startWaiting = false;
+    _statsBlocksPlanned = 0;
+    _statsKinematicsUs = 0;
+    _statsPlannerUs = 0;
+    _statsPlannerMaxUs = 0;
+    _blocksToAddPolar = false;
+    _blocksToAddPolarNative = false;
+    _blocksToAddCentreXMM = 0;
+    _blocksToAddCentreYMM = 0;
+    _chordToleranceMM = chordToleranceMM_default;
+    _chordMaxBlockMM = chordMaxBlockMM_default;
+    _blocksToAddChord = false;
+    _blocksToAddChordFraction = 0;
+    _blocksToAddLineLenMM = 0;
+    _stopRequested = false;
+    _stopRequestTimeMs = 0;
     // Init callbacks
     _ptToActuatorFn = nullptr;
     _actuatorToPtFn = nullptr;
     _correctStepOverflowFn = nullptr;
     _convertCoordsFn = nullptr;
     _setRobotAttributes = nullptr;
+    _ptToActuatorPolarFn = nullptr;
+    _actuatorFloatsToPtFn = nullptr;
 }
 
 // Destructor
@@ -48,9 +73,15 @@ MotionHelper::~MotionHelper()
 // to actuator coordinates
 // There is also a function to correct step overflow which is important in robots
 // which have continuous rotation as step counts would otherwise overflow 32bit integer values
+// Robots which can move natively in polar coordinates also supply a function that converts a
+// point reached by sweeping a given angle around the origin and robots which can check how far
+// their actuator path strays from a straight line supply a function that converts unrounded
+// actuator positions
 void MotionHelper::setTransforms(ptToActuatorFnType ptToActuatorFn, actuatorToPtFnType actuatorToPtFn,
                                  correctStepOverflowFnType correctStepOverflowFn,
-                                 convertCoordsFnType convertCoordsFn, setRobotAttributesFnType setRobotAttributes)
+                                 convertCoordsFnType convertCoordsFn, setRobotAttributesFnType setRobotAttributes,
+                                 ptToActuatorPolarFnType ptToActuatorPolarFn,
+                                 actuatorFloatsToPtFnType actuatorFloatsToPtFn)
 {
     // Store callbacks
     _ptToActuatorFn = ptToActuatorFn;
@@ -58,6 +89,8 @@ void MotionHelper::setTransforms(ptToActuatorFnType ptToActuatorFn, actuatorToPt
     _correctStepOverflowFn = correctStepOverflowFn;
     _convertCoordsFn = convertCoordsFn;
     _setRobotAttributes = setRobotAttributes;
+    _ptToActuatorPolarFn = ptToActuatorPolarFn;
+    _actuatorFloatsToPtFn = actuatorFloatsToPtFn;
 }
 
 // Configure the robot and pipeline parameters using a JSON input string
@@ -73,16 +106,29 @@ void MotionHelper::configure(const char *robotConfigJSON)
     // Config settings
     int pipelineLen = int(RdJson::getLong("pipelineLen", pipelineLen_default, robotGeom.c_str()));
     _blockDistanceMM = float(RdJson::getDouble("blockDistanceMM", blockDistanceMM_default, robotGeom.c_str()));
+    _polarBlockMaxDegs = float(RdJson::getDouble("polarBlockMaxDegs", polarBlockMaxDegs_default, robotGeom.c_str()));
+    _arcChordToleranceMM = float(RdJson::getDouble("arcChordToleranceMM", arcChordToleranceMM_default, robotGeom.c_str()));
+    _chordToleranceMM = float(RdJson::getDouble("chordToleranceMM", chordToleranceMM_default, robotGeom.c_str()));
+    _chordMaxBlockMM = float(RdJson::getDouble("chordMaxBlockMM", chordMaxBlockMM_default, robotGeom.c_str()));
     _allowAllOutOfBounds = bool(RdJson::getLong("allowOutOfBounds", false, robotGeom.c_str()));
     float junctionDeviation = float(RdJson::getDouble("junctionDeviation", junctionDeviation_default, robotGeom.c_str()));
-    Log.notice("%sconfigMotionPipeline len %d, blockDistMM %F (0=no-max), allowOoB %s, jnDev %F\n", MODULE_PREFIX,
-               pipelineLen, _blockDistanceMM, _allowAllOutOfBounds ? "Y" : "N", junctionDeviation);
+    float junctionMaxRateChange = float(RdJson::getDouble("junctionMaxRateChange", junctionMaxRateChange_default, robotGeom.c_str()));
+    bool actuatorLimits = RdJson::getLong("actuatorLimits", 0, robotGeom.c_str()) != 0;
+    float pathSpeedMMps = float(RdJson::getDouble("pathSpeed", 0, robotGeom.c_str()));
+    _startMinBlocks = int(RdJson::getLong("startMinBlocks", startMinBlocks_default, robotGeom.c_str()));
+    _startMaxWaitMs = uint32_t(RdJson::getLong("startMaxWaitMs", startMaxWaitMs_default, robotGeom.c_str()));
+    Log.notice("%sconfigMotionPipeline len %d, blockDistMM %F (0=no-max), polarBlockDegs %F, arcTolMM %F, allowOoB %s, jnDev %F\n", MODULE_PREFIX,
+               pipelineLen, _blockDistanceMM, _polarBlockMaxDegs, _arcChordToleranceMM, _allowAllOutOfBounds ? "Y" : "N", junctionDeviation);
+    Log.notice("%schordTolMM %F (0=use blockDistMM), chordMaxBlockMM %F\n", MODULE_PREFIX,
+               _chordToleranceMM, _chordMaxBlockMM);
 
     // Pipeline length and block size
     _motionPipeline.init(pipelineLen);
 
     // Motion Pipeline and Planner
-    _motionPlanner.configure(junctionDeviation);
+    _motionPlanner.configure(junctionDeviation, junctionMaxRateChange, actuatorLimits, pathSpeedMMps);
+    Log.notice("%sactuatorLimits %s, pathSpeed %F (0=axis maxSpeed), jnMaxRateChange %F (0=no-max), startMinBlocks %d, startMaxWaitMs %d\n", MODULE_PREFIX, 
+               actuatorLimits ? "Y" : "N", pathSpeedMMps, junctionMaxRateChange, _startMinBlocks, _startMaxWaitMs);
 
     // Clean up previous
     _trinamicsController.deinit();
@@ -106,7 +152,7 @@ void MotionHelper::configure(const char *robotConfigJSON)
         _setRobotAttributes(_axesParams, _robotAttributes);
 
     // Homing
-    _motionHoming.configure(robotGeom.c_str());    
+    _motionHoming.configure(robotGeom.c_str(), _axesParams);
 
     // Trinamic controller
     _trinamicsController.configure(robotGeom.c_str());
@@ -115,7 +161,7 @@ void MotionHelper::configure(const char *robotConfigJSON)
     _motorEnabler.configure(robotGeom.c_str());
 
     // Start motion actuator
-    _rampGenerator.configure(true);
+    _rampGenerator.configure(true, robotGeom.c_str());
 
     // Clear motion info
     _lastCommandedAxisPos.clear();
@@ -128,7 +174,9 @@ bool MotionHelper::canAccept()
     // Check if homing in progress
     if (_motionHoming.isHomingInProgress())
         return false;
-    // Check that the motion pipeline can accept new data
+    // Check that the motion pipeline can accept new data - only one move at a time can be
+    // split into blocks so the next waits (in the robot's command queue, which keeps the
+    // ramp generator's work-queued flag set) until the last block of this one is planned
     return (_blocksToAddTotal == 0) && _motionPipeline.canAccept();
 }
 
@@ -275,9 +323,25 @@ bool MotionHelper::moveTo(RobotCommandArgs &args)
     double lineLen = destPos.distanceTo(_lastCommandedAxisPos._axisPositionMM, includeDist);
 
     // Ensure at least one block
+    // Lines are split by chord tolerance (block ends found as the blocks are added) if the
+    // kinematics can be checked, otherwise into equal blocks of blockDistanceMM
     int numBlocks = 1;
-    if (_blockDistanceMM > 0.01f && !args.getDontSplitMove())
+    _blocksToAddChord = (_chordToleranceMM > 0) && _ptToActuatorFn && _actuatorFloatsToPtFn &&
+                (lineLen > CHORD_MIN_BLOCK_MM) && !args.getDontSplitMove();
+    _blocksToAddChordFraction = 0;
+    _blocksToAddLineLenMM = lineLen;
+    if (!_blocksToAddChord && _blockDistanceMM > 0.01f && !args.getDontSplitMove())
         numBlocks = int(ceil(lineLen / _blockDistanceMM));
+
+    // Moves which are linear in polar coordinates (on robots which can move that way natively)
+    // and arcs are split by the angle swept instead
+    if (!setupPolarBlocks(args, destPos))
+        return false;
+    if (_blocksToAddPolar)
+    {
+        numBlocks = 1;
+        _blocksToAddChord = false;
+    }
     if (numBlocks == 0)
         numBlocks = 1;
 
@@ -308,6 +372,33 @@ void MotionHelper::blocksToAddProcess()
         // Add to pipeline any blocks that are waiting to be expanded out
         AxisFloats nextBlockDest = _blocksToAddStartPos + _blocksToAddDelta * float(_blocksToAddCurBlock + 1);
 
+        // Polar moves follow the spiral between the end points
+        MotionPathCurve curve;
+        if (_blocksToAddPolar)
+        {
+            float startFraction = _blocksToAddPolarFraction;
+            _blocksToAddPolarFraction = polarBlockEndFraction(startFraction);
+            float rho = _blocksToAddStartRhoMM + _blocksToAddRhoDeltaMM * _blocksToAddPolarFraction;
+            float angle = _blocksToAddStartAngleRads + _blocksToAddSweepRads * _blocksToAddPolarFraction;
+            nextBlockDest = _blocksToAddStartPos + (_blocksToAddEndPos - _blocksToAddStartPos) * _blocksToAddPolarFraction;
+            nextBlockDest.setVal(0, _blocksToAddCentreXMM + rho * cosf(angle));
+            nextBlockDest.setVal(1, _blocksToAddCentreYMM + rho * sinf(angle));
+            if (_blocksToAddPolarNative)
+            {
+                polarBlockCurve(startFraction, _blocksToAddPolarFraction, curve);
+                _blocksToAddCommandArgs.setPolarSweep(AxisUtils::r2d(_blocksToAddSweepRads * (_blocksToAddPolarFraction - startFraction)));
+            }
+            if (_blocksToAddPolarFraction < 1)
+                _blocksToAddTotal++;
+        }
+        else if (_blocksToAddChord)
+        {
+            _blocksToAddChordFraction = chordBlockEndFraction(_blocksToAddChordFraction);
+            nextBlockDest = _blocksToAddStartPos + (_blocksToAddEndPos - _blocksToAddStartPos) * _blocksToAddChordFraction;
+            if (_blocksToAddChordFraction < 1)
+                _blocksToAddTotal++;
+        }
+
         // If last block then just use end point coords
         if (_blocksToAddCurBlock + 1 >= _blocksToAddTotal)
             nextBlockDest = _blocksToAddEndPos;
@@ -321,11 +412,12 @@ void MotionHelper::blocksToAddProcess()
 
         // Prepare add to planner
         _blocksToAddCommandArgs.setPointMM(nextBlockDest);
-        _blocksToAddCommandArgs.setMoreMovesComing(_blocksToAddTotal != 0);
+        // The last block is followed if further commands or work items are waiting
+        _blocksToAddCommandArgs.setMoreMovesComing((_blocksToAddTotal != 0) || _cmdsQueued || _workItemsQueued);
 
 
         // Add to planner
-        addToPlanner(_blocksToAddCommandArgs);
+        addToPlanner(_blocksToAddCommandArgs, _blocksToAddPolarNative ? &curve : NULL);
 
         // Enable motors
          if (!_isPaused) {
@@ -335,23 +427,33 @@ void MotionHelper::blocksToAddProcess()
 }
 
 // Add a movement to the pipeline using the planner which computes suitable motion
-bool MotionHelper::addToPlanner(RobotCommandArgs &args)
+bool MotionHelper::addToPlanner(RobotCommandArgs &args, const MotionPathCurve* pCurve)
 {
     // Check we are not stopping
     if (_stopRequested)
         return false;
             
     // Convert the move to actuator coordinates
+    uint32_t kinematicsStartUs = micros();
     AxisFloats actuatorCoords;
     bool moveOk = false;
-    if (_ptToActuatorFn)
+    if (args.isPolarSweepValid() && _ptToActuatorPolarFn)
+        moveOk = _ptToActuatorPolarFn(args.getPointMM(), args.getPolarSweep(), actuatorCoords, _lastCommandedAxisPos,
+                    _axesParams, args.getAllowOutOfBounds() || _allowAllOutOfBounds);
+    else if (_ptToActuatorFn)
         moveOk = _ptToActuatorFn(args.getPointMM(), actuatorCoords, _lastCommandedAxisPos, _axesParams,
                     args.getAllowOutOfBounds() || _allowAllOutOfBounds);
 
     // Plan the move
     if (moveOk)
     {
-        moveOk = _motionPlanner.moveTo(args, actuatorCoords, _lastCommandedAxisPos, _axesParams, _motionPipeline);
+        uint32_t plannerStartUs = micros();
+        _statsKinematicsUs += plannerStartUs - kinematicsStartUs;
+        moveOk = _motionPlanner.moveTo(args, actuatorCoords, _lastCommandedAxisPos, _axesParams, _motionPipeline, pCurve);
+        uint32_t plannerUs = micros() - plannerStartUs;
+        _statsPlannerUs += plannerUs;
+        _statsPlannerMaxUs = max(_statsPlannerMaxUs, plannerUs);
+        _statsBlocksPlanned++;
     }
     if (moveOk)
     {
@@ -367,6 +469,231 @@ bool MotionHelper::addToPlanner(RobotCommandArgs &args)
     return moveOk;
 }
 
+// Setup block generation for a polar move (G0/G1 with W) or an arc (G2/G3 with I and J)
+// Both are spirals with rho and angle changing linearly around a centre point - a polar
+// move is centred on the origin and is only used on robots which can move natively in polar
+// coordinates, arcs are moved natively when centred on the origin and as chords otherwise
+// Returns false if the move is invalid
+bool MotionHelper::setupPolarBlocks(RobotCommandArgs &args, AxisFloats &destPos)
+{
+    AxisFloats& startPos = _lastCommandedAxisPos._axisPositionMM;
+    _blocksToAddPolar = false;
+    _blocksToAddPolarNative = false;
+    _blocksToAddCentreXMM = 0;
+    _blocksToAddCentreYMM = 0;
+    float sweepRads = 0;
+    if (args.isArc())
+    {
+        _blocksToAddCentreXMM = startPos.X() + args.getArcCentreOffset().X();
+        _blocksToAddCentreYMM = startPos.Y() + args.getArcCentreOffset().Y();
+        float startAngle = atan2f(startPos.Y() - _blocksToAddCentreYMM, startPos.X() - _blocksToAddCentreXMM);
+        float endAngle = atan2f(destPos.Y() - _blocksToAddCentreYMM, destPos.X() - _blocksToAddCentreXMM);
+
+        // Sweep in the direction of the arc - an arc which ends where it starts is a full circle
+        // and turns in addition to the first are added
+        sweepRads = endAngle - startAngle;
+        if (args.getMoveClockwise())
+        {
+            if (sweepRads > -ARC_MIN_SWEEP_RADS)
+                sweepRads -= 2 * M_PI;
+        }
+        else
+        {
+            if (sweepRads < ARC_MIN_SWEEP_RADS)
+                sweepRads += 2 * M_PI;
+        }
+        if (args.getArcTurns() < 1)
+        {
+            Log.notice("%smoveTo arc turns %d invalid\n", MODULE_PREFIX, args.getArcTurns());
+            return false;
+        }
+        sweepRads += (args.getArcTurns() - 1) * 2 * M_PI * (args.getMoveClockwise() ? -1 : 1);
+        _blocksToAddPolarNative = _ptToActuatorPolarFn &&
+                    (fabsf(_blocksToAddCentreXMM) < distToTravelMM_ignoreBelow) &&
+                    (fabsf(_blocksToAddCentreYMM) < distToTravelMM_ignoreBelow);
+    }
+    else if (args.isPolarSweepValid() && _ptToActuatorPolarFn)
+    {
+        sweepRads = AxisUtils::d2r(args.getPolarSweep());
+        _blocksToAddPolarNative = true;
+    }
+    else
+    {
+        return true;
+    }
+    _blocksToAddPolar = true;
+
+    // The angle at the start is found from the end point if the move starts at the centre
+    float startX = startPos.X() - _blocksToAddCentreXMM;
+    float startY = startPos.Y() - _blocksToAddCentreYMM;
+    float endX = destPos.X() - _blocksToAddCentreXMM;
+    float endY = destPos.Y() - _blocksToAddCentreYMM;
+    float startRho = sqrtf(startX * startX + startY * startY);
+    float endRho = sqrtf(endX * endX + endY * endY);
+    if (startRho > distToTravelMM_ignoreBelow)
+        _blocksToAddStartAngleRads = atan2f(startY, startX);
+    else
+        _blocksToAddStartAngleRads = atan2f(endY, endX) - sweepRads;
+    _blocksToAddStartRhoMM = startRho;
+    _blocksToAddRhoDeltaMM = endRho - startRho;
+    _blocksToAddSweepRads = sweepRads;
+    _blocksToAddPolarFraction = 0;
+
+    // Chords (moved in cartesian coordinates) mustn't carry a polar sweep
+    if (!_blocksToAddPolarNative)
+        args.clearPolarSweep();
+    return true;
+}
+
+// Find where the next block of a polar move ends (as a fraction of the whole move)
+// Blocks are limited to the max angle and, as the actuators move at constant rates within
+// a block, to a change of speed along the block of POLAR_BLOCK_MAX_SPEED_CHANGE (the speed
+// is proportional to sqrt(rhoPerRad^2 + rho^2) so this limits the change in rho)
+// Chords are limited by the distance from the arc and the max block distance instead
+float MotionHelper::polarBlockEndFraction(float startFraction)
+{
+    float fractionInc = 1 - startFraction;
+    float absSweepRads = fabsf(_blocksToAddSweepRads);
+    if ((absSweepRads > 0) && !_blocksToAddCommandArgs.getDontSplitMove())
+    {
+        if (_polarBlockMaxDegs > 0.01f)
+            fractionInc = fminf(fractionInc, AxisUtils::d2r(_polarBlockMaxDegs) / absSweepRads);
+        float rho = fmaxf(fabsf(_blocksToAddStartRhoMM + _blocksToAddRhoDeltaMM * startFraction), POLAR_BLOCK_MIN_RHO_MM);
+        float rhoPerRad = _blocksToAddRhoDeltaMM / absSweepRads;
+        if (!_blocksToAddPolarNative)
+        {
+            // Chord of angle a is at most rho * (1 - cos(a/2)) from the arc
+            if ((_arcChordToleranceMM > 0) && (rho > _arcChordToleranceMM))
+                fractionInc = fminf(fractionInc, 2 * acosf(1 - _arcChordToleranceMM / rho) / absSweepRads);
+            if (_blockDistanceMM > 0.01f)
+                fractionInc = fminf(fractionInc, _blockDistanceMM / sqrtf(rhoPerRad * rhoPerRad + rho * rho) / absSweepRads);
+        }
+        else if ((_polarBlockMaxDegs > 0.01f) && (_blocksToAddRhoDeltaMM != 0))
+        {
+            float maxRhoChange = POLAR_BLOCK_MAX_SPEED_CHANGE * (rhoPerRad * rhoPerRad + rho * rho) / rho;
+            fractionInc = fminf(fractionInc, maxRhoChange / fabsf(_blocksToAddRhoDeltaMM));
+        }
+    }
+    float endFraction = startFraction + fractionInc;
+    if (endFraction > 0.9999f)
+        endFraction = 1;
+    return endFraction;
+}
+
+// Find where the next block of a straight line ends (as a fraction of the whole line)
+// The longest block (up to chordMaxBlockMM) whose actuator path stays within chordToleranceMM
+// of the line is used - the block length is halved until it fits so blocks are long where
+// the kinematics are close to linear (e.g. the rim of a sand table) and short near the centre
+float MotionHelper::chordBlockEndFraction(float startFraction)
+{
+    if (_blocksToAddLineLenMM <= 0)
+        return 1;
+    uint32_t kinematicsStartUs = micros();
+    AxisFloats startPt = _blocksToAddStartPos + (_blocksToAddEndPos - _blocksToAddStartPos) * startFraction;
+    AxisFloats startActuator;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+        startActuator.setVal(axisIdx, float(_lastCommandedAxisPos._stepsFromHome.getVal(axisIdx)));
+    float remainingMM = (1 - startFraction) * _blocksToAddLineLenMM;
+    float blockLenMM = (_chordMaxBlockMM > CHORD_MIN_BLOCK_MM) ? fminf(_chordMaxBlockMM, remainingMM) : remainingMM;
+    float endFraction = 1;
+    while (true)
+    {
+        endFraction = (blockLenMM >= remainingMM) ? 1 : startFraction + blockLenMM / _blocksToAddLineLenMM;
+        if (blockLenMM <= CHORD_MIN_BLOCK_MM)
+            break;
+        AxisFloats endPt = _blocksToAddStartPos + (_blocksToAddEndPos - _blocksToAddStartPos) * endFraction;
+        if (chordDeviationMM(startPt, startActuator, endPt) <= _chordToleranceMM)
+            break;
+        blockLenMM /= 2;
+    }
+    _statsKinematicsUs += micros() - kinematicsStartUs;
+    if (endFraction > 0.9999f)
+        endFraction = 1;
+    return endFraction;
+}
+
+// Max distance from the line between two points of the path taken when the actuators move
+// at constant rates between them - checked at CHORD_CHECK_POINTS - 1 points along the block
+// using unrounded actuator positions (rounding to whole steps would add up to a step's
+// distance to each point, which is a large part of a typical tolerance)
+float MotionHelper::chordDeviationMM(AxisFloats& startPt, AxisFloats& startActuator, AxisFloats& endPt)
+{
+    AxisPosition curPos = _lastCommandedAxisPos;
+    AxisFloats endActuator;
+    if (!_ptToActuatorFn(endPt, endActuator, curPos, _axesParams, true))
+        return 0;
+
+    // Line direction (primary axes only)
+    AxisFloats lineVec = endPt - startPt;
+    float lineLenSq = 0;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+        if (_axesParams.isPrimaryAxis(axisIdx))
+            lineLenSq += lineVec.getVal(axisIdx) * lineVec.getVal(axisIdx);
+    if (lineLenSq <= 0)
+        return 0;
+
+    float maxDevMM = 0;
+    for (int checkIdx = 1; checkIdx < CHORD_CHECK_POINTS; checkIdx++)
+    {
+        float t = float(checkIdx) / CHORD_CHECK_POINTS;
+        AxisFloats actuatorPos = startActuator + (endActuator - startActuator) * t;
+        AxisFloats pathPt;
+        _actuatorFloatsToPtFn(actuatorPos, pathPt, curPos, _axesParams);
+
+        // Distance from the line segment
+        float proj = 0;
+        for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+            if (_axesParams.isPrimaryAxis(axisIdx))
+                proj += (pathPt.getVal(axisIdx) - startPt.getVal(axisIdx)) * lineVec.getVal(axisIdx);
+        proj = fminf(fmaxf(proj / lineLenSq, 0), 1);
+        float distSq = 0;
+        for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+        {
+            if (!_axesParams.isPrimaryAxis(axisIdx))
+                continue;
+            float diff = pathPt.getVal(axisIdx) - (startPt.getVal(axisIdx) + lineVec.getVal(axisIdx) * proj);
+            distSq += diff * diff;
+        }
+        maxDevMM = fmaxf(maxDevMM, sqrtf(distSq));
+    }
+    return maxDevMM;
+}
+
+// Length and end directions of a block of a polar move - the block is a spiral with
+// rho and angle changing linearly so the direction at a point is found from the
+// radial and tangential rates and the length is integrated using Simpson's rule
+void MotionHelper::polarBlockCurve(float startFraction, float endFraction, MotionPathCurve& curve)
+{
+    float rhoStart = _blocksToAddStartRhoMM + _blocksToAddRhoDeltaMM * startFraction;
+    float angleStart = _blocksToAddStartAngleRads + _blocksToAddSweepRads * startFraction;
+    float rhoInc = _blocksToAddRhoDeltaMM * (endFraction - startFraction);
+    float angleInc = _blocksToAddSweepRads * (endFraction - startFraction);
+    static const int SIMPSON_INTERVALS = 4;
+    float lenSum = 0;
+    for (int i = 0; i <= SIMPSON_INTERVALS; i++)
+    {
+        float rho = rhoStart + rhoInc * i / SIMPSON_INTERVALS;
+        float speed = sqrtf(rhoInc * rhoInc + rho * rho * angleInc * angleInc);
+        lenSum += speed * ((i == 0 || i == SIMPSON_INTERVALS) ? 1 : ((i % 2) ? 4 : 2));
+    }
+    curve._pathLenMM = lenSum / (3 * SIMPSON_INTERVALS);
+
+    // Directions at start and end
+    for (int endIdx = 0; endIdx < 2; endIdx++)
+    {
+        float rho = rhoStart + rhoInc * endIdx;
+        float angle = angleStart + angleInc * endIdx;
+        float dx = rhoInc * cosf(angle) - rho * angleInc * sinf(angle);
+        float dy = rhoInc * sinf(angle) + rho * angleInc * cosf(angle);
+        float len = sqrtf(dx * dx + dy * dy);
+        if (len <= 0)
+            len = 1;
+        AxisFloats& unitVec = (endIdx == 0) ? curve._entryUnitVec : curve._exitUnitVec;
+        unitVec.setVal(0, dx / len);
+        unitVec.setVal(1, dy / len);
+    }
+}
+
 // Called regularly to allow the MotionHelper to do background work such as
 // adding split-up blocks to the pipeline and checking if motors should be
 // disabled after a period of no motion
@@ -387,6 +714,9 @@ void MotionHelper::service()
         }
     }
 
+    // Hold execution until enough is buffered when starting from stopped
+    _rampGenerator.setExecHold(startHoldNeeded());
+
     // Call process on motion actuator - only really used for testing as
     // motion is handled by ISR
     _rampGenerator.process();
@@ -394,8 +724,12 @@ void MotionHelper::service()
     // Process any split-up blocks to be added to the pipeline
     blocksToAddProcess();
 
+    // Let the ramp generator know if there is more work to come so it can count the
+    // times it runs out of blocks while there is
+    _rampGenerator.setWorkQueued(_cmdsQueued || (_blocksToAddTotal > 0), _workItemsQueued);
+
     // Service homing
-    _motionHoming.service(_axesParams);
+    _motionHoming.service();
 
     // Ensure motors enabled when homing or moving
     if (!_isPaused && ((_motionPipeline.count() > 0) || _motionHoming.isHomingInProgress())) {
@@ -405,6 +739,31 @@ void MotionHelper::service()
     }
 }
 
+// Check if execution should be held because the robot is stopped and not enough blocks are
+// buffered yet - the hold ends when the first block starts executing
+bool MotionHelper::startHoldNeeded()
+{
+    MotionBlock* pBlock = _motionPipeline.peekGet();
+    if (!pBlock)
+    {
+        _startWaiting = false;
+        return false;
+    }
+    if (pBlock->isLocked())
+        return false;
+    if (!_startWaiting)
+    {
+        _startWaiting = true;
+        _startWaitBeginMs = millis();
+    }
+    bool moreMovesComing = _cmdsQueued || _workItemsQueued || (_blocksToAddTotal > 0);
+    if (!moreMovesComing || _motionHoming.isHomingInProgress() || !_motionPipeline.canAccept())
+        return false;
+    if ((int)_motionPipeline.count() >= _startMinBlocks)
+        return false;
+    return !Utils::isTimeout(millis(), _startWaitBeginMs, _startMaxWaitMs);
+}
+
 // Set home coordinates
 void MotionHelper::setCurPositionAsHome(int axisIdx)
 {
@@ -431,6 +790,94 @@ String MotionHelper::getDebugStr()
     return _rampGenerator.getDebugStr();
 }
 
+// Step recorder - start recording, stop recording or get the recorded steps as CSV (which
+// stops recording)
+void MotionHelper::stepRecorder(const char* cmdStr, int maxEvents, String& respStr)
+{
+    if (strcasecmp(cmdStr, "start") == 0)
+    {
+        _rampGenerator.stepRecorderStart(maxEvents);
+        Utils::setJsonBoolResult(respStr, true);
+    }
+    else if (strcasecmp(cmdStr, "stop") == 0)
+    {
+        _rampGenerator.stepRecorderStop();
+        Utils::setJsonBoolResult(respStr, true);
+    }
+    else if (strcasecmp(cmdStr, "get") == 0)
+    {
+        _rampGenerator.getStepRecord(respStr);
+    }
+    else
+    {
+        Utils::setJsonBoolResult(respStr, false);
+    }
+}
+
+// Motion statistics - underruns in the ramp generator and the cost of planning (reset clears them)
+void MotionHelper::motionStats(const char* cmdStr, String& respStr)
+{
+    if (strcasecmp(cmdStr, "reset") == 0)
+    {
+        _rampGenerator.resetUnderrunStats();
+        _statsBlocksPlanned = 0;
+        _statsKinematicsUs = 0;
+        _statsPlannerUs = 0;
+        _statsPlannerMaxUs = 0;
+        Utils::setJsonBoolResult(respStr, true);
+        return;
+    }
+    String underrunStr;
+    _rampGenerator.getUnderrunStats(underrunStr);
+    char planStr[160];
+    snprintf(planStr, sizeof(planStr),
+            "\"blocksPlanned\":%u,\"kinematicsMs\":%.1f,\"plannerMs\":%.1f,\"plannerMaxUs\":%u,\"pipeline\":%u",
+            (unsigned)_statsBlocksPlanned, _statsKinematicsUs / 1000.0, _statsPlannerUs / 1000.0,
+            (unsigned)_statsPlannerMaxUs, _motionPipeline.count());
+    respStr = "{" + underrunStr + "," + planStr + "}";
+}
+
+// Homing status - compiled homing sequence and any error in it
+void MotionHelper::homingStatus(String& respStr)
+{
+    _motionHoming.getStatusJSON(respStr);
+}
+
+// Planner trace - start recording, stop recording or get the executed blocks as CSV
+void MotionHelper::plannerTrace(const char* cmdStr, int maxBlocks, String& respStr)
+{
+    if (strcasecmp(cmdStr, "start") == 0)
+    {
+        _rampGenerator.plannerTraceStart(maxBlocks);
+        Utils::setJsonBoolResult(respStr, true);
+    }
+    else if (strcasecmp(cmdStr, "stop") == 0)
+    {
+        _rampGenerator.plannerTraceStop();
+        Utils::setJsonBoolResult(respStr, true);
+    }
+    else if (strcasecmp(cmdStr, "get") == 0)
+    {
+        _rampGenerator.getPlannerTrace(respStr);
+    }
+    else
+    {
+        Utils::setJsonBoolResult(respStr, false);
+    }
+}
+
+// ISR timing statistics - execution time histogram and step interval deviation (reset clears them)
+void MotionHelper::isrStats(const char* cmdStr, String& respStr)
+{
+    if (strcasecmp(cmdStr, "reset") == 0)
+    {
+        _rampGenerator.resetTimingStats();
+        Utils::setJsonBoolResult(respStr, true);
+        return;
+    }
+    _rampGenerator.getTimingStats(respStr);
+}
+
 int MotionHelper::testGetPipelineCount()
 {
     return _motionPipeline.count();
@@ -16,9 +16,26 @@ class MotionHelper
 {
 public:
     static constexpr float blockDistanceMM_default = 0.0f;
+    static constexpr float polarBlockMaxDegs_default = 30.0f;
+    // Polar blocks are shortened where the speed along them (at constant actuator rates)
+    // would change by more than this fraction
+    static constexpr float POLAR_BLOCK_MAX_SPEED_CHANGE = 0.05f;
+    static constexpr float POLAR_BLOCK_MIN_RHO_MM = 1.0f;
+    static constexpr float arcChordToleranceMM_default = 0.05f;
+    // Straight lines are split so that the path the actuators take (moving at constant rates
+    // within a block) stays within this distance of the line
+    static constexpr float chordToleranceMM_default = 0.0f;
+    static constexpr float chordMaxBlockMM_default = 20.0f;
+    static constexpr float CHORD_MIN_BLOCK_MM = 0.1f;
+    static constexpr int CHORD_CHECK_POINTS = 16;
+    // Arcs which end within this angle of their start are full circles
+    static constexpr float ARC_MIN_SWEEP_RADS = 0.0001f;
     static constexpr float junctionDeviation_default = 0.05f;
+    static constexpr float junctionMaxRateChange_default = 0.05f;
     static constexpr float distToTravelMM_ignoreBelow = 0.01f;
     static constexpr int pipelineLen_default = 100;
+    static constexpr int startMinBlocks_default = 4;
+    static constexpr uint32_t startMaxWaitMs_default = 100;
     static constexpr uint32_t MAX_TIME_BEFORE_STOP_COMPLETE_MS = 500;
 
 private:
@@ -26,6 +43,14 @@ private:
     bool _isPaused;
     // Block distance
     float _blockDistanceMM;
+    // Max angle swept by a block of a polar move
+    float _polarBlockMaxDegs;
+    // Max distance between an arc and the chords it is split into (when not moved natively)
+    float _arcChordToleranceMM;
+    // Max distance between a straight line and the actuator path of its blocks (0 to split
+    // lines into blocks of blockDistanceMM instead) and the longest block allowed
+    float _chordToleranceMM;
+    float _chordMaxBlockMM;
     // Allow all out of bounds movement
     bool _allowAllOutOfBounds;
     // Axes parameters
@@ -38,6 +63,8 @@ private:
     correctStepOverflowFnType _correctStepOverflowFn;
     convertCoordsFnType _convertCoordsFn;
     setRobotAttributesFnType _setRobotAttributes;
+    ptToActuatorPolarFnType _ptToActuatorPolarFn;
+    actuatorFloatsToPtFnType _actuatorFloatsToPtFn;
     // Relative motion
     bool _moveRelative;
     // Planner used to plan the pipeline of motion
@@ -68,10 +95,46 @@ private:
     AxisFloats _blocksToAddDelta;
     // Command args for block generation
     RobotCommandArgs _blocksToAddCommandArgs;
+    // Polar move or arc - blocks are generated along the spiral between start and end points
+    // and if the robot can move natively around the spiral's centre each block is linear in
+    // actuator coordinates (otherwise blocks are chords)
+    bool _blocksToAddPolar;
+    bool _blocksToAddPolarNative;
+    float _blocksToAddCentreXMM;
+    float _blocksToAddCentreYMM;
+    float _blocksToAddStartRhoMM;
+    float _blocksToAddStartAngleRads;
+    float _blocksToAddRhoDeltaMM;
+    float _blocksToAddSweepRads;
+    float _blocksToAddPolarFraction;
+
+    // Straight lines split by chord tolerance
+    bool _blocksToAddChord;
+    float _blocksToAddChordFraction;
+    float _blocksToAddLineLenMM;
+
+    // Commands waiting to be planned and work items waiting further upstream
+    bool _cmdsQueued;
+    bool _workItemsQueued;
+
+    // Buffered start - when the robot is stopped execution waits until this many blocks are
+    // in the pipeline (or the wait times out or no more moves are coming) so that the planner
+    // can look ahead and the first blocks don't have to slow down for a pipeline that runs dry
+    int _startMinBlocks;
+    uint32_t _startMaxWaitMs;
+    uint32_t _startWaitBeginMs;
+    bool _startWaiting;
+
+    // Planning telemetry - blocks added to the planner and the time taken by kinematics
+    // and by the planner
+    uint32_t _statsBlocksPlanned;
+    uint64_t _statsKinematicsUs;
+    uint64_t _statsPlannerUs;
+    uint32_t _statsPlannerMaxUs;
 
     // Handling of stop
     bool _stopRequested;
-    bool _stopRequestTimeMs;
+    uint32_t _stopRequestTimeMs;
 
     // Debug
     unsigned long _debugLastPosDispMs;
@@ -82,7 +145,9 @@ public:
 
     void setTransforms(ptToActuatorFnType ptToActuatorFn, actuatorToPtFnType actuatorToPtFn,
                        correctStepOverflowFnType correctStepOverflowFn,
-                       convertCoordsFnType convertCoordsFn, setRobotAttributesFnType setRobotAttributes);
+                       convertCoordsFnType convertCoordsFn, setRobotAttributesFnType setRobotAttributes,
+                       ptToActuatorPolarFnType ptToActuatorPolarFn = nullptr,
+                       actuatorFloatsToPtFnType actuatorFloatsToPtFn = nullptr);
 
     void configure(const char *robotConfigJSON);
 
@@ -96,6 +161,21 @@ public:
     void stop();
     // Check if idle
     bool isIdle();
+    // Feed override (percent of planned speed)
+    void setFeedOverride(float percent)
+    {
+        _rampGenerator.setFeedOverride(percent);
+    }
+    float getFeedOverride()
+    {
+        return _rampGenerator.getFeedOverride();
+    }
+    // Set when commands are waiting to be planned and when work items are queued
+    void setWorkQueued(bool cmdsQueued, bool workItemsQueued)
+    {
+        _cmdsQueued = cmdsQueued;
+        _workItemsQueued = workItemsQueued;
+    }
 
     double getStepsPerUnit(int axisIdx)
     {
@@ -133,6 +213,10 @@ public:
     {
         return max(_rampGenerator.getLastCompletedNumberedCmdIdx(), _trinamicsController.getLastCompletedNumberedCmdIdx());
     }
+    uint32_t getLastCompletedNumberedCmdEndStopHits()
+    {
+        return _rampGenerator.getLastCompletedNumberedCmdEndStopHits();
+    }
     void service();
 
     unsigned long getLastActiveUnixTime()
@@ -145,6 +229,11 @@ public:
     void debugShowTopBlock();
     void debugShowTiming();
     String getDebugStr();
+    void stepRecorder(const char* cmdStr, int maxEvents, String& respStr);
+    void motionStats(const char* cmdStr, String& respStr);
+    void homingStatus(String& respStr);
+    void isrStats(const char* cmdStr, String& respStr);
+    void plannerTrace(const char* cmdStr, int maxBlocks, String& respStr);
     int testGetPipelineCount();
     bool testGetPipelineBlock(int elIdx, MotionBlock &elem);
     void setIntrumentationMode(const char *testModeStr)
@@ -165,6 +254,12 @@ private:
         return (v > fmin(b1, b2) && v < fmax(b1, b2));
     }
     void setCurPosActualPosition();
-    bool addToPlanner(RobotCommandArgs &args);
+    bool startHoldNeeded();
+    bool addToPlanner(RobotCommandArgs &args, const MotionPathCurve* pCurve = NULL);
     void blocksToAddProcess();
+    bool setupPolarBlocks(RobotCommandArgs &args, AxisFloats &destPos);
+    float polarBlockEndFraction(float startFraction);
+    float chordBlockEndFraction(float startFraction);
+    float chordDeviationMM(AxisFloats& startPt, AxisFloats& startActuator, AxisFloats& endPt);
+    void polarBlockCurve(float startFraction, float endFraction, MotionPathCurve& curve);
 };
@@ -3,6 +3,7 @@
 
 #include "MotionHelper.h"
 #include "MotionHoming.h"
+#include "Utils.h"
 
 static const char* MODULE_PREFIX = "MotionHoming: ";
 
@@ -10,19 +11,20 @@ MotionHoming::MotionHoming(MotionHelper *pMotionHelper)
 {
     _pMotionHelper = pMotionHelper;
     _homingInProgress = false;
-    _homingStrPos = 0;
+    _programPos = 0;
+    _compileErrPos = 0;
     _commandInProgress = false;
+    _curCommandEndStopRequiredBits = 0;
     _isHomedOk = false;
     _maxHomingSecs = maxHomingSecs_default;
     _homeReqMillis = 0;
+    _homingCmdStartMillis = 0;
     _homingCurCommandIndex = homing_baseCommandIndex;
-    _feedrateStepsPerSecForHoming = -1;
-    _doCentring = false;
     _centringInProgress = false;
     _centringPhase = 0;
 }
 
-void MotionHoming::configure(const char *configJSON)
+void MotionHoming::configure(const char *configJSON, AxesParams &axesParams)
 {
     // Sequence of commands for homing
     bool isValid = false;
@@ -32,10 +34,15 @@ void MotionHoming::configure(const char *configJSON)
     // Max time homing
     _maxHomingSecs = RdJson::getLong("homing/maxHomingSecs", maxHomingSecs_default, configJSON);
     // No homing currently
-    _homingStrPos = 0;
+    _homingInProgress = false;
     _commandInProgress = false;
     _centringInProgress = false;
-    Log.notice("%sconfig sequence %s\n", MODULE_PREFIX, _homingSequence.c_str());
+    // Compile the sequence
+    if (compileSequence(axesParams))
+        Log.notice("%sconfig sequence %s (%d instructions)\n", MODULE_PREFIX, _homingSequence.c_str(), _program.size());
+    else
+        Log.warning("%sconfig sequence %s error at %d: %s\n", MODULE_PREFIX, _homingSequence.c_str(),
+                    _compileErrPos, _compileErr.c_str());
 }
 
 bool MotionHoming::isHomingInProgress()
@@ -50,22 +57,26 @@ bool MotionHoming::isHomedOk()
 
 void MotionHoming::homingStart(RobotCommandArgs &args)
 {
-    _axesToHome = args;
-    _homingStrPos = 0;
-    _homingInProgress = true;
-    _commandInProgress = false;
     _isHomedOk = false;
+    _commandInProgress = false;
     _centringInProgress = false;
-    _doCentring = false;
+    if (_compileErr.length() > 0)
+    {
+        Log.warning("%sstart failed, sequence error at %d: %s\n", MODULE_PREFIX, _compileErrPos, _compileErr.c_str());
+        _homingInProgress = false;
+        return;
+    }
+    _axesToHome = args;
+    _programPos = 0;
+    _homingInProgress = true;
     _homeReqMillis = millis();
-    _feedrateStepsPerSecForHoming = -1;
     RobotCommandArgs curStatus;
     _pMotionHelper->getCurStatus(curStatus);
     _homingStartSteps = curStatus.getPointSteps();
     Log.notice("%sstart, seq = %s\n", MODULE_PREFIX, _homingSequence.c_str());
 }
 
-void MotionHoming::service(AxesParams &axesParams)
+void MotionHoming::service()
 {
     // Check if active
     if (!_homingInProgress)
@@ -80,7 +91,20 @@ void MotionHoming::service(AxesParams &axesParams)
         if (getLastCompletedNumberedCmdIdx() != _homingCurCommandIndex)
             return;
         debugShowSteps("Command completed");
+        Log.DBG_HOMING_LVL("%scommand took %dms\n", MODULE_PREFIX, int(millis() - _homingCmdStartMillis));
         _commandInProgress = false;
+
+        // A seek or latch which ran out of steps before reaching its end-stop leaves the axis
+        // in an unknown place
+        uint32_t missedBits = _curCommandEndStopRequiredBits & ~getLastCompletedNumberedCmdEndStopHits();
+        if (missedBits)
+        {
+            Log.warning("%sfailed, end-stop not reached by move at %d (axes 0x%x)\n", MODULE_PREFIX,
+                        _program[_programPos - 1]._seqPos, missedBits);
+            _isHomedOk = false;
+            _homingInProgress = false;
+            return;
+        }
     }
 
     // Check for timeout
@@ -101,19 +125,26 @@ void MotionHoming::service(AxesParams &axesParams)
         _centringInProgress = false;
     }
 
-    // Need to start a command or finish
-    _curCommand.clear();
-    String debugCmdStr;
-    bool cmdValid = extractAndExecNextCmd(axesParams, debugCmdStr);
-    if (!cmdValid)
+    // Start the next move or finish
+    if (!execNextInstr())
     {
-        // Done
-        _isHomedOk = false;
         _homingInProgress = false;
         _commandInProgress = false;
     }
 }
 
+// Homing status including any error in the homing sequence
+void MotionHoming::getStatusJSON(String &respStr)
+{
+    String jsonStr = "\"homing\":" + String(_homingInProgress ? 1 : 0) +
+                ",\"homed\":" + String(_isHomedOk ? 1 : 0) +
+                ",\"instrs\":" + String(_program.size()) +
+                ",\"instrPos\":" + String(_programPos);
+    if (_compileErr.length() > 0)
+        jsonStr += ",\"err\":\"" + _compileErr + "\",\"errPos\":" + String(_compileErrPos);
+    Utils::setJsonBoolResult(respStr, _compileErr.length() == 0, jsonStr.c_str());
+}
+
 bool MotionHoming::getInteger(unsigned int &homingStrPos, int &retInt)
 {
     // Check for distance
@@ -139,74 +170,333 @@ bool MotionHoming::getInteger(unsigned int &homingStrPos, int &retInt)
     return false;
 }
 
-int MotionHoming::getFeedrate(unsigned int &homingStrPos, AxesParams &axesParams, int axisIdx, int defaultValue)
+// Feedrate as R (RPM of the axis) or S (steps per second) - returns false if neither is
+// present or the value isn't positive
+bool MotionHoming::getFeedrate(unsigned int &homingStrPos, AxesParams &axesParams, int axisIdx, int &feedrateStepsPerSec)
+{
+    char rateCh = toupper(_homingSequence.charAt(homingStrPos));
+    if ((rateCh != 'R') && (rateCh != 'S'))
+        return false;
+    homingStrPos++;
+    int newFeedrate = 0;
+    if (!getInteger(homingStrPos, newFeedrate) || (newFeedrate <= 0))
+        return false;
+    if (rateCh == 'R')
+        feedrateStepsPerSec = newFeedrate * axesParams.getStepsPerRot(axisIdx) / 60;
+    else
+        feedrateStepsPerSec = newFeedrate;
+    return true;
+}
+
+bool MotionHoming::compileError(unsigned int seqPos, const char *errMsg)
+{
+    _program.clear();
+    _compileErr = errMsg;
+    _compileErrPos = seqPos;
+    return false;
+}
+
+// Compile the homing sequence - returns false (with the error and its position) if invalid
+bool MotionHoming::compileSequence(AxesParams &axesParams)
 {
-    // Initially set to max rate
-    int feedrateStepsPerSec = defaultValue;
-    switch(_homingSequence.charAt(homingStrPos))
+    _program.clear();
+    _compileErr = "";
+    _compileErrPos = 0;
+    if (_homingSequence.length() == 0)
+        return true;
+
+    // Feedrate for the whole sequence (-1 for each axis's max rate) and the move being built
+    int seqFeedrate = -1;
+    HomingAxisSpec axisSpecs[RobotConsts::MAX_AXES];
+    uint32_t moveAxisBits = 0;
+    int moveFeedrate = 0;
+    bool moveCentring = false;
+    bool moveSeeks = false;
+    unsigned int moveSeqPos = 0;
+    bool doneFound = false;
+    unsigned int seqPos = 0;
+    while (seqPos < _homingSequence.length())
     {
-        case 'R':
-        case 'r':
+        unsigned int chPos = seqPos;
+        char ch = toupper(_homingSequence.charAt(seqPos));
+        if ((ch == ';') || (ch == ' '))
         {
-            homingStrPos++;
-            int newFeedrate = 0;
-            if (getInteger(homingStrPos, newFeedrate))
-            {
-                if (newFeedrate > 0)
-                    feedrateStepsPerSec = newFeedrate * axesParams.getStepsPerRot(axisIdx) / 60;
-            }
-            break;
+            seqPos++;
+            continue;
         }
-        case 'S':
-        case 's':
+        if (doneFound)
+            return compileError(chPos, "text after $");
+        switch (ch)
         {
-            homingStrPos++;
-            int newFeedrate = 0;
-            if (getInteger(homingStrPos, newFeedrate))
+            case '$': // All done ok
             {
-                if (newFeedrate > 0)
-                    feedrateStepsPerSec = newFeedrate;
+                if (moveAxisBits)
+                    return compileError(chPos, "move without #");
+                HomingInstr instr;
+                instr._type = HomingInstr::INSTR_DONE;
+                instr._seqPos = chPos;
+                _program.push_back(instr);
+                doneFound = true;
+                seqPos++;
+                break;
+            }
+            case '#': // Execute move
+            {
+                if (!moveAxisBits)
+                    return compileError(chPos, "# without a move");
+                if (moveCentring && moveSeeks)
+                    return compileError(chPos, "centring can't be combined with back-off");
+                addMoveInstrs(moveSeqPos, axisSpecs, moveAxisBits, moveFeedrate, moveCentring);
+                moveAxisBits = 0;
+                moveCentring = false;
+                moveSeeks = false;
+                seqPos++;
+                break;
+            }
+            case 'F': // Feedrate for whole homing (unless specifically overridden)
+            {
+                seqPos++;
+                if (!getFeedrate(seqPos, axesParams, 0, seqFeedrate))
+                    return compileError(chPos, "F needs R or S and a positive rate");
+                break;
+            }
+            case 'A': // Actuators
+            case 'B':
+            case 'C':
+            {
+                int axisIdx = ch - 'A';
+                if (axisIdx >= RobotConsts::MAX_AXES)
+                    return compileError(chPos, "axis not in this build (ROBOT_MAX_AXES)");
+                seqPos++;
+
+                // Axis is now home
+                if (_homingSequence.charAt(seqPos) == '=')
+                {
+                    seqPos++;
+                    if (toupper(_homingSequence.charAt(seqPos)) != 'H')
+                        return compileError(seqPos, "expected h after =");
+                    if (moveAxisBits)
+                        return compileError(chPos, "move without #");
+                    seqPos++;
+                    HomingInstr instr;
+                    instr._type = HomingInstr::INSTR_SET_HOME;
+                    instr._axisIdx = axisIdx;
+                    instr._seqPos = chPos;
+                    _program.push_back(instr);
+                    break;
+                }
+
+                // Steps to move (the default distance if none are given)
+                if (moveAxisBits & (1 << axisIdx))
+                    return compileError(chPos, "axis repeated in move");
+                HomingAxisSpec &spec = axisSpecs[axisIdx];
+                int stepsToMove = AxisParams::stepsForAxisHoming_default;
+                getInteger(seqPos, stepsToMove);
+                spec._steps = stepsToMove;
+                spec._endStopIdx = -1;
+                spec._endStopCheck = AxisMinMaxBools::END_STOP_NONE;
+                spec._backoffSteps = 0;
+                spec._latchRateStepsPerSec = 0;
+
+                // Feedrate is either max steps per second for this axis or a setting from the command
+                // string - the last axis in a move sets the move's feedrate
+                int feedrate = (seqFeedrate == -1) ? int(axesParams.getMaxStepRatePerSec(axisIdx)) : seqFeedrate;
+                unsigned int ratePos = seqPos;
+                char rateCh = toupper(_homingSequence.charAt(seqPos));
+                if (((rateCh == 'R') || (rateCh == 'S')) && !getFeedrate(seqPos, axesParams, axisIdx, feedrate))
+                    return compileError(ratePos, "rate must be positive");
+
+                // Centring
+                if (toupper(_homingSequence.charAt(seqPos)) == 'Q')
+                {
+                    moveCentring = true;
+                    seqPos++;
+                }
+
+                // End-stop check - N/X (upper case) for min/max hit, n/x for not hit
+                char endStopCh = _homingSequence.charAt(seqPos);
+                if ((toupper(endStopCh) == 'N') || (toupper(endStopCh) == 'X'))
+                {
+                    spec._endStopIdx = (toupper(endStopCh) == 'N') ? 0 : 1;
+                    spec._endStopCheck = isupper(endStopCh) ? AxisMinMaxBools::END_STOP_HIT : AxisMinMaxBools::END_STOP_NOT_HIT;
+                    seqPos++;
+                }
+
+                // Two-speed seek - /<back-off steps> then optionally the latch rate
+                if (_homingSequence.charAt(seqPos) == '/')
+                {
+                    if (spec._endStopCheck != AxisMinMaxBools::END_STOP_HIT)
+                        return compileError(seqPos, "back-off needs an end-stop hit check (N or X)");
+                    seqPos++;
+                    unsigned int backoffPos = seqPos;
+                    int backoffSteps = 0;
+                    if (!getInteger(seqPos, backoffSteps) || (backoffSteps <= 0))
+                        return compileError(backoffPos, "back-off steps must be positive");
+                    spec._backoffSteps = backoffSteps;
+                    spec._latchRateStepsPerSec = std::max(feedrate / HOMING_LATCH_RATE_DIV, 1);
+                    ratePos = seqPos;
+                    rateCh = toupper(_homingSequence.charAt(seqPos));
+                    if (((rateCh == 'R') || (rateCh == 'S')) && !getFeedrate(seqPos, axesParams, axisIdx, spec._latchRateStepsPerSec))
+                        return compileError(ratePos, "rate must be positive");
+                    moveSeeks = true;
+                }
+
+                // Add to move
+                if (!moveAxisBits)
+                    moveSeqPos = chPos;
+                moveAxisBits |= (1 << axisIdx);
+                moveFeedrate = feedrate;
+                break;
+            }
+            default:
+            {
+                return compileError(chPos, "unexpected character");
             }
-            break;
         }
     }
-    return feedrateStepsPerSec;
+    if (moveAxisBits)
+        return compileError(moveSeqPos, "move without #");
+    if (!doneFound)
+        return compileError(_homingSequence.length(), "missing $ at end");
+    return true;
 }
 
-void MotionHoming::setCentring(unsigned int &homingStrPos, int axisIdx)
+// Add a move - a move with back-off on any axis becomes a fast seek, a back-off and a slow latch
+void MotionHoming::addMoveInstrs(unsigned int seqPos, HomingAxisSpec *axisSpecs, uint32_t axisBits,
+            int feedrateStepsPerSec, bool centring)
 {
-    if ((_homingSequence.charAt(homingStrPos) == 'Q') || (_homingSequence.charAt(homingStrPos) == 'q'))
+    HomingInstr instr;
+    instr._type = HomingInstr::INSTR_MOVE;
+    instr._axisBits = axisBits;
+    instr._feedrateStepsPerSec = feedrateStepsPerSec;
+    instr._centring = centring;
+    instr._endStopRequiredBits = 0;
+    instr._axisIdx = 0;
+    instr._seqPos = seqPos;
+    int seekAxisIdx = -1;
+    uint32_t seekAxisBits = 0;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
     {
-        _doCentring = true;
-        homingStrPos++;
+        bool inMove = (axisBits & (1 << axisIdx)) != 0;
+        instr._steps[axisIdx] = inMove ? axisSpecs[axisIdx]._steps : 0;
+        instr._endStopIdx[axisIdx] = inMove ? axisSpecs[axisIdx]._endStopIdx : -1;
+        instr._endStopCheck[axisIdx] = inMove ? axisSpecs[axisIdx]._endStopCheck : AxisMinMaxBools::END_STOP_NONE;
+        if (inMove && (axisSpecs[axisIdx]._backoffSteps > 0))
+        {
+            seekAxisBits |= (1 << axisIdx);
+            if (seekAxisIdx < 0)
+                seekAxisIdx = axisIdx;
+        }
+    }
+    if (seekAxisIdx < 0)
+    {
+        _program.push_back(instr);
+        return;
     }
+
+    // Back off at the fast rate with no end-stop checks then latch slowly onto the end-stops -
+    // other axes in the move keep their ratio to the first seeking axis (e.g. to compensate
+    // for coupling between axes) and any end-stop checks of their own
+    // The seeking axes must reach their end-stops in the seek and in the latch
+    instr._endStopRequiredBits = seekAxisBits;
+    _program.push_back(instr);
+    HomingInstr backoffInstr = instr;
+    backoffInstr._endStopRequiredBits = 0;
+    HomingInstr latchInstr = instr;
+    int latchRate = 0;
+    int32_t refSteps = abs(axisSpecs[seekAxisIdx]._steps);
+    int32_t refBackoffSteps = axisSpecs[seekAxisIdx]._backoffSteps;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+    {
+        if (!(axisBits & (1 << axisIdx)))
+            continue;
+        const HomingAxisSpec &spec = axisSpecs[axisIdx];
+        backoffInstr._endStopIdx[axisIdx] = -1;
+        if (spec._backoffSteps > 0)
+        {
+            int32_t dirn = (spec._steps >= 0) ? 1 : -1;
+            backoffInstr._steps[axisIdx] = -dirn * spec._backoffSteps;
+            latchInstr._steps[axisIdx] = dirn * spec._backoffSteps * HOMING_LATCH_BACKOFF_MULT;
+            if ((latchRate == 0) || (spec._latchRateStepsPerSec < latchRate))
+                latchRate = spec._latchRateStepsPerSec;
+        }
+        else
+        {
+            int32_t scaledSteps = (refSteps == 0) ? 0 : int32_t(int64_t(spec._steps) * refBackoffSteps / refSteps);
+            backoffInstr._steps[axisIdx] = -scaledSteps;
+            latchInstr._steps[axisIdx] = scaledSteps * HOMING_LATCH_BACKOFF_MULT;
+        }
+    }
+    latchInstr._feedrateStepsPerSec = latchRate;
+    _program.push_back(backoffInstr);
+    _program.push_back(latchInstr);
 }
 
-void MotionHoming::setEndstops(unsigned int &homingStrPos, int axisIdx)
+// Execute instructions until a move is started - returns false when the sequence has ended
+bool MotionHoming::execNextInstr()
 {
-    // Endstops
-    // Log.notice("%stestingCh %c, speed %F, dist %F\n", MODULE_PREFIX, _homingSequence.charAt(_homingStrPos),
-    //             _curCommand.getFeedrate(), _curCommand.getValMM(axisIdx));
-    int endStopIdx = 0;
-    bool checkActive = false;
-    bool setEndstopTest = false;
-    if ((_homingSequence.charAt(homingStrPos) == 'X') || (_homingSequence.charAt(homingStrPos) == 'x') ||
-        (_homingSequence.charAt(homingStrPos) == 'N') || (_homingSequence.charAt(homingStrPos) == 'n'))
+    while (_programPos < _program.size())
     {
-        endStopIdx = ((_homingSequence.charAt(homingStrPos) == 'N') || (_homingSequence.charAt(homingStrPos) == 'n')) ? 0 : 1;
-        checkActive = (_homingSequence.charAt(homingStrPos) == 'X') || (_homingSequence.charAt(homingStrPos) == 'N');
-        homingStrPos++;
-        setEndstopTest = true;
+        const HomingInstr &instr = _program[_programPos++];
+        switch (instr._type)
+        {
+            case HomingInstr::INSTR_DONE:
+            {
+                Log.notice("%sHomed ok in %dms\n", MODULE_PREFIX, int(millis() - _homeReqMillis));
+                _isHomedOk = true;
+                return false;
+            }
+            case HomingInstr::INSTR_SET_HOME:
+            {
+                setAtHomePos(instr._axisIdx);
+                Log.notice("%sSetting at home for axis %d\n", MODULE_PREFIX, instr._axisIdx);
+                break;
+            }
+            case HomingInstr::INSTR_MOVE:
+            {
+                if (execMove(instr))
+                    return true;
+                break;
+            }
+        }
     }
-    // Check axis should be homed
-    if (setEndstopTest && (!_axesToHome.isValid(axisIdx)))
+    return false;
+}
+
+// Start a move for the axes being homed - returns false if none of the move's axes are being homed
+bool MotionHoming::execMove(const HomingInstr &instr)
+{
+    _curCommand.clear();
+    _curCommand.setIsHoming(true);
+    // All homing is relative
+    _curCommand.setMoveType(RobotMoveTypeArg_Relative);
+    _curCommand.setFeedrate(instr._feedrateStepsPerSec);
+    _curCommandEndStopRequiredBits = 0;
+    bool anyAxis = false;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
     {
-        Log.DBG_HOMING_LVL("%sAxis%d in sequence but not required to home\n", MODULE_PREFIX, axisIdx);
-        return;
+        if (!(instr._axisBits & (1 << axisIdx)))
+            continue;
+        if (!_axesToHome.isValid(axisIdx))
+        {
+            Log.DBG_HOMING_LVL("%sAxis%d in sequence but not required to home\n", MODULE_PREFIX, axisIdx);
+            continue;
+        }
+        _curCommand.setAxisSteps(axisIdx, instr._steps[axisIdx], true);
+        if (instr._endStopIdx[axisIdx] >= 0)
+            _curCommand.setTestEndStop(axisIdx, instr._endStopIdx[axisIdx], instr._endStopCheck[axisIdx]);
+        _curCommandEndStopRequiredBits |= instr._endStopRequiredBits & (1 << axisIdx);
+        anyAxis = true;
     }
-    // Check endStop
-    if (setEndstopTest)
-        _curCommand.setTestEndStop(axisIdx, endStopIdx, checkActive ? AxisMinMaxBools::END_STOP_HIT : AxisMinMaxBools::END_STOP_NOT_HIT);
+    if (!anyAxis)
+        return false;
+
+    // Handle the start of a centring operation
+    if (instr._centring)
+        startCentringOperation();
+    else
+        processHomingCommand(_curCommand);
+    return true;
 }
 
 void MotionHoming::startCentringOperation()
@@ -298,115 +588,11 @@ void MotionHoming::processHomingCommand(RobotCommandArgs& commandArgs)
     commandArgs.setNumberedCommandIndex(_homingCurCommandIndex);
     // Command complete so exec
     _commandInProgress = true;
+    _homingCmdStartMillis = millis();
     moveTo(commandArgs);
     Log.DBG_HOMING_LVL("%sexec command %s\n", MODULE_PREFIX, commandArgs.toJSON().c_str());
 }
 
-bool MotionHoming::extractAndExecNextCmd(AxesParams &axesParams, String& debugCmdStr)
-{
-    while (_homingStrPos < _homingSequence.length())
-    {
-        // Get axis
-        int ch = _homingSequence.charAt(_homingStrPos);
-        switch (ch)
-        {
-            case '$': // All done ok
-            {
-                // Check if homing commands complete
-                Log.notice("%sHomed ok\n", MODULE_PREFIX);
-                _isHomedOk = true;
-                _homingInProgress = false;
-                _commandInProgress = false;
-                _homingStrPos++;
-                _curCommand.setHasHomed(true);
-                debugCmdStr = "Done";
-                return true;
-            }
-            case '#': // Process command
-            {
-                // Handle the start of a centring operation
-                if (_doCentring)
-                    startCentringOperation();
-                else
-                    processHomingCommand(_curCommand);
-                _homingStrPos++;
-                _doCentring = false;
-                return true;
-            }
-            case 'A':
-            case 'a': // Actuators
-            case 'B':
-            case 'b':
-            case 'C':
-            case 'c':
-            {
-                // We're homing
-                _curCommand.setIsHoming(true);
-                // Axis index
-                int axisIdx = 0;
-                if ((ch == 'B') || (ch == 'b'))
-                    axisIdx = 1;
-                else if ((ch == 'C') || (ch == 'c'))
-                    axisIdx = 2;
-                // All homing is relative
-                _curCommand.setMoveType(RobotMoveTypeArg_Relative);
-                // Get the instruction
-                _homingStrPos++;
-                // See if we have an numeric value next
-                int stepsToMove = AxisParams::stepsForAxisHoming_default;
-                if (getInteger(_homingStrPos, stepsToMove))
-                {
-                    // Set dist to move
-                    if (_axesToHome.isValid(axisIdx))
-                        _curCommand.setAxisSteps(axisIdx, stepsToMove, true);
-                    // Set feedrate to either max steps per second for this axis or a setting from the command string
-                    int feedrateStepsPerSec = getFeedrate(_homingStrPos, axesParams, axisIdx, 
-                                (_feedrateStepsPerSecForHoming == -1) ? axesParams.getMaxStepRatePerSec(axisIdx) : _feedrateStepsPerSecForHoming);
-                    _curCommand.setFeedrate(feedrateStepsPerSec);
-                    // Check for centring mode
-                    setCentring(_homingStrPos, axisIdx);
-                    // Set endstop tests
-                    setEndstops(_homingStrPos, axisIdx);
-                    debugCmdStr = "Move";
-                }
-                // Maybe this is saying the axis is now home
-                else if (_homingSequence[_homingStrPos] == '=')
-                {
-                    _homingStrPos++;
-                    if ((_homingSequence.charAt(_homingStrPos) == 'H') || (_homingSequence.charAt(_homingStrPos) == 'h'))
-                    {
-                        setAtHomePos(axisIdx);
-                        _homingStrPos++;
-                        Log.notice("%sSetting at home for axis %d\n", MODULE_PREFIX, axisIdx);
-                        debugCmdStr = "Home";
-                    }
-                    break;
-                }
-                break;
-            }
-            case 'F':
-            case 'f':
-            {
-                // Feedrate for whole homing (unless specifically overridden)
-                _homingStrPos++;
-                int feedrateStepsPerSec = getFeedrate(_homingStrPos, axesParams, 0, axesParams.getMaxStepRatePerSec(0));
-                if (feedrateStepsPerSec > 0)
-                {
-                    _feedrateStepsPerSecForHoming = feedrateStepsPerSec;
-                }
-            }
-            default:
-            {
-                // Skip other chars (including ;)
-                _homingStrPos++;
-                break;
-            }
-        }
-    }
-    debugCmdStr = "";
-    return false;
-}
-
 void MotionHoming::moveTo(RobotCommandArgs &args)
 {
     _pMotionHelper->moveTo(args);
@@ -417,6 +603,11 @@ int MotionHoming::getLastCompletedNumberedCmdIdx()
     return _pMotionHelper->getLastCompletedNumberedCmdIdx();
 }
 
+uint32_t MotionHoming::getLastCompletedNumberedCmdEndStopHits()
+{
+    return _pMotionHelper->getLastCompletedNumberedCmdEndStopHits();
+}
+
 void MotionHoming::setAtHomePos(int axisIdx)
 {
     _pMotionHelper->setCurPositionAsHome(axisIdx);
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <vector>
 #include "RobotCommandArgs.h"
 #include "../AxesParams.h"
 
@@ -10,31 +11,76 @@ class MotionHelper;
 
 #define DBG_HOMING_LVL notice
 
+// The homing sequence (homing/homingSeq) is compiled into a list of instructions when the
+// robot is configured so errors are found before any motion - see README for the syntax
 class MotionHoming
 {
 private:
     static constexpr int maxHomingSecs_default = 1000;
     static constexpr int homing_baseCommandIndex = 10000;
 
+    // Two-speed seek - the slow latch moves this many times the back-off distance and runs at the
+    // fast rate divided by this (unless the latch rate is given)
+    static constexpr int HOMING_LATCH_BACKOFF_MULT = 2;
+    static constexpr int HOMING_LATCH_RATE_DIV = 10;
+
+    // Compiled homing instruction
+    struct HomingInstr
+    {
+        enum InstrType
+        {
+            INSTR_MOVE,
+            INSTR_SET_HOME,
+            INSTR_DONE
+        };
+        InstrType _type;
+        // Move - relative steps and end-stop check (index -1 for none) for each axis in the move
+        uint32_t _axisBits;
+        int32_t _steps[RobotConsts::MAX_AXES];
+        int _endStopIdx[RobotConsts::MAX_AXES];
+        AxisMinMaxBools::AxisMinMaxEnum _endStopCheck[RobotConsts::MAX_AXES];
+        int _feedrateStepsPerSec;
+        bool _centring;
+        // Axes which must stop at their end-stops (the seek and latch of a two-speed seek)
+        uint32_t _endStopRequiredBits;
+        // Set home
+        int _axisIdx;
+        // Position in the sequence (diagnostics)
+        unsigned int _seqPos;
+    };
+
+    // Axis part of a move while compiling - back-off steps of 0 means a single-speed move
+    struct HomingAxisSpec
+    {
+        int32_t _steps;
+        int _endStopIdx;
+        AxisMinMaxBools::AxisMinMaxEnum _endStopCheck;
+        int32_t _backoffSteps;
+        int _latchRateStepsPerSec;
+    };
+
     bool _isHomedOk;
     String _homingSequence;
+    std::vector<HomingInstr> _program;
+    unsigned int _programPos;
+    String _compileErr;
+    unsigned int _compileErrPos;
     bool _homingInProgress;
     RobotCommandArgs _axesToHome;
-    unsigned int _homingStrPos;
     bool _commandInProgress;
     RobotCommandArgs _curCommand;
+    uint32_t _curCommandEndStopRequiredBits;
     int _maxHomingSecs;
     unsigned long _homeReqMillis;
     MotionHelper *_pMotionHelper;
     int _homingCurCommandIndex;
-    int _feedrateStepsPerSecForHoming;
 
     // Homing diagnostics
     AxisInt32s _homingStartSteps;
+    unsigned long _homingCmdStartMillis;
 
     // Centring
     static const int NUM_CENTRING_PHASES = 6;
-    bool _doCentring;
     bool _centringInProgress;
     int _centringPhase;
     AxisInt32s _centringSteps[NUM_CENTRING_PHASES];
@@ -42,21 +88,26 @@ private:
 
 public:
     MotionHoming(MotionHelper *pMotionHelper);
-    void configure(const char *configJSON);
+    void configure(const char *configJSON, AxesParams &axesParams);
     bool isHomingInProgress();
     bool isHomedOk();
     void homingStart(RobotCommandArgs &args);
-    void service(AxesParams &axesParams);
-    bool extractAndExecNextCmd(AxesParams &axesParams, String& debugCmdStr);
+    void service();
+    void getStatusJSON(String &respStr);
 
 private:
+    bool compileSequence(AxesParams &axesParams);
+    bool compileError(unsigned int seqPos, const char *errMsg);
+    void addMoveInstrs(unsigned int seqPos, HomingAxisSpec *axisSpecs, uint32_t axisBits,
+                int feedrateStepsPerSec, bool centring);
+    bool execNextInstr();
+    bool execMove(const HomingInstr &instr);
     void moveTo(RobotCommandArgs &args);
     int getLastCompletedNumberedCmdIdx();
+    uint32_t getLastCompletedNumberedCmdEndStopHits();
     void setAtHomePos(int axisIdx);
     bool getInteger(unsigned int &homingStrPos, int &retInt);
-    int getFeedrate(unsigned int &homingStrPos, AxesParams &axesParams, int axisIdx, int defaultValue);
-    void setEndstops(unsigned int &homingStrPos, int axisIdx);
-    void setCentring(unsigned int &homingStrPos, int axisIdx);
+    bool getFeedrate(unsigned int &homingStrPos, AxesParams &axesParams, int axisIdx, int &feedrateStepsPerSec);
     void startCentringOperation();
     bool nextCentringOperation();
     void processHomingCommand(RobotCommandArgs& commandArgs);
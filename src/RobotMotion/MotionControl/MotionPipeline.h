@@ -32,9 +32,21 @@ class MotionPipeline
 
     unsigned int count()
     {
+#ifdef UNIT_TEST
+        // Blocks removed (as if by the ISR) just after the count is read
+        unsigned int numBlocks = _pipelinePosn.count();
+        for (; _testRemovesAfterCount > 0; _testRemovesAfterCount--)
+            remove();
+        return numBlocks;
+#else
         return _pipelinePosn.count();
+#endif
     }
 
+#ifdef UNIT_TEST
+    unsigned int _testRemovesAfterCount = 0;
+#endif
+
     // Check if ready to accept data
     bool canAccept()
     {
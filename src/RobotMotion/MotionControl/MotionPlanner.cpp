@@ -3,22 +3,31 @@
 
 #include "MotionPlanner.h"
 
-void MotionPlanner::configure(float junctionDeviation)
+void MotionPlanner::configure(float junctionDeviation, float junctionMaxRateChange, bool actuatorLimits, float pathSpeedMMps)
 {
     _junctionDeviation = junctionDeviation;
+    _junctionMaxRateChange = junctionMaxRateChange;
+    _actuatorLimits = actuatorLimits;
+    _pathSpeedMMps = pathSpeedMMps;
 }
 
 // Entry point for adding a motion block
 bool MotionPlanner::moveTo(RobotCommandArgs &args,
             AxisFloats &destActuatorCoords,
             AxisPosition &curAxisPositions,
-            AxesParams &axesParams, MotionPipeline &motionPipeline)
+            AxesParams &axesParams, MotionPipeline &motionPipeline,
+            const MotionPathCurve* pCurve)
 {
     // Find first primary axis
     int firstPrimaryAxis = -1;
     for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+    {
         if (axesParams.isPrimaryAxis(axisIdx))
+        {
             firstPrimaryAxis = axisIdx;
+            break;
+        }
+    }
     if (firstPrimaryAxis == -1)
         firstPrimaryAxis = 0;
 
@@ -44,8 +53,14 @@ bool MotionPlanner::moveTo(RobotCommandArgs &args,
             axisWithMaxMoveDist = axisIdx;
     }
 
-    // Distance being moved
+    // Distance being moved (curved moves may end where they started)
     float moveDist = sqrtf(squareSum);
+    if (pCurve)
+    {
+        moveDist = pCurve->_pathLenMM;
+        isAMove = isAMove || (moveDist > 0);
+        isAPrimaryMove = isAPrimaryMove || (moveDist > 0);
+    }
 
     // Ignore if there is no real movement
     if (!isAMove || moveDist < MotionBlock::MINIMUM_MOVE_DIST_MM)
@@ -68,18 +83,26 @@ bool MotionPlanner::moveTo(RobotCommandArgs &args,
     if (args.isFeedrateValid())
         validFeedrateMMps = args.getFeedrate();
 
-    // Check the feedrate against the first primary axis
-    if (validFeedrateMMps > axesParams.getMaxSpeed(firstPrimaryAxis))
-        validFeedrateMMps = axesParams.getMaxSpeed(firstPrimaryAxis);
+    // Check the feedrate against the first primary axis - when actuator limits are used the
+    // axis max speed may not be a speed in mm/s so the target path speed (if any) applies instead
+    float maxSpeedMMps = axesParams.getMaxSpeed(firstPrimaryAxis);
+    if (_actuatorLimits)
+        maxSpeedMMps = (_pathSpeedMMps > 0) ? _pathSpeedMMps : validFeedrateMMps;
+    if (validFeedrateMMps > maxSpeedMMps)
+        validFeedrateMMps = maxSpeedMMps;
 
     // Find the unit vectors for the primary axes and check the feedrate
+    // For a curve the junction with the previous block uses the direction at the start
+    // and the junction with the next block the direction at the end
     AxisFloats unitVectors;
+    AxisFloats exitUnitVectors;
     for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
     {
         if (axesParams.isPrimaryAxis(axisIdx))
         {
             // Unit vector calculation
-            unitVectors._pt[axisIdx] = deltas[axisIdx] / moveDist;
+            unitVectors._pt[axisIdx] = pCurve ? pCurve->_entryUnitVec._pt[axisIdx] : deltas[axisIdx] / moveDist;
+            exitUnitVectors._pt[axisIdx] = pCurve ? pCurve->_exitUnitVec._pt[axisIdx] : unitVectors._pt[axisIdx];
         }
     }
 
@@ -88,16 +111,23 @@ bool MotionPlanner::moveTo(RobotCommandArgs &args,
     block._moveDistPrimaryAxesMM = moveDist;
 
     // Find if there are any steps
+    // The unrounded steps (from the unrounded end of the previous block) are kept for the
+    // junction step rate checks as rounding short blocks to whole steps changes their rates
     bool hasSteps = false;
+    AxisFloats unroundedSteps;
+    AxisFloats stepRoundingCarry;
     for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
     {
         // Check if any steps to perform
         float stepsFloat = destActuatorCoords._pt[axisIdx] - curAxisPositions._stepsFromHome.vals[axisIdx];
-        int32_t steps = int32_t(ceilf(stepsFloat));
+        int32_t steps = int32_t(roundf(stepsFloat));
         if (steps != 0)
             hasSteps = true;
         // Value (and direction)
         block.setStepsToTarget(axisIdx, steps);
+        float prevCarry = _prevMotionBlockValid ? _prevMotionBlock._stepRoundingCarry._pt[axisIdx] : 0;
+        unroundedSteps._pt[axisIdx] = stepsFloat - prevCarry;
+        stepRoundingCarry._pt[axisIdx] = stepsFloat - steps;
     }
 
 #ifdef DEBUG_MOTIONPLANNER_DETAILED_INFO
@@ -112,6 +142,24 @@ bool MotionPlanner::moveTo(RobotCommandArgs &args,
     if (!hasSteps)
         return false;
 
+    // Limit speed and acceleration so that no actuator exceeds its own limits (each axis has its
+    // own max step rate and acceleration) - after a non-linear transform (e.g. polar) the actuator
+    // moving fastest varies along the path
+    // With actuator limits the path acceleration isn't also capped by the master axis maxAcc
+    AxisFloats stepsPerMM;
+    float maxAccMMps2 = _actuatorLimits ? 1e8 : axesParams._masterAxisMaxAccMMps2;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+    {
+        stepsPerMM._pt[axisIdx] = unroundedSteps._pt[axisIdx] / moveDist;
+        float absSteps = fabsf(block.getStepsToTarget(axisIdx));
+        if (absSteps == 0)
+            continue;
+        float mmPerStep = moveDist / absSteps;
+        block._feedrate = fminf(block._feedrate, axesParams.getMaxStepRatePerSec(axisIdx) * mmPerStep);
+        maxAccMMps2 = fminf(maxAccMMps2, axesParams.getMaxStepAccPerSec2(axisIdx) * mmPerStep);
+    }
+    block._maxAccMMps2 = maxAccMMps2;
+
     // Set the dist moved on the axis with max steps
     block._unitVecAxisWithMaxDist = unitVectors.getVal(axisWithMaxMoveDist);
 
@@ -122,7 +170,10 @@ bool MotionPlanner::moveTo(RobotCommandArgs &args,
 
     // Invalidate the data stored for the prev element if the pipeline becomes empty
     if (!motionPipeline.canGet())
+    {
         _prevMotionBlockValid = false;
+        _plannedBlockFromPut = -1;
+    }
 
     // Calculate the maximum speed for the junction between two blocks
     if (isAPrimaryMove && _prevMotionBlockValid)
@@ -145,11 +196,21 @@ bool MotionPlanner::moveTo(RobotCommandArgs &args,
                     // Trig half angle identity, always positive
                     float sinThetaD2 = sqrtf(0.5F * (1.0F - cosTheta));
                     vmaxJunction = fminf(vmaxJunction,
-                                            sqrtf(axesParams._masterAxisMaxAccMMps2 * junctionDeviation * sinThetaD2 /
+                                            sqrtf(blockMaxAccel(&block, axesParams) * junctionDeviation * sinThetaD2 /
                                                 (1.0F - sinThetaD2)));
                 }
             }
         }
+
+        // A change of direction in actuator space changes the actuators' step rates instantly so
+        // limit the change for each actuator to a fraction of its max step rate
+        for (int axisIdx = 0; (axisIdx < RobotConsts::MAX_AXES) && (_junctionMaxRateChange > 0); axisIdx++)
+        {
+            float rateChangePerMMps = fabsf(stepsPerMM._pt[axisIdx] - _prevMotionBlock._stepsPerMM._pt[axisIdx]);
+            if (rateChangePerMMps > 0)
+                vmaxJunction = fminf(vmaxJunction, axesParams.getMaxStepRatePerSec(axisIdx) * 
+                                _junctionMaxRateChange / rateChangePerMMps);
+        }
     }
     block._maxEntrySpeedMMps = vmaxJunction;
 
@@ -160,9 +221,13 @@ bool MotionPlanner::moveTo(RobotCommandArgs &args,
 
     // Add the element to the pipeline and remember previous element
     motionPipeline.add(block);
+    if (_plannedBlockFromPut >= 0)
+        _plannedBlockFromPut++;
     MotionBlockSequentialData prevBlockInfo;
     prevBlockInfo._maxParamSpeedMMps = block._feedrate;
-    prevBlockInfo._unitVectors = unitVectors;
+    prevBlockInfo._unitVectors = exitUnitVectors;
+    prevBlockInfo._stepsPerMM = stepsPerMM;
+    prevBlockInfo._stepRoundingCarry = stepRoundingCarry;
     _prevMotionBlock = prevBlockInfo;
     _prevMotionBlockValid = true;
 
@@ -197,122 +262,125 @@ void MotionPlanner::debugDumpQueue(const char *comStr, MotionPipeline &motionPip
 void MotionPlanner::recalculatePipeline(MotionPipeline &motionPipeline, AxesParams &axesParams)
 {
     // The last block in the pipe (most recently added) will have zero exit speed
-    // For each block, walking backwards in the queue :
+    // Only blocks after the "planned" block need to be considered - the planned block is the
+    // last one whose entry speed can't be improved (it is at its max entry speed, is limited
+    // by acceleration from the block before or is locked for execution)
+    // For each block after the planned block, walking backwards in the queue :
     //    We know the desired exit speed so calculate the entry speed using v^2 = u^2 + 2*a*s
-    //    Set the exit speed for the previous block from this entry speed
-    // Then walk forward in the queue starting with the first block that can be changed:
-    //    Set the entry speed from the previous block (or to 0 if none)
-    //    Calculate the max possible exit speed for the block using the same formula as above
-    //    Set the entry speed for the next block using this exit speed
-    // Finally prepare the block for stepper motor actuation
+    // Then walk forward in the queue starting with the planned block:
+    //    Limit the entry speed of the next block to the speed reachable by accelerating
+    //    Set the exit speed of the block to the entry speed of the next block
+    //    Move the planned block on if the next block's entry speed is now optimal
+    // Finally prepare the blocks from the planned block onwards for stepper motor actuation
 
 #ifdef DEBUG_MOTIONPLANNER_DETAILED_INFO
     Log.notice("^^^^^^^^^^^^^^^^^^^^^^^BEFORE RECALC^^^^^^^^^^^^^^^^^^^^^^^^\n");
     motionPipeline.debugShowBlocks(axesParams);
 #endif
 
-    // Iterate the block queue in backwards time order stopping at the first block that has its recalculateFlag false
-    int blockIdx = 0;
-    int earliestBlockToReprocess = -1;
-    float previousBlockExitSpeed = 0;
+    // If the planned block has been executed then the oldest block is the planned one as its
+    // entry speed can't be changed now the block before it has gone
+    int numBlocks = motionPipeline.count();
+    if (numBlocks == 0)
+        return;
+    int plannedIdx = _plannedBlockFromPut;
+    if ((plannedIdx < 0) || (plannedIdx >= numBlocks))
+        plannedIdx = numBlocks - 1;
+
+    // Iterate the block queue in backwards time order stopping at the planned block
+    // or a locked block (which then becomes the planned block)
     float followingBlockEntrySpeed = 0;
-    MotionBlock *pBlock = NULL;
-    MotionBlock *pFollowingBlock = NULL;
-    while (true)
+    int blockIdx = 0;
+    int lastUnlockedIdx = -1;
+    for (blockIdx = 0; blockIdx < plannedIdx; blockIdx++)
     {
-        // Get the block at current index
-        pBlock = motionPipeline.peekNthFromPut(blockIdx);
-        if (pBlock == NULL)
+        MotionBlock *pBlock = motionPipeline.peekNthFromPut(blockIdx);
+        if (!pBlock)
+            break;
+        if (pBlock->isLocked())
             break;
+        lastUnlockedIdx = blockIdx;
 
-        // Stop if we don't need to recalculate beyond here or if this block is already executing
-        if (pBlock->_isExecuting)
+        // Max speed we can enter with and still slow to the exit speed - there is no need to
+        // recalculate if the block is already at its maximum entry speed
+        if ((blockIdx == 0) || (pBlock->_entrySpeedMMps != pBlock->_maxEntrySpeedMMps))
         {
-            // Get the exit speed from this executing block to use as the entry speed when going forwards
-            previousBlockExitSpeed = pBlock->_exitSpeedMMps;
-            break;
+            float maxEntrySpeed = MotionBlock::maxAchievableSpeed(blockMaxAccel(pBlock, axesParams),
+                                                    followingBlockEntrySpeed, pBlock->_moveDistPrimaryAxesMM);
+            pBlock->_entrySpeedMMps = fminf(maxEntrySpeed, pBlock->_maxEntrySpeedMMps);
         }
+        followingBlockEntrySpeed = pBlock->_entrySpeedMMps;
+    }
+
+    // The ISR can remove the oldest block after the count is read - if the block the walk
+    // stopped at has gone then the last block found is the planned one
+    if (!motionPipeline.peekNthFromPut(blockIdx))
+        blockIdx = lastUnlockedIdx;
+    if (blockIdx < 0)
+        return;
+    plannedIdx = blockIdx;
 
-        // If entry speed is already at the maximum entry speed then we can stop here as no further changes are
-        // going to be made by going back further
-        if (pBlock->_entrySpeedMMps == pBlock->_maxEntrySpeedMMps && blockIdx > 1)
+    // Now iterate in forward time order from the planned block
+    int newPlannedIdx = plannedIdx;
+    MotionBlock *pBlock = motionPipeline.peekNthFromPut(plannedIdx);
+    for (blockIdx = plannedIdx - 1; (blockIdx >= 0) && pBlock; blockIdx--)
+    {
+        MotionBlock *pNextBlock = motionPipeline.peekNthFromPut(blockIdx);
+        if (!pNextBlock)
+            continue;
+        if (pNextBlock->isLocked())
         {
-#ifdef DEBUG_MOTIONPLANNER_DETAILED_INFO
-            Log.notice("++++++++++++++++++++++++++++++ Optimizing block %d, prevSpeed %F\n", blockIdx, pBlock->_exitSpeedMMps);
-#endif
-            //Get the exit speed from this block to use as the entry speed when going forwards
-            previousBlockExitSpeed = pBlock->_exitSpeedMMps;
-            break;
+            // Blocks locked for execution after the planned block are already compiled
+            newPlannedIdx = blockIdx;
+            pBlock = pNextBlock;
+            continue;
         }
 
-        // If there was a following block (remember we're working backwards) then now set the entry speed
-        if (pFollowingBlock)
+        if (pBlock->isLocked())
         {
-            // Assume for now that that whole block will be deceleration and calculate the max speed we can enter to be able to slow
-            // to the exit speed required
-            float maxEntrySpeed = MotionBlock::maxAchievableSpeed(axesParams._masterAxisMaxAccMMps2,
-                                                                    pFollowingBlock->_exitSpeedMMps, pFollowingBlock->_moveDistPrimaryAxesMM);
-            pFollowingBlock->_entrySpeedMMps = fminf(maxEntrySpeed, pFollowingBlock->_maxEntrySpeedMMps);
-
-            // Remember entry speed (to use as exit speed in the next loop)
-            followingBlockEntrySpeed = pFollowingBlock->_entrySpeedMMps;
+            // The exit speed of a locked block can't be changed
+            pNextBlock->_entrySpeedMMps = pBlock->_exitSpeedMMps;
+            newPlannedIdx = blockIdx;
         }
-
-        // Remember the following block for the next pass
-        pFollowingBlock = pBlock;
-
-        // Set the block's exit speed to the entry speed of the block after this one
-        pBlock->_exitSpeedMMps = followingBlockEntrySpeed;
-
-        // Remember this as the earliest block to reprocess when going forwards
-        earliestBlockToReprocess = blockIdx;
-
-        // Next
-        blockIdx++;
-    }
-
-    // Now iterate in forward time order
-    for (blockIdx = earliestBlockToReprocess; blockIdx >= 0; blockIdx--)
-    {
-        // Get the block to calculate for
-        pBlock = motionPipeline.peekNthFromPut(blockIdx);
-        if (!pBlock)
-            break;
-
-        // Set the entry speed to the previous block exit speed
-        // if (pBlock->_entrySpeedMMps > previousBlockExitSpeed)
-        pBlock->_entrySpeedMMps = previousBlockExitSpeed;
-
-        // Calculate maximum speed possible for the block - based on acceleration at the best rate
-        float maxExitSpeed = pBlock->maxAchievableSpeed(axesParams._masterAxisMaxAccMMps2,
+        else
+        {
+            // Limit the next block's entry speed to that reachable with maximum acceleration
+            if (pBlock->_entrySpeedMMps < pNextBlock->_entrySpeedMMps)
+            {
+                float maxExitSpeed = MotionBlock::maxAchievableSpeed(blockMaxAccel(pBlock, axesParams),
                                                         pBlock->_entrySpeedMMps, pBlock->_moveDistPrimaryAxesMM);
-        pBlock->_exitSpeedMMps = fminf(maxExitSpeed, pBlock->_exitSpeedMMps);
-
-        // Remember for next block
-        previousBlockExitSpeed = pBlock->_exitSpeedMMps;
+                if (maxExitSpeed < pNextBlock->_entrySpeedMMps)
+                {
+                    pNextBlock->_entrySpeedMMps = maxExitSpeed;
+                    newPlannedIdx = blockIdx;
+                }
+            }
+            if (pNextBlock->_entrySpeedMMps == pNextBlock->_maxEntrySpeedMMps)
+                newPlannedIdx = blockIdx;
+            pBlock->_exitSpeedMMps = pNextBlock->_entrySpeedMMps;
+        }
+        pBlock = pNextBlock;
     }
+    if (pBlock && !pBlock->isLocked())
+        pBlock->_exitSpeedMMps = 0;
 
-    // Recalculate acceleration and deceleration curves
-    for (blockIdx = earliestBlockToReprocess; blockIdx >= 0; blockIdx--)
+    // Recalculate acceleration and deceleration curves (the planned block's exit speed may have changed)
+    for (blockIdx = plannedIdx; blockIdx >= 0; blockIdx--)
     {
-        // Get the block to calculate for
+        // Get the block to calculate for - blocks being executed can't be changed
         pBlock = motionPipeline.peekNthFromPut(blockIdx);
-        if (!pBlock)
-            break;
-
-        // Prepare this block for stepping
+        if (!pBlock || pBlock->isLocked())
+            continue;
+
+        // Prepare this block for stepping (stepwise blocks are prepared when added)
+        // Blocks can execute as soon as they are prepared - the start of motion is held by
+        // MotionHelper until enough blocks are buffered
+        if (pBlock->_isStepwise)
+            continue;
         if (pBlock->prepareForStepping(axesParams, false))
-        {
-            // Check if the block is part of a split block and has at least one more block following it
-            // in which case wait until at least two blocks are in the pipeline before locking down the
-            // first so that acceleration can be allowed to happen more smoothly
-            if ((!pBlock->_blockIsFollowed) || (motionPipeline.count() > 1))
-            {
-                // No more changes
-                pBlock->_canExecute = true;
-            }
-        }
+            pBlock->_canExecute = true;
     }
+    _plannedBlockFromPut = newPlannedIdx;
 
 #ifdef DEBUG_MOTIONPLANNER_DETAILED_INFO
     Log.notice(".................AFTER RECALC.......................\n");
@@ -329,6 +397,7 @@ bool MotionPlanner::moveToStepwise(RobotCommandArgs &args,
 {
     // Create a block for this movement which will end up on the pipeline
     MotionBlock block;
+    block._isStepwise = true;
     block._entrySpeedMMps = 0;
     block._exitSpeedMMps = 0;
 
@@ -383,9 +452,11 @@ bool MotionPlanner::moveToStepwise(RobotCommandArgs &args,
         block._canExecute = true;
     }
 
-    // Add the block
+    // Add the block - it starts and ends stationary so it is the planned block and the next
+    // block starts from stationary (there is no junction with a stepwise block)
     motionPipeline.add(block);
-    _prevMotionBlockValid = true;
+    _prevMotionBlockValid = false;
+    _plannedBlockFromPut = 0;
 
     // Return the change in actuator position
     for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
@@ -18,6 +18,18 @@ typedef void (*actuatorToPtFnType)(AxisInt32s &targetActuator, AxisFloats &outPt
 typedef void (*correctStepOverflowFnType)(AxisPosition &curPos, AxesParams &axesParams);
 typedef void (*convertCoordsFnType)(RobotCommandArgs& cmdArgs, AxesParams &axesParams);
 typedef void (*setRobotAttributesFnType)(AxesParams& axesParams, String& robotAttributes);
+typedef bool (*ptToActuatorPolarFnType)(AxisFloats &targetPt, float sweepDegs, AxisFloats &outActuator, AxisPosition &curPos, AxesParams &axesParams, bool allowOutOfBounds);
+typedef void (*actuatorFloatsToPtFnType)(AxisFloats &targetActuator, AxisFloats &outPt, AxisPosition &curPos, AxesParams &axesParams);
+
+// Shape of a move which isn't a straight line in cartesian space (e.g. a theta-rho segment)
+// The planner normally uses the straight line between the end points for both the length
+// of the block and the junction angles
+struct MotionPathCurve
+{
+    float _pathLenMM;
+    AxisFloats _entryUnitVec;
+    AxisFloats _exitUnitVec;
+};
 
 class MotionPlanner
 {
@@ -26,33 +38,55 @@ class MotionPlanner
     float _minimumPlannerSpeedMMps;
     // Junction deviation
     float _junctionDeviation;
+    // The instant change in an actuator's step rate at a junction is limited to this fraction
+    // of its max step rate (0 for no limit)
+    float _junctionMaxRateChange;
+    // Limit speed and acceleration of each block only by the limits of each actuator (rather than
+    // also by the master axis maxSpeed and maxAcc) and the target speed along the path (0 if only
+    // limited by the actuators)
+    bool _actuatorLimits;
+    float _pathSpeedMMps;
 
     // Structure to store details on last processed block
     struct MotionBlockSequentialData
     {
         AxisFloats _unitVectors;
+        AxisFloats _stepsPerMM;
+        // Difference between the unrounded actuator position at the end of the block and
+        // the whole steps moved to
+        AxisFloats _stepRoundingCarry;
         float _maxParamSpeedMMps;
     };
     // Data on previously processed block
     bool _prevMotionBlockValid;
     MotionBlockSequentialData _prevMotionBlock;
 
+    // Position (counting back from the most recently added block) of the last block whose entry
+    // speed can no longer be improved - blocks up to and including this one are not re-planned
+    // -1 if no block has been planned
+    int _plannedBlockFromPut;
+
   public:
     MotionPlanner()
     {
         _prevMotionBlockValid = false;
+        _plannedBlockFromPut = -1;
         _minimumPlannerSpeedMMps = 0;
         // Configure the motion pipeline - these values will be changed in config
         _junctionDeviation = 0;
+        _junctionMaxRateChange = 0;
+        _actuatorLimits = false;
+        _pathSpeedMMps = 0;
     }
 
-    void configure(float junctionDeviation);
+    void configure(float junctionDeviation, float junctionMaxRateChange, bool actuatorLimits, float pathSpeedMMps);
 
     // Entry point for adding a motion block
     bool moveTo(RobotCommandArgs &args,
                 AxisFloats &destActuatorCoords,
                 AxisPosition &curAxisPositions,
-                AxesParams &axesParams, MotionPipeline &motionPipeline);
+                AxesParams &axesParams, MotionPipeline &motionPipeline,
+                const MotionPathCurve* pCurve = NULL);
 
     void debugDumpQueue(const char *comStr, MotionPipeline &motionPipeline, unsigned int minQLen);
 
@@ -62,4 +96,11 @@ class MotionPlanner
     bool moveToStepwise(RobotCommandArgs &args,
                         AxisPosition &curAxisPositions,
                         AxesParams &axesParams, MotionPipeline &motionPipeline);
+
+  private:
+    // Acceleration used for planning a block
+    float blockMaxAccel(MotionBlock* pBlock, AxesParams &axesParams)
+    {
+        return (pBlock->_maxAccMMps2 > 0) ? pBlock->_maxAccMMps2 : axesParams._masterAxisMaxAccMMps2;
+    }
 };
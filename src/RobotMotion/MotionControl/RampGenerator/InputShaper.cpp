@@ -0,0 +1,209 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#include "InputShaper.h"
+#include <ArduinoLog.h>
+#include "RdJson.h"
+#include "math.h"
+
+static const char* MODULE_PREFIX = "InputShaper: ";
+
+InputShaper::InputShaper()
+{
+    clear();
+}
+
+void InputShaper::clear()
+{
+    _shapedAxesBits = 0;
+    _configuredAxesBits = 0;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+    {
+        AxisShaper& axis = _axes[axisIdx];
+        axis._type = SHAPER_NONE;
+        axis._freqHz = 0;
+        axis._damping = 0;
+        axis._numImpulses = 0;
+        axis._cmdSteps.clear();
+        axis._cmdSteps.shrink_to_fit();
+        resetAxisState(axis);
+    }
+}
+
+void IRAM_ATTR InputShaper::resetAxisState(AxisShaper& axis)
+{
+    axis._putSeq = 0;
+    for (int i = 0; i < MAX_IMPULSES; i++)
+    {
+        axis._impulseSeq[i] = 0;
+        axis._impulsePos[i] = 0;
+    }
+    axis._cmdPos = 0;
+    axis._outPos = 0;
+    axis._outDirnValid = false;
+    axis._outDirnPositive = false;
+}
+
+void InputShaper::configureAxis(int axisIdx, const char* axisJSON, uint32_t tickNs)
+{
+    if ((axisIdx < 0) || (axisIdx >= RobotConsts::MAX_AXES))
+        return;
+    AxisShaper& axis = _axes[axisIdx];
+    _configuredAxesBits &= ~(1 << axisIdx);
+    _shapedAxesBits &= ~(1 << axisIdx);
+    axis._type = SHAPER_NONE;
+    axis._numImpulses = 0;
+    resetAxisState(axis);
+
+    // Shaper type and resonance
+    String shaperStr = RdJson::getString("shaper", "none", axisJSON);
+    if (shaperStr.equalsIgnoreCase("zv"))
+        axis._type = SHAPER_ZV;
+    else if (shaperStr.equalsIgnoreCase("zvd"))
+        axis._type = SHAPER_ZVD;
+    axis._freqHz = float(RdJson::getDouble("shaperFreqHz", 0, axisJSON));
+    axis._damping = float(RdJson::getDouble("shaperDamping", DAMPING_DEFAULT, axisJSON));
+    if ((axis._type == SHAPER_NONE) || (axis._freqHz < FREQ_HZ_MIN) || (tickNs == 0))
+    {
+        axis._type = SHAPER_NONE;
+        axis._cmdSteps.clear();
+        axis._cmdSteps.shrink_to_fit();
+        return;
+    }
+    axis._damping = std::max(std::min(axis._damping, DAMPING_MAX), 0.0f);
+
+    // Impulses are at multiples of half the damped period with amplitudes scaled by the
+    // decay of the vibration over half a period (K)
+    float dampedRoot = sqrtf(1 - axis._damping * axis._damping);
+    float halfPeriodSecs = 0.5f / (axis._freqHz * dampedRoot);
+    float k = expf(-axis._damping * float(M_PI) / dampedRoot);
+    if (axis._type == SHAPER_ZV)
+    {
+        axis._numImpulses = 2;
+        axis._ampl[0] = 1 / (1 + k);
+        axis._ampl[1] = k / (1 + k);
+    }
+    else
+    {
+        axis._numImpulses = 3;
+        float denom = 1 + 2 * k + k * k;
+        axis._ampl[0] = 1 / denom;
+        axis._ampl[1] = 2 * k / denom;
+        axis._ampl[2] = k * k / denom;
+    }
+    uint32_t amplSumQ16 = 0;
+    for (int i = 0; i < axis._numImpulses; i++)
+    {
+        axis._timeSecs[i] = halfPeriodSecs * i;
+        axis._delayTicks[i] = uint32_t(axis._timeSecs[i] * 1e9f / tickNs + 0.5f);
+        axis._amplQ16[i] = uint32_t(axis._ampl[i] * 65536 + 0.5f);
+        amplSumQ16 += axis._amplQ16[i];
+    }
+    // Amplitudes must sum to exactly one so the axis ends where it was commanded
+    axis._amplQ16[0] += 65536 - amplSumQ16;
+
+    // The ring holds the commanded steps made in the longest delay at the max step rate
+    float maxStepRatePerSec = float(RdJson::getDouble("maxRPM", 300, axisJSON)) *
+                    float(RdJson::getDouble("stepsPerRot", 1, axisJSON)) / 60;
+    float maxDelaySecs = axis._timeSecs[axis._numImpulses - 1];
+    uint32_t ringLen = uint32_t(maxStepRatePerSec * maxDelaySecs * 1.5f) + 32;
+    axis._cmdSteps.assign(ringLen, 0);
+    _configuredAxesBits |= (1 << axisIdx);
+
+    Log.notice("%sAxis%d %s freq %FHz damping %F delay %dms ring %d residual vibration %F%% (%F%% at -%d%% freq, %F%% at +%d%%)\n",
+                MODULE_PREFIX, axisIdx, axis._type == SHAPER_ZV ? "ZV" : "ZVD",
+                axis._freqHz, axis._damping, int(maxDelaySecs * 1000), ringLen,
+                residualVibration(axisIdx, axis._freqHz) * 100,
+                residualVibration(axisIdx, axis._freqHz * (1 - FREQ_ERROR_REPORT)) * 100, int(FREQ_ERROR_REPORT * 100),
+                residualVibration(axisIdx, axis._freqHz * (1 + FREQ_ERROR_REPORT)) * 100, int(FREQ_ERROR_REPORT * 100));
+}
+
+void IRAM_ATTR InputShaper::cmdStep(int axisIdx, bool dirnPositive, uint32_t tick)
+{
+    AxisShaper& axis = _axes[axisIdx];
+    uint32_t ringLen = axis._cmdSteps.size();
+
+    // If the ring is full the most delayed impulses take their oldest steps early
+    int lastImpulse = axis._numImpulses - 1;
+    for (int i = lastImpulse; i > 0; i--)
+    {
+        if (axis._putSeq - axis._impulseSeq[i] < ringLen)
+            break;
+        uint32_t cmdStep = axis._cmdSteps[axis._impulseSeq[i] % ringLen];
+        axis._impulsePos[i] += (cmdStep & 1) ? 1 : -1;
+        axis._impulseSeq[i]++;
+    }
+    axis._cmdSteps[axis._putSeq % ringLen] = (tick << 1) | (dirnPositive ? 1 : 0);
+    axis._putSeq++;
+    axis._cmdPos += dirnPositive ? 1 : -1;
+}
+
+int IRAM_ATTR InputShaper::stepNeeded(int axisIdx, uint32_t tick)
+{
+    AxisShaper& axis = _axes[axisIdx];
+    uint32_t ringLen = axis._cmdSteps.size();
+
+    // Move each impulse's delayed position on to the steps which are now due
+    int64_t shapedPosQ16 = 0;
+    for (int i = 0; i < axis._numImpulses; i++)
+    {
+        while (axis._impulseSeq[i] != axis._putSeq)
+        {
+            uint32_t cmdStep = axis._cmdSteps[axis._impulseSeq[i] % ringLen];
+            if (int32_t((tick << 1) - (cmdStep & ~1u)) < int32_t(axis._delayTicks[i] << 1))
+                break;
+            axis._impulsePos[i] += (cmdStep & 1) ? 1 : -1;
+            axis._impulseSeq[i]++;
+        }
+        shapedPosQ16 += int64_t(axis._impulsePos[i]) * axis._amplQ16[i];
+    }
+
+    // Step when the shaped position is more than half a step from the physical position
+    int64_t diffQ16 = shapedPosQ16 - (int64_t(axis._outPos) << 16);
+    if (diffQ16 > 32768)
+    {
+        axis._outPos++;
+        return 1;
+    }
+    if (diffQ16 < -32768)
+    {
+        axis._outPos--;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t IRAM_ATTR InputShaper::flush(int axisIdx)
+{
+    AxisShaper& axis = _axes[axisIdx];
+    int32_t stepsNotMade = axis._cmdPos - axis._outPos;
+    bool outDirnValid = axis._outDirnValid;
+    bool outDirnPositive = axis._outDirnPositive;
+    resetAxisState(axis);
+    axis._outDirnValid = outDirnValid;
+    axis._outDirnPositive = outDirnPositive;
+    return stepsNotMade;
+}
+
+// Vibration remaining after the impulses relative to a single impulse for a second order
+// system with the shaper's damping and a natural frequency of freqHz
+float InputShaper::residualVibration(int axisIdx, float freqHz)
+{
+    if ((axisIdx < 0) || (axisIdx >= RobotConsts::MAX_AXES))
+        return 1;
+    AxisShaper& axis = _axes[axisIdx];
+    if (axis._numImpulses == 0)
+        return 1;
+    float omega = 2 * float(M_PI) * freqHz;
+    float omegaDamped = omega * sqrtf(1 - axis._damping * axis._damping);
+    float sumCos = 0;
+    float sumSin = 0;
+    for (int i = 0; i < axis._numImpulses; i++)
+    {
+        float decay = expf(axis._damping * omega * axis._timeSecs[i]);
+        sumCos += axis._ampl[i] * decay * cosf(omegaDamped * axis._timeSecs[i]);
+        sumSin += axis._ampl[i] * decay * sinf(omegaDamped * axis._timeSecs[i]);
+    }
+    return expf(-axis._damping * omega * axis._timeSecs[axis._numImpulses - 1]) *
+                sqrtf(sumCos * sumCos + sumSin * sumSin);
+}
@@ -0,0 +1,112 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+#include "RobotConsts.h"
+
+// Input shaping for axes whose mechanics ring (e.g. the long arm of a large sand table)
+// Each commanded step is split into impulses (ZV - two, ZVD - three) spread over half or
+// one damped period of the resonance so that the vibration excited by one impulse is
+// cancelled by the others
+// The shaped position of an axis is the weighted sum of its commanded position delayed by
+// each impulse time and the physical steps follow the shaped position - so motion of a
+// shaped axis finishes up to half (ZV) or one (ZVD) period after the commanded motion
+// Shaping needs a fixed tick so it is only used in the accumulator ramp generator mode
+class InputShaper
+{
+public:
+    enum ShaperType
+    {
+        SHAPER_NONE,
+        SHAPER_ZV,
+        SHAPER_ZVD
+    };
+    static constexpr int MAX_IMPULSES = 3;
+    static constexpr float FREQ_HZ_MIN = 1.0f;
+    static constexpr float DAMPING_DEFAULT = 0.1f;
+    static constexpr float DAMPING_MAX = 0.9f;
+    // Residual vibration is also reported for this error in the resonant frequency
+    static constexpr float FREQ_ERROR_REPORT = 0.2f;
+
+private:
+    struct AxisShaper
+    {
+        ShaperType _type;
+        float _freqHz;
+        float _damping;
+        int _numImpulses;
+        float _ampl[MAX_IMPULSES];
+        float _timeSecs[MAX_IMPULSES];
+        uint32_t _amplQ16[MAX_IMPULSES];
+        uint32_t _delayTicks[MAX_IMPULSES];
+
+        // Commanded steps (tick << 1 | 1 if direction positive) in a ring - each impulse has
+        // its own position in the ring and its own delayed copy of the commanded position
+        std::vector<uint32_t> _cmdSteps;
+        uint32_t _putSeq;
+        uint32_t _impulseSeq[MAX_IMPULSES];
+        int32_t _impulsePos[MAX_IMPULSES];
+        int32_t _cmdPos;
+        int32_t _outPos;
+
+        // Direction pin state for the physical steps
+        bool _outDirnValid;
+        bool _outDirnPositive;
+    };
+    AxisShaper _axes[RobotConsts::MAX_AXES];
+    uint32_t _configuredAxesBits;
+    volatile uint32_t _shapedAxesBits;
+
+public:
+    InputShaper();
+
+    // Remove shaping from all axes
+    void clear();
+
+    // Configure an axis from its JSON ("shaper": "zv" or "zvd", "shaperFreqHz", "shaperDamping")
+    void configureAxis(int axisIdx, const char* axisJSON, uint32_t tickNs);
+
+    // Shaping is only applied when enabled (depends on ramp generator mode)
+    void setEnabled(bool enabled)
+    {
+        _shapedAxesBits = enabled ? _configuredAxesBits : 0;
+    }
+    bool isEnabled()
+    {
+        return _shapedAxesBits != 0;
+    }
+    bool IRAM_ATTR isShaped(int axisIdx)
+    {
+        return (_shapedAxesBits & (1 << axisIdx)) != 0;
+    }
+
+    // Add a commanded step
+    void IRAM_ATTR cmdStep(int axisIdx, bool dirnPositive, uint32_t tick);
+
+    // Physical step needed now (+1, -1 or 0)
+    int IRAM_ATTR stepNeeded(int axisIdx, uint32_t tick);
+
+    // Direction pin for the physical steps - returns true if the pin must be changed
+    bool IRAM_ATTR setOutDirn(int axisIdx, bool dirnPositive)
+    {
+        AxisShaper& axis = _axes[axisIdx];
+        if (axis._outDirnValid && (axis._outDirnPositive == dirnPositive))
+            return false;
+        axis._outDirnValid = true;
+        axis._outDirnPositive = dirnPositive;
+        return true;
+    }
+
+    // Abandon shaped motion - returns the commanded steps which have not been made
+    int32_t IRAM_ATTR flush(int axisIdx);
+
+    // Residual vibration (fraction of the unshaped vibration) of an axis's shaper for a resonance
+    // at freqHz - for a step input the residual vibration energy is the square of this
+    float residualVibration(int axisIdx, float freqHz);
+
+private:
+    void IRAM_ATTR resetAxisState(AxisShaper& axis);
+};
@@ -0,0 +1,166 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+#include "../MotionBlock.h"
+
+// Records the planned profile of every block executed by the ramp generator along with the
+// times the ISR started and finished it - blocks are final once they start executing so this
+// is what the planner produced after all look-ahead changes
+// The buffer is a ring which keeps the most recent blocks
+class MotionPlannerTrace
+{
+public:
+    // Traces are ~56 bytes (2 axes) and a CSV line is typically ~90 chars so the maximum needs
+    // ~14KB for the buffer and ~23KB for the CSV
+    static constexpr int TRACE_LEN_DEFAULT = 100;
+    static constexpr int TRACE_LEN_MAX = 250;
+    static constexpr int TRACE_CSV_CHARS_PER_BLOCK = 90;
+
+    struct BlockTrace
+    {
+        uint32_t _startUs;
+        uint32_t _endUs;
+        int32_t _steps[RobotConsts::MAX_AXES];
+        uint32_t _stepsBeforeDecel;
+        uint32_t _initialStepRatePerTTicks;
+        uint32_t _maxStepRatePerTTicks;
+        uint32_t _finalStepRatePerTTicks;
+        uint32_t _accStepsPerTTicksPerMS;
+        float _moveDistMM;
+        float _feedrate;
+        float _entrySpeedMMps;
+        float _exitSpeedMMps;
+        uint8_t _axisIdxWithMaxSteps;
+        bool _blockIsFollowed;
+    };
+
+private:
+    // The buffer is allocated once at the maximum length so it never moves under the ISR
+    std::vector<BlockTrace> _traces;
+    volatile uint32_t _traceCount;
+    volatile uint32_t _maxTraces;
+    volatile bool _isRecording;
+
+    // Set by the ISR while it is in record() - the buffer is only changed or read once
+    // recording is stopped and the ISR is seen to be out of record()
+    volatile bool _inRecord;
+
+    void stopAndWaitForISR()
+    {
+        _isRecording = false;
+        __sync_synchronize();
+        while (_inRecord)
+        {
+        }
+    }
+
+public:
+    MotionPlannerTrace()
+    {
+        _traceCount = 0;
+        _maxTraces = 0;
+        _isRecording = false;
+        _inRecord = false;
+    }
+
+    void start(int maxBlocks)
+    {
+        stopAndWaitForISR();
+        if (maxBlocks <= 0)
+            maxBlocks = TRACE_LEN_DEFAULT;
+        if (maxBlocks > TRACE_LEN_MAX)
+            maxBlocks = TRACE_LEN_MAX;
+        if (_traces.size() != TRACE_LEN_MAX)
+            _traces.resize(TRACE_LEN_MAX);
+        _maxTraces = maxBlocks;
+        _traceCount = 0;
+        __sync_synchronize();
+        _isRecording = true;
+    }
+
+    void stop()
+    {
+        stopAndWaitForISR();
+    }
+
+    bool IRAM_ATTR isRecording()
+    {
+        return _isRecording;
+    }
+
+    // Total blocks recorded (including those overwritten)
+    uint32_t count()
+    {
+        return _traceCount;
+    }
+
+    inline void IRAM_ATTR record(const MotionBlock& block, uint32_t startUs, uint32_t endUs)
+    {
+        // Busy is flagged before recording is checked so that stopAndWaitForISR() either
+        // sees the ISR in here or the ISR sees recording stopped
+        _inRecord = true;
+        __sync_synchronize();
+        if (_isRecording)
+            recordBlock(block, startUs, endUs);
+        _inRecord = false;
+    }
+
+    // Recorded blocks (oldest first) as CSV - step rates are converted to steps per second
+    // Recording is suspended while the CSV is generated
+    void getCSV(String& csvStr)
+    {
+        bool wasRecording = _isRecording;
+        stopAndWaitForISR();
+        csvStr = "startUs,endUs,axisMax,followed";
+        for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+            csvStr += ",steps" + String(axisIdx);
+        csvStr += ",distMM,feedrate,entryMMps,exitMMps,stepsBeforeDecel,initialStepsPs,maxStepsPs,finalStepsPs,accStepsPs2\n";
+        uint32_t numTraces = std::min(uint32_t(_traceCount), uint32_t(_maxTraces));
+        csvStr.reserve(numTraces * TRACE_CSV_CHARS_PER_BLOCK + 200);
+        const float stepsPsPerRate = MotionBlock::TICKS_PER_SEC / MotionBlock::TTICKS_VALUE;
+        for (uint32_t i = 0; i < numTraces; i++)
+        {
+            BlockTrace& trace = _traces[(_traceCount - numTraces + i) % _maxTraces];
+            char lineStr[200];
+            int lineLen = snprintf(lineStr, sizeof(lineStr), "%u,%u,%d,%d", (unsigned)trace._startUs, (unsigned)trace._endUs,
+                                   trace._axisIdxWithMaxSteps, trace._blockIsFollowed ? 1 : 0);
+            for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+                lineLen += snprintf(lineStr + lineLen, sizeof(lineStr) - lineLen, ",%d", (int)trace._steps[axisIdx]);
+            snprintf(lineStr + lineLen, sizeof(lineStr) - lineLen, ",%.3f,%.2f,%.2f,%.2f,%u,%.1f,%.1f,%.1f,%.1f\n",
+                     trace._moveDistMM, trace._feedrate, trace._entrySpeedMMps, trace._exitSpeedMMps,
+                     (unsigned)trace._stepsBeforeDecel, trace._initialStepRatePerTTicks * stepsPsPerRate,
+                     trace._maxStepRatePerTTicks * stepsPsPerRate, trace._finalStepRatePerTTicks * stepsPsPerRate,
+                     trace._accStepsPerTTicksPerMS * stepsPsPerRate * 1000);
+            csvStr += lineStr;
+        }
+        __sync_synchronize();
+        _isRecording = wasRecording;
+    }
+
+private:
+    inline void IRAM_ATTR recordBlock(const MotionBlock& block, uint32_t startUs, uint32_t endUs)
+    {
+        BlockTrace& trace = _traces[_traceCount % _maxTraces];
+        trace._startUs = startUs;
+        trace._endUs = endUs;
+        for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+            trace._steps[axisIdx] = (block._exec._dirnPositiveBits & (1 << axisIdx)) ?
+                        int32_t(block._exec._stepsTotalAbs[axisIdx]) : -int32_t(block._exec._stepsTotalAbs[axisIdx]);
+        trace._stepsBeforeDecel = block._stepsBeforeDecel;
+        trace._initialStepRatePerTTicks = block._initialStepRatePerTTicks;
+        trace._maxStepRatePerTTicks = block._maxStepRatePerTTicks;
+        trace._finalStepRatePerTTicks = block._finalStepRatePerTTicks;
+        trace._accStepsPerTTicksPerMS = block._accStepsPerTTicksPerMS;
+        trace._moveDistMM = block._moveDistPrimaryAxesMM;
+        trace._feedrate = block._feedrate;
+        trace._entrySpeedMMps = block._entrySpeedMMps;
+        trace._exitSpeedMMps = block._exitSpeedMMps;
+        trace._axisIdxWithMaxSteps = block._axisIdxWithMaxSteps;
+        trace._blockIsFollowed = block._blockIsFollowed;
+        _traceCount++;
+    }
+};
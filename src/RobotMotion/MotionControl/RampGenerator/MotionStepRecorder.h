@@ -0,0 +1,149 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+// Records step-start, step-end and direction changes made by the ramp generator
+// Each event is stamped with the ramp generator tick count so that step rates,
+// gaps between blocks and ISR work per tick can be measured without a logic analyser
+class MotionStepRecorder
+{
+public:
+    // Events are 8 bytes and each is ~22 chars of CSV so the maximum needs ~16KB for the
+    // buffer and ~45KB for the CSV which fits in the ESP32 heap alongside the web server
+    static constexpr int STEP_RECORDER_LEN_DEFAULT = 1000;
+    static constexpr int STEP_RECORDER_LEN_MAX = 2000;
+    static constexpr int STEP_RECORDER_CSV_CHARS_PER_EVENT = 24;
+
+    enum StepEventType
+    {
+        EVENT_STEP_START,
+        EVENT_STEP_END,
+        EVENT_DIRECTION,
+        EVENT_BLOCK_START,
+        EVENT_BLOCK_END
+    };
+
+    struct StepEvent
+    {
+        uint32_t _tick;
+        uint8_t _type;
+        uint8_t _axisIdx;
+        uint8_t _val;
+    };
+
+private:
+    // Events are recorded in order until the buffer is full (no wrap-around so that
+    // the start of a run is always captured)
+    // The buffer is allocated once at the maximum length so it never moves under the ISR
+    std::vector<StepEvent> _events;
+    volatile uint32_t _eventCount;
+    volatile uint32_t _maxEvents;
+    volatile bool _isRecording;
+
+    // Set by the ISR while it is in record() - the buffer is only changed or read once
+    // recording is stopped and the ISR is seen to be out of record()
+    volatile bool _inRecord;
+
+    void stopAndWaitForISR()
+    {
+        _isRecording = false;
+        __sync_synchronize();
+        while (_inRecord)
+        {
+        }
+    }
+
+public:
+    MotionStepRecorder()
+    {
+        _eventCount = 0;
+        _maxEvents = 0;
+        _isRecording = false;
+        _inRecord = false;
+    }
+
+    void start(int maxEvents)
+    {
+        stopAndWaitForISR();
+        if (maxEvents <= 0)
+            maxEvents = STEP_RECORDER_LEN_DEFAULT;
+        if (maxEvents > STEP_RECORDER_LEN_MAX)
+            maxEvents = STEP_RECORDER_LEN_MAX;
+        if (_events.size() != STEP_RECORDER_LEN_MAX)
+            _events.resize(STEP_RECORDER_LEN_MAX);
+        _maxEvents = maxEvents;
+        _eventCount = 0;
+        __sync_synchronize();
+        _isRecording = true;
+    }
+
+    void stop()
+    {
+        stopAndWaitForISR();
+    }
+
+    void clear()
+    {
+        stopAndWaitForISR();
+        _eventCount = 0;
+        _maxEvents = 0;
+        _events.clear();
+        _events.shrink_to_fit();
+    }
+
+    bool isRecording()
+    {
+        return _isRecording;
+    }
+
+    uint32_t count()
+    {
+        return _eventCount;
+    }
+
+    inline void IRAM_ATTR record(uint32_t tick, StepEventType type, int axisIdx, int val)
+    {
+        // Busy is flagged before recording is checked so that stopAndWaitForISR() either
+        // sees the ISR in here or the ISR sees recording stopped
+        _inRecord = true;
+        __sync_synchronize();
+        if (_isRecording)
+        {
+            if (_eventCount >= _maxEvents)
+            {
+                _isRecording = false;
+            }
+            else
+            {
+                StepEvent& ev = _events[_eventCount];
+                ev._tick = tick;
+                ev._type = type;
+                ev._axisIdx = axisIdx;
+                ev._val = val;
+                _eventCount++;
+            }
+        }
+        _inRecord = false;
+    }
+
+    // Recorded events as CSV (tick,event,axis,val) - recording is stopped first
+    void getCSV(String& csvStr)
+    {
+        static const char* eventNames[] = { "step", "stepEnd", "dirn", "blkStart", "blkEnd" };
+        stopAndWaitForISR();
+        csvStr = "tick,event,axis,val\n";
+        csvStr.reserve(_eventCount * STEP_RECORDER_CSV_CHARS_PER_EVENT + 30);
+        for (uint32_t i = 0; i < _eventCount; i++)
+        {
+            char lineStr[60];
+            StepEvent& ev = _events[i];
+            snprintf(lineStr, sizeof(lineStr), "%u,%s,%d,%d\n", (unsigned)ev._tick,
+                     ev._type <= EVENT_BLOCK_END ? eventNames[ev._type] : "?", ev._axisIdx, ev._val);
+            csvStr += lineStr;
+        }
+    }
+};
@@ -0,0 +1,96 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#pragma once
+
+#include <Arduino.h>
+
+// Always-on timing statistics for the ramp generator ISR
+// ISR execution time (CPU cycles) and the deviation of actual step intervals from the planned
+// intervals (ns) are collected in log2 histograms - bin 0 counts zero values and bin N counts
+// values from 2^(N-1) to 2^N - 1 (the last bin also counts anything larger)
+// Recording is a few instructions so it can stay enabled in production
+class MotionTimingStats
+{
+public:
+    static constexpr int HIST_BINS = 24;
+
+private:
+    volatile uint32_t _isrCyclesHist[HIST_BINS];
+    volatile uint32_t _isrCyclesMax;
+    volatile uint32_t _stepDevHist[HIST_BINS];
+    volatile uint32_t _stepDevCount;
+    volatile int64_t _stepDevSumNs;
+    volatile int32_t _stepDevMinNs;
+    volatile int32_t _stepDevMaxNs;
+
+public:
+    MotionTimingStats()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        for (int i = 0; i < HIST_BINS; i++)
+        {
+            _isrCyclesHist[i] = 0;
+            _stepDevHist[i] = 0;
+        }
+        _isrCyclesMax = 0;
+        _stepDevCount = 0;
+        _stepDevSumNs = 0;
+        _stepDevMinNs = 0;
+        _stepDevMaxNs = 0;
+    }
+
+    static inline int IRAM_ATTR log2Bin(uint32_t val)
+    {
+        if (val == 0)
+            return 0;
+        int bin = 32 - __builtin_clz(val);
+        return bin < HIST_BINS ? bin : HIST_BINS - 1;
+    }
+
+    inline void IRAM_ATTR recordISRCycles(uint32_t cycles)
+    {
+        _isrCyclesHist[log2Bin(cycles)]++;
+        if (_isrCyclesMax < cycles)
+            _isrCyclesMax = cycles;
+    }
+
+    // Deviation is actual interval minus planned interval (positive if the step was late)
+    inline void IRAM_ATTR recordStepDeviation(int32_t devNs)
+    {
+        _stepDevHist[log2Bin(devNs < 0 ? -devNs : devNs)]++;
+        _stepDevCount++;
+        _stepDevSumNs += devNs;
+        if (_stepDevMinNs > devNs)
+            _stepDevMinNs = devNs;
+        if (_stepDevMaxNs < devNs)
+            _stepDevMaxNs = devNs;
+    }
+
+    void getJSON(String& jsonStr)
+    {
+        String isrHistStr;
+        String devHistStr;
+        for (int i = 0; i < HIST_BINS; i++)
+        {
+            if (i != 0)
+            {
+                isrHistStr += ",";
+                devHistStr += ",";
+            }
+            isrHistStr += String((unsigned long)_isrCyclesHist[i]);
+            devHistStr += String((unsigned long)_stepDevHist[i]);
+        }
+        uint32_t devCount = _stepDevCount;
+        char devStr[120];
+        snprintf(devStr, sizeof(devStr), "\"stepDevCount\":%u,\"stepDevMeanNs\":%d,\"stepDevMinNs\":%d,\"stepDevMaxNs\":%d",
+                (unsigned)devCount, devCount ? int(_stepDevSumNs / devCount) : 0, (int)_stepDevMinNs, (int)_stepDevMaxNs);
+        jsonStr = "{\"isrCyclesMax\":" + String((unsigned long)_isrCyclesMax) +
+                  ",\"isrCyclesHist\":[" + isrHistStr + "]," + devStr +
+                  ",\"stepDevHist\":[" + devHistStr + "]}";
+    }
+};
@@ -15,9 +15,22 @@ RampGenIO::RampGenIO()
     for (int i = 0; i < RobotConsts::MAX_AXES; i++)
     {
         _stepperMotors[i] = NULL;
+        _stepPinMasks[i] = 0;
+        _dirnPinMasks[i] = 0;
+        _dirnPinLevelPositive[i] = false;
         for (int j = 0; j < RobotConsts::MAX_ENDSTOPS_PER_AXIS; j++)
             _endStops[i][j] = NULL;
     }
+    _endStopArmedMask = 0;
+    _endStopHitLevels = 0;
+    _endStopHitMask = 0;
+    _endStopPendingMask = 0;
+    _endStopPendingUs = 0;
+    _endStopDebounceUs = 0;
+    _endStopFlags = 0;
+#ifdef ESP32
+    _endStopMux = portMUX_INITIALIZER_UNLOCKED;
+#endif
 }
 
 RampGenIO::~RampGenIO()
@@ -28,12 +41,27 @@ RampGenIO::~RampGenIO()
 void RampGenIO::deinit()
 {
     // remove motors and end stops
+    _endStopArmedMask = 0;
+    _endStopFlags = 0;
     for (int i = 0; i < RobotConsts::MAX_AXES; i++)
     {
         delete _stepperMotors[i];
         _stepperMotors[i] = NULL;
+        _stepPinMasks[i] = 0;
+        _dirnPinMasks[i] = 0;
+        _dirnPinLevelPositive[i] = false;
         for (int j = 0; j < RobotConsts::MAX_ENDSTOPS_PER_AXIS; j++)
         {
+#ifdef ESP32
+            if (_endStops[i][j])
+            {
+                int sensePin = -1;
+                bool actLvl = false;
+                _endStops[i][j]->getPins(sensePin, actLvl);
+                if (sensePin >= 0)
+                    detachInterrupt(sensePin);
+            }
+#endif
             delete _endStops[i][j];
             _endStops[i][j] = NULL;
         }
@@ -80,6 +108,21 @@ bool RampGenIO::configureAxis(int axisIdx, const char *axisJSON)
         if ((stepPin >= 0) && ((dirnPin >= 0) || (muxPin1 >= 0)))
             _stepperMotors[axisIdx] = new StepperMotor(RobotConsts::MOTOR_TYPE_DRIVER, stepPin, dirnPin, 
                                 muxPin1, muxPin2, muxPin3, muxDirnIdx, directionReversed);
+
+        // Step pin mask - multiplexed direction pins are set on each step so these axes
+        // are stepped using the motor
+        _stepPinMasks[axisIdx] = 0;
+        _dirnPinMasks[axisIdx] = 0;
+        if (_stepperMotors[axisIdx] && !_stepperMotors[axisIdx]->isDirectionMultiplexed() && 
+                        (stepPin < NUM_GPIO_OUTPUT_PINS))
+        {
+            _stepPinMasks[axisIdx] = getPinMask(stepPin);
+            if (dirnPin < NUM_GPIO_OUTPUT_PINS)
+                _dirnPinMasks[axisIdx] = getPinMask(dirnPin);
+            _dirnPinLevelPositive[axisIdx] = _stepperMotors[axisIdx]->getDirectionPinLevel(true);
+        }
+        Log.notice("%sAxis%d step pin mask %08x%08x\n", MODULE_PREFIX, axisIdx, 
+                        (uint32_t)(_stepPinMasks[axisIdx] >> 32), (uint32_t)_stepPinMasks[axisIdx]);
     }
 
     // End stops
@@ -93,6 +136,15 @@ bool RampGenIO::configureAxis(int axisIdx, const char *axisJSON)
 
         // Create endStop from JSON
         _endStops[axisIdx][endStopIdx] = new EndStop(axisIdx, endStopIdx, endStopJSON.c_str());
+
+        // Interrupt on both edges - whether an edge is a hit depends on the block being executed
+#ifdef ESP32
+        int sensePin = -1;
+        bool actLvl = false;
+        _endStops[axisIdx][endStopIdx]->getPins(sensePin, actLvl);
+        if (getPinMask(sensePin))
+            attachInterruptArg(sensePin, _staticEndStopISR, this, CHANGE);
+#endif
     }
 
     return true;
@@ -199,6 +251,111 @@ void RampGenIO::getEndStopStatus(AxisMinMaxBools& axisEndStopVals)
 
 void RampGenIO::service()
 {
+    // Without GPIO interrupts the end-stops are polled
+#ifndef ESP32
+    endStopEdge();
+#endif
+}
+
+// Arm end-stops for a block - a pin already at its hit level is a hit straight away
+void IRAM_ATTR RampGenIO::armEndStops(uint64_t pinMask, uint64_t hitLevels)
+{
+    endStopLock();
+    armEndStopsLocked(pinMask, hitLevels);
+    endStopUnlock();
+}
+
+void IRAM_ATTR RampGenIO::armEndStopsLocked(uint64_t pinMask, uint64_t hitLevels)
+{
+    _endStopFlags = 0;
+    _endStopPendingMask = 0;
+    _endStopHitMask = 0;
+    _endStopHitLevels = hitLevels;
+    _endStopArmedMask = pinMask;
+    if (pinMask == 0)
+        return;
+    uint64_t pinVals = readPinsInMask(pinMask);
+    uint64_t hitMask = ~(pinVals ^ hitLevels) & pinMask;
+    if (hitMask)
+    {
+        _endStopHitMask = hitMask;
+        _endStopFlags = END_STOP_FLAG_HIT;
+    }
+}
+
+// Take the pins hit so far - the rest are re-armed (and re-read so a hit which happened
+// while taking isn't lost)
+uint64_t IRAM_ATTR RampGenIO::takeEndStopHits()
+{
+    endStopLock();
+    uint64_t hitMask = _endStopHitMask;
+    armEndStopsLocked(_endStopArmedMask & ~hitMask, _endStopHitLevels);
+    endStopUnlock();
+    return hitMask;
+}
+
+void IRAM_ATTR RampGenIO::_staticEndStopISR(void* pArg)
+{
+    ((RampGenIO*)pArg)->endStopEdge();
+}
+
+// Edge on an end-stop pin - latch a hit or start the debounce time
+void IRAM_ATTR RampGenIO::endStopEdge()
+{
+    endStopLock();
+    uint64_t armedMask = _endStopArmedMask;
+    if ((armedMask == 0) || (_endStopFlags & END_STOP_FLAG_HIT))
+    {
+        endStopUnlock();
+        return;
+    }
+    uint64_t pinVals = readPinsInMask(armedMask);
+    uint64_t hitMask = ~(pinVals ^ _endStopHitLevels) & armedMask;
+    if (_endStopDebounceUs == 0)
+    {
+        if (hitMask)
+        {
+            _endStopHitMask = hitMask;
+            _endStopFlags = END_STOP_FLAG_HIT;
+        }
+        endStopUnlock();
+        return;
+    }
+
+    // Pins leaving their hit level are no longer pending - the debounce time restarts on
+    // every edge towards a hit
+    if (hitMask & ~_endStopPendingMask)
+        _endStopPendingUs = micros();
+    _endStopPendingMask = hitMask;
+    _endStopFlags = hitMask ? END_STOP_FLAG_PENDING : 0;
+    endStopUnlock();
+}
+
+// Called from the step ISR while a hit is pending - a hit once the pin has stayed at its hit level
+// (the flags are checked again under the lock as the GPIO ISR may have changed them)
+bool IRAM_ATTR RampGenIO::endStopDebounceCheck()
+{
+    endStopLock();
+    bool isHit = (_endStopFlags & END_STOP_FLAG_HIT) != 0;
+    if (!isHit && (_endStopFlags & END_STOP_FLAG_PENDING) && (micros() - _endStopPendingUs >= _endStopDebounceUs))
+    {
+        uint64_t pendingMask = _endStopPendingMask;
+        uint64_t pinVals = readPinsInMask(pendingMask);
+        uint64_t hitMask = ~(pinVals ^ _endStopHitLevels) & pendingMask;
+        if (hitMask)
+        {
+            _endStopHitMask = hitMask;
+            _endStopFlags = END_STOP_FLAG_HIT;
+            isHit = true;
+        }
+        else
+        {
+            _endStopPendingMask = 0;
+            _endStopFlags = 0;
+        }
+    }
+    endStopUnlock();
+    return isHit;
 }
 
 void RampGenIO::getRawMotionHwInfo(RobotConsts::RawMotionHwInfo_t &raw)
@@ -4,7 +4,11 @@
 #pragma once
 
 #include <time.h>
+#include <Arduino.h>
 #include "RobotConsts.h"
+#if defined(ESP32) || defined(UNIT_TEST)
+#include "soc/gpio_reg.h"
+#endif
 
 #ifndef SPARK
 //#define BOUNDS_CHECK_ISR_FUNCTIONS    1
@@ -22,6 +26,58 @@ private:
     // End stops
     EndStop* _endStops[RobotConsts::MAX_AXES][RobotConsts::MAX_ENDSTOPS_PER_AXIS];
 
+    // Step and direction pin masks (bit N is GPIO N) - 0 if the axis can't be driven using a mask
+    uint64_t _stepPinMasks[RobotConsts::MAX_AXES];
+    uint64_t _dirnPinMasks[RobotConsts::MAX_AXES];
+    bool _dirnPinLevelPositive[RobotConsts::MAX_AXES];
+
+    // GPIOs 32 and above are in the second set of GPIO registers
+    static constexpr int NUM_GPIO_PINS = 40;
+    static constexpr int NUM_GPIO_OUTPUT_PINS = 34;
+
+    // End-stop hits are latched by GPIO edge interrupts so the step ISR only checks a flag
+    // The end-stops armed for the current block and the levels which indicate a hit
+    volatile uint64_t _endStopArmedMask;
+    volatile uint64_t _endStopHitLevels;
+    // Armed pins which have been hit
+    volatile uint64_t _endStopHitMask;
+    // Pins seen at their hit level but not yet stable for the debounce time
+    volatile uint64_t _endStopPendingMask;
+    volatile uint32_t _endStopPendingUs;
+    uint32_t _endStopDebounceUs;
+    // Flags checked by the step ISR with a single load
+    static constexpr uint32_t END_STOP_FLAG_HIT = 0x01;
+    static constexpr uint32_t END_STOP_FLAG_PENDING = 0x02;
+    volatile uint32_t _endStopFlags;
+    static void _staticEndStopISR(void* pArg);
+    void endStopEdge();
+    bool endStopDebounceCheck();
+    void armEndStopsLocked(uint64_t pinMask, uint64_t hitLevels);
+
+    // The GPIO ISR and the step ISR (and the task which stops motion) can run on different
+    // cores so the end-stop state they share is only changed while holding a spinlock
+#ifdef ESP32
+    portMUX_TYPE _endStopMux;
+#endif
+    inline void IRAM_ATTR endStopLock()
+    {
+#ifdef ESP32
+        if (xPortInIsrContext())
+            portENTER_CRITICAL_ISR(&_endStopMux);
+        else
+            portENTER_CRITICAL(&_endStopMux);
+#endif
+    }
+    inline void IRAM_ATTR endStopUnlock()
+    {
+#ifdef ESP32
+        if (xPortInIsrContext())
+            portEXIT_CRITICAL_ISR(&_endStopMux);
+        else
+            portEXIT_CRITICAL(&_endStopMux);
+#endif
+    }
+
 public:
     RampGenIO();
     ~RampGenIO();
@@ -50,11 +106,109 @@ public:
     // Endstop status
     void getEndStopStatus(AxisMinMaxBools& axisEndStopVals);
 
+    // Endstop debounce - a pin must stay at its hit level for this time to count as a hit
+    void setEndStopDebounceUs(uint32_t debounceUs)
+    {
+        _endStopDebounceUs = debounceUs;
+    }
+
+    // Arm the end-stops to check in the current block (called from the step ISR at the start of a block)
+    void armEndStops(uint64_t pinMask, uint64_t hitLevels);
+
+    // Check if an armed end-stop has been hit
+    inline bool IRAM_ATTR isEndStopHit()
+    {
+        uint32_t flags = _endStopFlags;
+        if (flags == 0)
+            return false;
+        if (flags & END_STOP_FLAG_HIT)
+            return true;
+        return endStopDebounceCheck();
+    }
+
+    // Take the pins which have been hit - they are disarmed and the other pins stay armed
+    uint64_t takeEndStopHits();
+    bool IRAM_ATTR anyEndStopsArmed()
+    {
+        return _endStopArmedMask != 0;
+    }
+
     // Motor control
     void setDirection(int axisIdx, bool direction);
     void stepStart(int axisIdx);
     bool stepEnd(int axisIdx);
 
+    // Mask for stepping the axis with setPinsInMask() (0 if stepStart() must be used)
+    uint64_t IRAM_ATTR getStepPinMask(int axisIdx)
+    {
+        return _stepPinMasks[axisIdx];
+    }
+
+    // Mask for setting the axis direction with setPinsInMask()/clearPinsInMask() (0 if
+    // setDirection() must be used) and the level for a direction
+    uint64_t IRAM_ATTR getDirnPinMask(int axisIdx)
+    {
+        return _dirnPinMasks[axisIdx];
+    }
+    bool IRAM_ATTR getDirnPinLevel(int axisIdx, bool direction)
+    {
+        return direction ? _dirnPinLevelPositive[axisIdx] : !_dirnPinLevelPositive[axisIdx];
+    }
+
+    // Mask for a GPIO pin (0 if not a valid pin)
+    static uint64_t getPinMask(int pin)
+    {
+        if ((pin < 0) || (pin >= NUM_GPIO_PINS))
+            return 0;
+        return 1ULL << pin;
+    }
+
+    // Set/clear all pins in a mask with one register write per GPIO bank (the host build
+    // simulates the GPIO registers so the same path is tested)
+    static inline void IRAM_ATTR setPinsInMask(uint64_t pinMask)
+    {
+#if defined(ESP32) || defined(UNIT_TEST)
+        if ((uint32_t)pinMask)
+            REG_WRITE(GPIO_OUT_W1TS_REG, (uint32_t)pinMask);
+        if (pinMask >> 32)
+            REG_WRITE(GPIO_OUT1_W1TS_REG, (uint32_t)(pinMask >> 32));
+#else
+        for (int pin = 0; pin < NUM_GPIO_PINS; pin++)
+            if (pinMask & (1ULL << pin))
+                digitalWrite(pin, 1);
+#endif
+    }
+    static inline void IRAM_ATTR clearPinsInMask(uint64_t pinMask)
+    {
+#if defined(ESP32) || defined(UNIT_TEST)
+        if ((uint32_t)pinMask)
+            REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)pinMask);
+        if (pinMask >> 32)
+            REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(pinMask >> 32));
+#else
+        for (int pin = 0; pin < NUM_GPIO_PINS; pin++)
+            if (pinMask & (1ULL << pin))
+                digitalWrite(pin, 0);
+#endif
+    }
+
+    // Read the levels of all pins in a mask (one register read per GPIO bank)
+    static inline uint64_t IRAM_ATTR readPinsInMask(uint64_t pinMask)
+    {
+#if defined(ESP32) || defined(UNIT_TEST)
+        uint64_t pinVals = REG_READ(GPIO_IN_REG);
+        if (pinMask >> 32)
+            pinVals |= ((uint64_t)REG_READ(GPIO_IN1_REG)) << 32;
+        return pinVals & pinMask;
+#else
+        uint64_t pinVals = 0;
+        for (int pin = 0; pin < NUM_GPIO_PINS; pin++)
+            if ((pinMask & (1ULL << pin)) && digitalRead(pin))
+                pinVals |= 1ULL << pin;
+        return pinVals;
+#endif
+    }
+
 // private:
 
 //     // Check if a step is in progress on any motor, if all such and return true, else false
@@ -4,6 +4,9 @@
 #include "RampGenerator.h"
 #include "MotionInstrumentation.h"
 #include "../MotionPipeline.h"
+#include "RdJson.h"
+
+static const char* MODULE_PREFIX = "RampGenerator: ";
 
 //#define USE_FAST_PIN_ACCESS 1
 
@@ -50,13 +53,53 @@ RampGenerator::RampGenerator(MotionPipeline* pMotionPipeline)
     _isPaused = true;
     _endStopReached = false;
     _lastDoneNumberedCmdIdx = RobotConsts::NUMBERED_COMMAND_NONE;
+    _lastDoneNumberedCmdEndStopHitBits = 0;
     _isEnabled = false;
     _curStepRatePerTTicks = 0;
     _curAccumulatorStep = 0;
     _curAccumulatorNS = 0;
     _endStopCheckNum = 0;
+    for (uint64_t& pinMask : _endStopPinMasks)
+        pinMask = 0;
     _isrTimerStarted = false;
     _rampGenEnabled = false;
+    _isrTickCount = 0;
+    _isrBlockTickCount = 0;
+    _isrStepTickCount = 0;
+    _plannerWorkQueued = false;
+    _upstreamWorkQueued = false;
+    resetUnderrunStats();
+#ifndef USE_ESP32_TIMER_ISR
+    _virtualTimerLastUs = 0;
+    _virtualTimerElapsedNs = 0;
+#endif
+    _isrPeriodNs = MotionBlock::TICK_INTERVAL_NS;
+    _feedHoldActive = false;
+    _execHold = false;
+    _feedOverrideQ16 = 1 << 16;
+    _feedScaleQ16 = 1 << 16;
+    _feedScaleAccumNs = 0;
+    _axisStepActiveBits = 0;
+    _stepPinActiveMask = 0;
+    _axisEndStopHitBits = 0;
+    _isrCycles = 0;
+    _cpuFreqMHz = getCpuFrequencyMhz();
+    _isrStartCycles = 0;
+    _curBlockStartUs = 0;
+    _lastStepCycles = 0;
+    _stepTimingValid = false;
+    _isrLoadLastCycles = 0;
+    _isrLoadLastUs = 0;
+    _rampGenMode = RAMP_GEN_MODE_ACCUMULATOR;
+    _rampGenProfile = RAMP_GEN_PROFILE_TRAPEZOID;
+    _sCurveDecelStarted = false;
+    _sCurveStartRate = 0;
+    _sCurveEndRate = 0;
+    _sCurveElapsedMs = 0;
+    _sCurveDurationMs = 0;
+    _stepCompileLeadUs = STEP_COMPILE_LEAD_MS_DEFAULT * 1000;
+    _stepClockNs = 0;
+    resetStepEvents();
 
 #ifdef TEST_MOTION_ACTUATOR_ENABLE
     _pMotionInstrumentation = NULL;
@@ -73,12 +116,13 @@ void RampGenerator::setInstrumentationMode(const char *testModeStr)
 {
 #ifdef INSTRUMENT_MOTION_ACTUATOR_ENABLE
     _pMotionInstrumentation = new MotionInstrumentation();
-    _pMotionInstrumentation->setInstrumentationMode(testModeStr);
+    _pMotionInstrumentation->setIntrumentationMode(testModeStr);
 #endif
 }
 
 void RampGenerator::deinit()
 {
+    _inputShaper.clear();
 #ifdef USE_ESP32_TIMER_ISR
     if (_isrTimerStarted)
     {
@@ -88,10 +132,49 @@ void RampGenerator::deinit()
 #endif
 }
 
-void RampGenerator::configure(bool rampGenEnabled)
+void RampGenerator::configure(bool rampGenEnabled, const char* robotGeomJSON)
 {
     // Cache axis and endstop info
     _rampGenIO.getRawMotionHwInfo(_rawMotionHwInfo);
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+    {
+        int bitIdx = axisIdx * RobotConsts::MAX_ENDSTOPS_PER_AXIS;
+        _endStopPinMasks[bitIdx + AxisMinMaxBools::MIN_VAL_IDX] = RampGenIO::getPinMask(_rawMotionHwInfo._axis[axisIdx]._pinEndStopMin);
+        _endStopPinMasks[bitIdx + AxisMinMaxBools::MAX_VAL_IDX] = RampGenIO::getPinMask(_rawMotionHwInfo._axis[axisIdx]._pinEndStopMax);
+    }
+    _cpuFreqMHz = getCpuFrequencyMhz();
+
+    // Mode
+    String modeStr = RdJson::getString("rampGen/mode", "accumulator", robotGeomJSON);
+    _rampGenMode = RAMP_GEN_MODE_ACCUMULATOR;
+    if (modeStr.equalsIgnoreCase("stepEvents"))
+        _rampGenMode = RAMP_GEN_MODE_STEP_EVENTS;
+    else if (modeStr.equalsIgnoreCase("stepTimer"))
+        _rampGenMode = RAMP_GEN_MODE_STEP_TIMER;
+    int stepCmdQueueLen = RdJson::getLong("rampGen/stepCmdQueueLen", STEP_CMD_QUEUE_LEN_DEFAULT, robotGeomJSON);
+    _stepCompileLeadUs = RdJson::getLong("rampGen/stepCompileLeadMs", STEP_COMPILE_LEAD_MS_DEFAULT, robotGeomJSON) * 1000;
+    _stepCmdQueue.init(usesStepCommands() ? stepCmdQueueLen : 0);
+    resetStepEvents();
+    Log.notice("%smode %s stepCmdQueueLen %d stepCompileLeadMs %d\n", MODULE_PREFIX,
+                _rampGenMode == RAMP_GEN_MODE_STEP_TIMER ? "stepTimer" : 
+                        (_rampGenMode == RAMP_GEN_MODE_STEP_EVENTS ? "stepEvents" : "accumulator"),
+                stepCmdQueueLen, _stepCompileLeadUs / 1000);
+
+    // End-stop debounce
+    uint32_t endStopDebounceUs = RdJson::getLong("rampGen/endStopDebounceUs", END_STOP_DEBOUNCE_US_DEFAULT, robotGeomJSON);
+    _rampGenIO.setEndStopDebounceUs(endStopDebounceUs);
+    Log.notice("%sendStopDebounceUs %d\n", MODULE_PREFIX, endStopDebounceUs);
+
+    // Acceleration profile
+    String profileStr = RdJson::getString("rampGen/profile", "trapezoid", robotGeomJSON);
+    _rampGenProfile = profileStr.equalsIgnoreCase("sCurve") ? RAMP_GEN_PROFILE_S_CURVE : RAMP_GEN_PROFILE_TRAPEZOID;
+    Log.notice("%sprofile %s\n", MODULE_PREFIX, _rampGenProfile == RAMP_GEN_PROFILE_S_CURVE ? "sCurve" : "trapezoid");
+
+    // Input shaping needs the fixed tick of the accumulator mode
+    _inputShaper.setEnabled(_rampGenMode == RAMP_GEN_MODE_ACCUMULATOR);
+
+    // ISR period - in step timer mode this is changed on every ISR call
+    _isrPeriodNs = (_rampGenMode == RAMP_GEN_MODE_STEP_TIMER) ? STEP_TIMER_IDLE_PERIOD_NS : MotionBlock::TICK_INTERVAL_NS;
 
     // TODO check we don't need this...
 
@@ -109,28 +192,78 @@ void RampGenerator::configure(bool rampGenEnabled)
     if (_rampGenEnabled)
     {
         Log.notice("RampGenerator: Starting ISR timer for direct stepping\n");
-        _isrMotionTimer = timerBegin(0, CLOCK_RATE_MHZ, true);
-        timerAttachInterrupt(_isrMotionTimer, _staticISRStepperMotion, true);
-        timerAlarmWrite(_isrMotionTimer, DIRECT_STEP_ISR_TIMER_PERIOD_US, true);
+        if (_rampGenMode == RAMP_GEN_MODE_STEP_TIMER)
+        {
+            // Alarm is reprogrammed on each ISR call to the time of the next event
+            _isrMotionTimer = timerBegin(0, STEP_TIMER_DIVIDER, true);
+            timerAttachInterrupt(_isrMotionTimer, _staticISRStepperMotion, true);
+            timerAlarmWrite(_isrMotionTimer, _isrPeriodNs / STEP_TIMER_NS_PER_TICK, true);
+        }
+        else
+        {
+            _isrMotionTimer = timerBegin(0, CLOCK_RATE_MHZ, true);
+            timerAttachInterrupt(_isrMotionTimer, _staticISRStepperMotion, true);
+            timerAlarmWrite(_isrMotionTimer, DIRECT_STEP_ISR_TIMER_PERIOD_US, true);
+        }
         timerAlarmEnable(_isrMotionTimer);
         _isrTimerStarted = true;
     }
+#else
+    // Virtual timer is driven from process()
+    _virtualTimerLastUs = micros();
+    _virtualTimerElapsedNs = 0;
+    _isrTimerStarted = _rampGenEnabled;
 #endif
+    _isrLoadLastUs = micros();
+    _isrLoadLastCycles = _isrCycles;
 }
 
 void RampGenerator::stop()
 {
     _isPaused = true;
+    _feedHoldActive = false;
+    _feedScaleQ16 = _feedOverrideQ16;
     _endStopReached = false;
+    _rampGenIO.armEndStops(0, 0);
+    _lastBlockFollowed = false;
+    _stepTimingValid = false;
+    resetStepEvents();
+    flushShapedSteps(UINT32_MAX);
 }
 
+// Clear step commands and the state of the step command being played
+void RampGenerator::resetStepEvents()
+{
+    _stepCmdCompiler.reset();
+    _stepCmdQueue.clear();
+    _stepCmdDiscarding = false;
+    _stepCmdLoaded = false;
+    _stepCmdLastInBlock = false;
+    _stepCmdUnderrun = false;
+    _stepCmdCountLeft = 0;
+    _stepCmdIntervalNs = 0;
+    _stepCmdAddNs = 0;
+    _lastStepNs = _stepClockNs;
+    _nextStepNs = _stepClockNs;
+}
+
+// Pausing is a feed hold - motion decelerates to a stop (see updateFeedScale) and then the ISR
+// pauses so no steps are lost and resuming continues from the same point in the same block
 void RampGenerator::pause(bool pauseIt)
 {
-    _isPaused = pauseIt;
-    if (!_isPaused)
+    _feedHoldActive = pauseIt;
+    if (pauseIt)
     {
-        _endStopReached = false;
+        // Nothing moving so pause immediately
+        if (!_pMotionPipeline->peekGet())
+        {
+            _feedScaleQ16 = 0;
+            _isPaused = true;
+        }
+        return;
     }
+    _isPaused = false;
+    _endStopReached = false;
 }
 
 void RampGenerator::resetTotalStepPosition()
@@ -168,49 +301,55 @@ int RampGenerator::getLastCompletedNumberedCmdIdx()
     return _lastDoneNumberedCmdIdx;
 }
 
+// Axes (bits) whose end-stop checks were met in the last completed numbered command
+uint32_t RampGenerator::getLastCompletedNumberedCmdEndStopHits()
+{
+    return _lastDoneNumberedCmdEndStopHitBits;
+}
+
 // Handle the end of a step for any axis
 bool IRAM_ATTR RampGenerator::handleStepEnd()
 {
-    bool anyPinReset = false;
+    if (_axisStepActiveBits == 0)
+        return false;
+
+    // Reset all step pins driven by mask together
+    if (_stepPinActiveMask)
+        RampGenIO::clearPinsInMask(_stepPinActiveMask);
+    _stepPinActiveMask = 0;
+
+    // Update step counts and reset any other step pins
     for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
     {
-        if (_rampGenIO.stepEnd(axisIdx))
-        {
-            anyPinReset = true;
+        if ((_axisStepActiveBits & (1 << axisIdx)) == 0)
+            continue;
+        if (_rampGenIO.getStepPinMask(axisIdx) == 0)
+            _rampGenIO.stepEnd(axisIdx);
+        // Shaped axes count commanded steps (when they are made)
+        if (!_inputShaper.isShaped(axisIdx))
             _axisTotalSteps[axisIdx] += _totalStepsInc[axisIdx];
-        }
+        _stepRecorder.record(_isrTickCount, MotionStepRecorder::EVENT_STEP_END, axisIdx, 0);
     }
-    return anyPinReset;
+    _axisStepActiveBits = 0;
+    return true;
 }
 
-// Setup new block - cache all the info needed to process the block and reset
-// motion accumulators to facilitate the block's execution
-void IRAM_ATTR RampGenerator::setupNewBlock(MotionBlock *pBlock)
+// Prepare a block's execution record - this is done on the main thread once the block can
+// execute so that the ISR doesn't need to work out which end-stops the block checks
+void RampGenerator::prepareBlockExec(MotionBlock *pBlock)
 {
-    // Setup step counts, direction and endstops for each axis
-    _endStopCheckNum = 0;
+    MotionBlock::ExecRecord& exec = pBlock->_exec;
+    exec._endStopCheckBits = 0;
+    exec._endStopHitLevelBits = 0;
+    if (!pBlock->_endStopsToCheck.any())
+        return;
     for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
     {
-        // Total steps
-        int32_t stepsTotal = pBlock->_stepsTotalMaybeNeg[axisIdx];
-        _stepsTotalAbs[axisIdx] = abs(stepsTotal);
-        _curStepCount[axisIdx] = 0;
-        _curAccumulatorRelative[axisIdx] = 0;
-        // Set direction for the axis
-        _rampGenIO.setDirection(axisIdx, stepsTotal >= 0);
-        _totalStepsInc[axisIdx] = (stepsTotal >= 0) ? 1 : -1;
-
-        // Instrumentation
-        INSTRUMENT_MOTION_ACTUATOR_STEP_DIRN
-
-        // Check if any endstops to setup
-        if (!pBlock->_endStopsToCheck.any())
-            continue;
+        int32_t stepsTotal = pBlock->getStepsToTarget(axisIdx);
 
         // Check if the axis is moving in a direction which might result in hitting an active end-stop
         for (int minMaxIdx = 0; minMaxIdx < AxisMinMaxBools::ENDSTOPS_PER_AXIS; minMaxIdx++)
         {
-            int pinToTest = -1;
             bool valToTestFor = false;
 
             // See if anything to check for
@@ -229,37 +368,128 @@ void IRAM_ATTR RampGenerator::setupNewBlock(MotionBlock *pBlock)
                     continue;
             }
             
-            // Pin for stop
-            pinToTest = (minMaxIdx == AxisMinMaxBools::MIN_VAL_IDX) ? 
-                                _rawMotionHwInfo._axis[axisIdx]._pinEndStopMin : 
-                                _rawMotionHwInfo._axis[axisIdx]._pinEndStopMax;
-
-            // Endstop test
+            // Endstop test - only end-stops with a pin are checked
+            int bitIdx = axisIdx * RobotConsts::MAX_ENDSTOPS_PER_AXIS + minMaxIdx;
+            if (!_endStopPinMasks[bitIdx])
+                continue;
             valToTestFor = (minMaxType != AxisMinMaxBools::END_STOP_NOT_HIT) ? 
                                 _rawMotionHwInfo._axis[axisIdx]._pinEndStopMaxactLvl :
                                 !_rawMotionHwInfo._axis[axisIdx]._pinEndStopMaxactLvl;
-            if (pinToTest != -1)
-            {
-                _endStopChecks[_endStopCheckNum].pin = pinToTest;
-                _endStopChecks[_endStopCheckNum].val = valToTestFor;
-                _endStopCheckNum++;
-            }
+            exec._endStopCheckBits |= (1 << bitIdx);
+            if (valToTestFor)
+                exec._endStopHitLevelBits |= (1 << bitIdx);
+        }
+    }
+}
+
+// Prepare execution records for blocks which have become executable - blocks become
+// executable in order so work back from the newest block to the first one already prepared
+void RampGenerator::prepareBlocksForExec()
+{
+    if (_execHold)
+        return;
+    for (int blockIdx = 0; ; blockIdx++)
+    {
+        MotionBlock* pBlock = _pMotionPipeline->peekNthFromPut(blockIdx);
+        if (!pBlock || pBlock->_execReady)
+            break;
+        if (!pBlock->_canExecute)
+            continue;
+        prepareBlockExec(pBlock);
+        pBlock->_execReady = true;
+    }
+}
+
+// Setup new block - use the block's execution record to set directions and end-stops and
+// reset motion accumulators to facilitate the block's execution
+void IRAM_ATTR RampGenerator::setupNewBlock(MotionBlock *pBlock)
+{
+    // Record - step intervals are measured within a block
+    _stepRecorder.record(_isrTickCount, MotionStepRecorder::EVENT_BLOCK_START, pBlock->_axisIdxWithMaxSteps, 0);
+    _stepTimingValid = false;
+    if (_plannerTrace.isRecording())
+        _curBlockStartUs = micros();
+
+    // Setup step counts and direction for each axis - direction pins driven by mask are set together
+    const MotionBlock::ExecRecord& exec = pBlock->_exec;
+    uint64_t dirnPinSetMask = 0;
+    uint64_t dirnPinClearMask = 0;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+    {
+        _curStepCount[axisIdx] = 0;
+        _curAccumulatorRelative[axisIdx] = 0;
+        bool dirnPositive = (exec._dirnPositiveBits & (1 << axisIdx)) != 0;
+        uint64_t dirnPinMask = _rampGenIO.getDirnPinMask(axisIdx);
+        if (_inputShaper.isShaped(axisIdx))
+        {
+            // Direction pin of shaped axes is set by shapedStepOutput()
         }
+        else if (dirnPinMask == 0)
+            _rampGenIO.setDirection(axisIdx, dirnPositive);
+        else if (_rampGenIO.getDirnPinLevel(axisIdx, dirnPositive))
+            dirnPinSetMask |= dirnPinMask;
+        else
+            dirnPinClearMask |= dirnPinMask;
+        _totalStepsInc[axisIdx] = dirnPositive ? 1 : -1;
+        _stepRecorder.record(_isrTickCount, MotionStepRecorder::EVENT_DIRECTION, axisIdx, dirnPositive);
+
+        // Instrumentation
+#ifdef INSTRUMENT_MOTION_ACTUATOR_ENABLE
+        int32_t stepsTotal = pBlock->getStepsToTarget(axisIdx);
+        INSTRUMENT_MOTION_ACTUATOR_STEP_DIRN
+#endif
     }
 
+    if (dirnPinSetMask)
+        RampGenIO::setPinsInMask(dirnPinSetMask);
+    if (dirnPinClearMask)
+        RampGenIO::clearPinsInMask(dirnPinClearMask);
+
+    // End-stops - pin masks of the end-stops in the record (only homing moves have any)
+    uint64_t endStopPinMask = 0;
+    uint64_t endStopHitLevels = 0;
+    _endStopCheckNum = 0;
+    for (uint32_t checkBits = exec._endStopCheckBits; checkBits != 0; checkBits &= checkBits - 1)
+    {
+        int bitIdx = __builtin_ctz(checkBits);
+        endStopPinMask |= _endStopPinMasks[bitIdx];
+        if (exec._endStopHitLevelBits & (1 << bitIdx))
+            endStopHitLevels |= _endStopPinMasks[bitIdx];
+        _endStopCheckNum++;
+    }
+    _axisEndStopHitBits = 0;
+    _rampGenIO.armEndStops(endStopPinMask, endStopHitLevels);
+
     // Accumulator reset
     _curAccumulatorStep = 0;
     _curAccumulatorNS = 0;
 
     // Step rate
     _curStepRatePerTTicks = pBlock->_initialStepRatePerTTicks;
+
+    // S-curve acceleration phase
+    _sCurveDecelStarted = false;
+    if (_rampGenProfile == RAMP_GEN_PROFILE_S_CURVE)
+        startSCurve(std::max(pBlock->_maxStepRatePerTTicks, MIN_STEP_RATE_PER_TTICKS), pBlock->_accStepsPerTTicksPerMS);
+}
+
+// Start an S-curve ramp from the current rate taking the time a constant acceleration would
+void IRAM_ATTR RampGenerator::startSCurve(uint32_t endRate, uint32_t accPerMs)
+{
+    _sCurveStartRate = _curStepRatePerTTicks;
+    _sCurveEndRate = endRate;
+    _sCurveElapsedMs = 0;
+    uint32_t rateChange = (endRate > _sCurveStartRate) ? endRate - _sCurveStartRate : _sCurveStartRate - endRate;
+    _sCurveDurationMs = (accPerMs == 0) ? 0 : (rateChange + accPerMs - 1) / accPerMs;
+    if (_sCurveDurationMs > S_CURVE_MAX_DURATION_MS)
+        _sCurveDurationMs = S_CURVE_MAX_DURATION_MS;
 }
 
 // Update millisecond accumulator to handle acceleration and deceleration
 void IRAM_ATTR RampGenerator::updateMSAccumulator(MotionBlock *pBlock)
 {
     // Bump the millisec accumulator
-    _curAccumulatorNS += MotionBlock::TICK_INTERVAL_NS;
+    _curAccumulatorNS += feedScale(MotionBlock::TICK_INTERVAL_NS);
 
     // Check for millisec accumulator overflow
     if (_curAccumulatorNS >= MotionBlock::NS_IN_A_MS)
@@ -267,6 +497,27 @@ void IRAM_ATTR RampGenerator::updateMSAccumulator(MotionBlock *pBlock)
         // Subtract from accumulator leaving remainder to combat rounding errors
         _curAccumulatorNS -= MotionBlock::NS_IN_A_MS;
 
+        // S-curve profile
+        if (_rampGenProfile == RAMP_GEN_PROFILE_S_CURVE)
+        {
+            // Deceleration ramp starts from whatever rate has been reached
+            if (!_sCurveDecelStarted && (_curStepCount[pBlock->_axisIdxWithMaxSteps] > pBlock->_stepsBeforeDecel))
+            {
+                _sCurveDecelStarted = true;
+                startSCurve(std::max(pBlock->_finalStepRatePerTTicks, MIN_STEP_RATE_PER_TTICKS), pBlock->_accStepsPerTTicksPerMS);
+            }
+
+            // Rate at this point on the ramp
+            if (_sCurveElapsedMs < _sCurveDurationMs)
+            {
+                _sCurveElapsedMs++;
+                uint32_t fracQ16 = MotionBlock::sCurveFractionQ16((_sCurveElapsedMs << 16) / _sCurveDurationMs);
+                int64_t rateChange = int64_t(_sCurveEndRate) - int64_t(_sCurveStartRate);
+                _curStepRatePerTTicks = uint32_t(int64_t(_sCurveStartRate) + ((rateChange * fracQ16) >> 16));
+            }
+            return;
+        }
+
         // Check if decelerating
         if (_curStepCount[pBlock->_axisIdxWithMaxSteps] > pBlock->_stepsBeforeDecel)
         {
@@ -282,6 +533,47 @@ void IRAM_ATTR RampGenerator::updateMSAccumulator(MotionBlock *pBlock)
     }
 }
 
+// Ramp the feed scale towards the feed override (or zero during a feed hold) - the scale
+// changes from zero to one in the time the executing block takes to accelerate to its max
+// rate so the extra acceleration is at most the block's acceleration
+// Changes are immediate when there is no motion
+void IRAM_ATTR RampGenerator::updateFeedScale()
+{
+    uint32_t targetQ16 = _feedHoldActive ? 0 : _feedOverrideQ16;
+    if (_feedScaleQ16 != targetQ16)
+    {
+        MotionBlock *pBlock = _pMotionPipeline->peekGet();
+        if (!pBlock || (pBlock->_accStepsPerTTicksPerMS == 0))
+        {
+            _feedScaleQ16 = targetQ16;
+        }
+        else
+        {
+            _feedScaleAccumNs += _isrPeriodNs;
+            if (_feedScaleAccumNs >= MotionBlock::NS_IN_A_MS)
+            {
+                _feedScaleAccumNs -= MotionBlock::NS_IN_A_MS;
+                uint32_t maxRate = std::max(pBlock->_maxStepRatePerTTicks, MIN_STEP_RATE_PER_TTICKS);
+                uint32_t changeQ16 = uint32_t((uint64_t(pBlock->_accStepsPerTTicksPerMS) << 16) / maxRate);
+                if (changeQ16 == 0)
+                    changeQ16 = 1;
+                if (_feedScaleQ16 < targetQ16)
+                    _feedScaleQ16 = std::min(_feedScaleQ16 + changeQ16, targetQ16);
+                else
+                    _feedScaleQ16 = (_feedScaleQ16 > targetQ16 + changeQ16) ? _feedScaleQ16 - changeQ16 : targetQ16;
+            }
+        }
+    }
+    else
+    {
+        _feedScaleAccumNs = 0;
+    }
+
+    // Feed hold complete
+    if (_feedHoldActive && (_feedScaleQ16 == 0))
+        _isPaused = true;
+}
+
 // Handle start of step on each axis
 bool IRAM_ATTR RampGenerator::handleStepMotion(MotionBlock *pBlock)
 {
@@ -291,16 +583,16 @@ bool IRAM_ATTR RampGenerator::handleStepMotion(MotionBlock *pBlock)
     // Axis with most steps
     int axisIdxMaxSteps = pBlock->_axisIdxWithMaxSteps;
 
-    // Subtract from accumulator leaving remainder
-    _curAccumulatorStep -= MotionBlock::TTICKS_VALUE;
+    // Step pins to set together
+    uint64_t stepPinMask = 0;
 
     // Step the axis with the greatest step count if needed
-    if (_curStepCount[axisIdxMaxSteps] < _stepsTotalAbs[axisIdxMaxSteps])
+    if (_curStepCount[axisIdxMaxSteps] < pBlock->_exec._stepsTotalAbs[axisIdxMaxSteps])
     {
         // Step this axis
-        _rampGenIO.stepStart(axisIdxMaxSteps);
+        startAxisStep(axisIdxMaxSteps, stepPinMask);
         _curStepCount[axisIdxMaxSteps]++;
-        if (_curStepCount[axisIdxMaxSteps] < _stepsTotalAbs[axisIdxMaxSteps])
+        if (_curStepCount[axisIdxMaxSteps] < pBlock->_exec._stepsTotalAbs[axisIdxMaxSteps])
             anyAxisMoving = true;
 
         // Instrumentation
@@ -310,20 +602,20 @@ bool IRAM_ATTR RampGenerator::handleStepMotion(MotionBlock *pBlock)
     // Check if other axes need stepping
     for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
     {
-        if ((axisIdx == axisIdxMaxSteps) || (_curStepCount[axisIdx] == _stepsTotalAbs[axisIdx]))
+        if ((axisIdx == axisIdxMaxSteps) || (_curStepCount[axisIdx] == pBlock->_exec._stepsTotalAbs[axisIdx]))
             continue;
 
         // Bump the relative accumulator
-        _curAccumulatorRelative[axisIdx] += _stepsTotalAbs[axisIdx];
-        if (_curAccumulatorRelative[axisIdx] >= _stepsTotalAbs[axisIdxMaxSteps])
+        _curAccumulatorRelative[axisIdx] += pBlock->_exec._stepsTotalAbs[axisIdx];
+        if (_curAccumulatorRelative[axisIdx] >= pBlock->_exec._stepsTotalAbs[axisIdxMaxSteps])
         {
             // Do the remainder calculation
-            _curAccumulatorRelative[axisIdx] -= _stepsTotalAbs[axisIdxMaxSteps];
+            _curAccumulatorRelative[axisIdx] -= pBlock->_exec._stepsTotalAbs[axisIdxMaxSteps];
 
             // Step the axis
-            _rampGenIO.stepStart(axisIdx);
+            startAxisStep(axisIdx, stepPinMask);
             _curStepCount[axisIdx]++;
-            if (_curStepCount[axisIdx] < _stepsTotalAbs[axisIdx])
+            if (_curStepCount[axisIdx] < pBlock->_exec._stepsTotalAbs[axisIdx])
                 anyAxisMoving = true;
 
             // Instrumentation
@@ -331,16 +623,306 @@ bool IRAM_ATTR RampGenerator::handleStepMotion(MotionBlock *pBlock)
         }
     }
 
+    // Set step pins
+    if (stepPinMask)
+        RampGenIO::setPinsInMask(stepPinMask);
+    _stepPinActiveMask |= stepPinMask;
+
     // Return indicator of block complete
     return anyAxisMoving;
 }
 
+// Start a step on an axis - axes with a step pin mask are added to the mask to be set
+// in one write, others are stepped individually
+void IRAM_ATTR RampGenerator::startAxisStep(int axisIdx, uint64_t& stepPinMask)
+{
+    // Axes stopped by their end-stop make no more steps in the block
+    if (_axisEndStopHitBits & (1 << axisIdx))
+        return;
+
+    // Steps on shaped axes are passed to the input shaper which makes the physical steps
+    if (_inputShaper.isShaped(axisIdx))
+    {
+        _inputShaper.cmdStep(axisIdx, _totalStepsInc[axisIdx] > 0, _isrTickCount);
+        _axisTotalSteps[axisIdx] += _totalStepsInc[axisIdx];
+        _stepRecorder.record(_isrTickCount, MotionStepRecorder::EVENT_STEP_START, axisIdx, 1);
+        return;
+    }
+    uint64_t axisPinMask = _rampGenIO.getStepPinMask(axisIdx);
+    if (axisPinMask)
+        stepPinMask |= axisPinMask;
+    else
+        _rampGenIO.stepStart(axisIdx);
+    _axisStepActiveBits |= (1 << axisIdx);
+    _stepRecorder.record(_isrTickCount, MotionStepRecorder::EVENT_STEP_START, axisIdx, 1);
+}
+
+// Make the physical steps for shaped axes - this runs on every tick (even with no block) as
+// shaped motion finishes after the commanded motion
+void IRAM_ATTR RampGenerator::shapedStepOutput()
+{
+    uint64_t stepPinMask = 0;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+    {
+        if (!_inputShaper.isShaped(axisIdx))
+            continue;
+        int stepDirn = _inputShaper.stepNeeded(axisIdx, _isrTickCount);
+        if (stepDirn == 0)
+            continue;
+
+        // Direction
+        bool dirnPositive = stepDirn > 0;
+        if (_inputShaper.setOutDirn(axisIdx, dirnPositive))
+        {
+            uint64_t dirnPinMask = _rampGenIO.getDirnPinMask(axisIdx);
+            if (dirnPinMask == 0)
+                _rampGenIO.setDirection(axisIdx, dirnPositive);
+            else if (_rampGenIO.getDirnPinLevel(axisIdx, dirnPositive))
+                RampGenIO::setPinsInMask(dirnPinMask);
+            else
+                RampGenIO::clearPinsInMask(dirnPinMask);
+        }
+
+        // Step
+        uint64_t axisPinMask = _rampGenIO.getStepPinMask(axisIdx);
+        if (axisPinMask)
+            stepPinMask |= axisPinMask;
+        else
+            _rampGenIO.stepStart(axisIdx);
+        _axisStepActiveBits |= (1 << axisIdx);
+    }
+    if (stepPinMask)
+        RampGenIO::setPinsInMask(stepPinMask);
+    _stepPinActiveMask |= stepPinMask;
+}
+
+// Abandon shaped steps not yet made (stop or end-stop hit) - the step position is corrected
+// as steps are counted when they are commanded
+void IRAM_ATTR RampGenerator::flushShapedSteps(uint32_t axisBits)
+{
+    if (!_inputShaper.isEnabled())
+        return;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+        if ((axisBits & (1 << axisIdx)) && _inputShaper.isShaped(axisIdx))
+            _axisTotalSteps[axisIdx] -= _inputShaper.flush(axisIdx);
+}
+
 void IRAM_ATTR RampGenerator::endMotion(MotionBlock *pBlock)
 {
+    _stepRecorder.record(_isrTickCount, MotionStepRecorder::EVENT_BLOCK_END, pBlock->_axisIdxWithMaxSteps, _endStopReached);
+    if (_plannerTrace.isRecording())
+        _plannerTrace.record(*pBlock, _curBlockStartUs, micros());
     _pMotionPipeline->remove();
-    // Check if this is a numbered block - if so record its completion
+    _lastBlockFollowed = pBlock->_blockIsFollowed;
+    _followedBlockGapNs = 0;
+    // Check if this is a numbered block - if so record its completion (after the end-stops it hit
+    // as they are read once the index shows the block is complete)
     if (pBlock->getNumberedCommandIndex() != RobotConsts::NUMBERED_COMMAND_NONE)
+    {
+        _lastDoneNumberedCmdEndStopHitBits = _axisEndStopHitBits;
         _lastDoneNumberedCmdIdx = pBlock->getNumberedCommandIndex();
+    }
+}
+
+// Count a tick with nothing to execute - the cause is the planner if there is work waiting to
+// be planned, otherwise it is upstream (files, evaluators, etc) if work items are queued
+void IRAM_ATTR RampGenerator::countUnderrun()
+{
+    _stepTimingValid = false;
+    if (_plannerWorkQueued)
+    {
+        _underrunPlannerTicks++;
+        _underrunPlannerNs += _isrPeriodNs;
+    }
+    else if (_upstreamWorkQueued)
+    {
+        _underrunUpstreamTicks++;
+        _underrunUpstreamNs += _isrPeriodNs;
+    }
+
+    // Motion has stopped if the gap after a block which should have been followed is long enough
+    if (_lastBlockFollowed)
+    {
+        _followedBlockGapNs += _isrPeriodNs;
+        if (_followedBlockGapNs >= FOLLOWED_BLOCK_STOP_MIN_NS)
+        {
+            _followedBlockStopCount++;
+            _lastBlockFollowed = false;
+        }
+    }
+}
+
+// Record the deviation of the time since the last step from the planned step interval
+void IRAM_ATTR RampGenerator::recordStepTiming(uint32_t plannedStepNs)
+{
+    if (_stepTimingValid && (_cpuFreqMHz > 0))
+    {
+        int64_t actualNs = (uint64_t(_isrStartCycles - _lastStepCycles) * 1000) / _cpuFreqMHz;
+        int64_t devNs = actualNs - plannedStepNs;
+        _timingStats.recordStepDeviation(int32_t(std::max(std::min(devNs, int64_t(INT32_MAX)), int64_t(-INT32_MAX))));
+    }
+    _lastStepCycles = _isrStartCycles;
+    _stepTimingValid = true;
+}
+
+// Check endstops - hits are latched by the end-stop GPIO interrupts
+bool IRAM_ATTR RampGenerator::checkEndStops()
+{
+    return _rampGenIO.isEndStopHit();
+}
+
+// Stop the axes whose end-stops have been hit - other axes carry on so several axes can home
+// in one block, each stopping at its own end-stop
+// Returns true when no end-stops are left to check (the block ends)
+bool IRAM_ATTR RampGenerator::handleEndStopHits()
+{
+    _endStopReached = true;
+    uint64_t hitPinMask = _rampGenIO.takeEndStopHits();
+    uint32_t hitAxisBits = 0;
+    for (int axisIdx = 0; axisIdx < RobotConsts::MAX_AXES; axisIdx++)
+    {
+        uint64_t axisPinMask = RampGenIO::getPinMask(_rawMotionHwInfo._axis[axisIdx]._pinEndStopMin) |
+                               RampGenIO::getPinMask(_rawMotionHwInfo._axis[axisIdx]._pinEndStopMax);
+        if (hitPinMask & axisPinMask)
+            hitAxisBits |= (1 << axisIdx);
+    }
+    _axisEndStopHitBits |= hitAxisBits;
+    if (!_rampGenIO.anyEndStopsArmed())
+    {
+        flushShapedSteps(UINT32_MAX);
+        return true;
+    }
+    flushShapedSteps(hitAxisBits);
+    return false;
+}
+
+// Step event mode - play step commands compiled from the block
+void IRAM_ATTR RampGenerator::isrStepEvents(MotionBlock *pBlock)
+{
+    // Wait until the block's step commands are being compiled
+    if (pBlock->_stepCompileState == MotionBlock::STEP_COMPILE_NONE)
+    {
+        countUnderrun();
+        return;
+    }
+
+    // New block
+    bool newBlock = !pBlock->_isExecuting;
+    pBlock->_isExecuting = true;
+    _isrBlockTickCount++;
+    if (newBlock)
+    {
+        setupNewBlock(pBlock);
+        _stepCmdLoaded = false;
+        _stepCmdLastInBlock = false;
+        _stepCmdUnderrun = false;
+        _lastStepNs = _stepClockNs;
+    }
+
+    // Handle end-stop hit
+    if (checkEndStops() && handleEndStopHits())
+    {
+        endStepEventBlock(pBlock);
+        return;
+    }
+
+    // Get the next step command if needed
+    if (!_stepCmdLoaded)
+    {
+        StepCommand* pCmd = _stepCmdQueue.peekGet();
+        if (!pCmd)
+        {
+            _stepCmdUnderrun = true;
+            countUnderrun();
+            return;
+        }
+        _stepCmdCountLeft = pCmd->_count;
+        _stepCmdIntervalNs = pCmd->_intervalNs;
+        _stepCmdAddNs = pCmd->_addNs;
+        _stepCmdLastInBlock = (pCmd->_flags & StepCommand::STEP_CMD_FLAG_LAST_IN_BLOCK) != 0;
+        _stepCmdQueue.remove();
+        _stepCmdLoaded = _stepCmdCountLeft > 0;
+        if (!_stepCmdLoaded)
+        {
+            if (_stepCmdLastInBlock)
+                endStepEventBlock(pBlock);
+            return;
+        }
+
+        // After an underrun timing restarts from now
+        if (_stepCmdUnderrun)
+            _lastStepNs = _stepClockNs;
+        _stepCmdUnderrun = false;
+        _nextStepNs = _lastStepNs + _stepCmdIntervalNs;
+    }
+
+    // Check if the step is due - if it is very late (e.g. after a pause) then restart timing
+    int32_t lateNs = int32_t(_stepClockNs - _nextStepNs);
+    if (lateNs < 0)
+        return;
+    if (lateNs > STEP_EVENT_MAX_LATENESS_NS)
+        _nextStepNs = _stepClockNs;
+
+    // Step (the planned interval is on the step clock so convert it to real time)
+    bool anyAxisMoving = handleStepMotion(pBlock);
+    _isrStepTickCount++;
+    if (_feedScaleQ16 > 0)
+        recordStepTiming(uint32_t(std::min((uint64_t(_nextStepNs - _lastStepNs) << 16) / _feedScaleQ16, uint64_t(UINT32_MAX))));
+    _lastStepNs = _nextStepNs;
+
+    // Move on in the step command
+    _stepCmdCountLeft--;
+    if (_stepCmdCountLeft == 0)
+    {
+        _stepCmdLoaded = false;
+    }
+    else
+    {
+        _stepCmdIntervalNs += _stepCmdAddNs;
+        _nextStepNs = _lastStepNs + _stepCmdIntervalNs;
+    }
+
+    // Check if the block is complete
+    if (!anyAxisMoving)
+        endStepEventBlock(pBlock);
+}
+
+// End a block in step event mode - if the block's last step command hasn't been taken from the
+// queue the rest of its commands are discarded first and the block is only removed from the
+// pipeline once they have been (the compiler may still be using the block until then)
+void IRAM_ATTR RampGenerator::endStepEventBlock(MotionBlock *pBlock)
+{
+    bool discard = !_stepCmdLastInBlock;
+    _stepCmdLoaded = false;
+    _stepCmdLastInBlock = false;
+    if (discard)
+        _stepCmdDiscarding = true;
+    else
+        endMotion(pBlock);
+}
+
+// Discard step commands up to and including the last command of a block that ended early and
+// then remove the block
+// Returns true when discarding is complete
+bool IRAM_ATTR RampGenerator::discardStepCmds()
+{
+    for (uint32_t i = 0; i < STEP_CMD_MAX_DISCARD_PER_TICK; i++)
+    {
+        StepCommand* pCmd = _stepCmdQueue.peekGet();
+        if (!pCmd)
+            return false;
+        bool lastInBlock = (pCmd->_flags & StepCommand::STEP_CMD_FLAG_LAST_IN_BLOCK) != 0;
+        _stepCmdQueue.remove();
+        if (lastInBlock)
+        {
+            _stepCmdDiscarding = false;
+            MotionBlock *pBlock = _pMotionPipeline->peekGet();
+            if (pBlock && pBlock->_isExecuting)
+                endMotion(pBlock);
+            return true;
+        }
+    }
+    return false;
 }
 
 #ifdef DEBUG_MONITOR_ISR_OPERATION
@@ -355,11 +937,66 @@ volatile int maxStepRt = -1;
 #endif
 
 // Function that handles ISR calls based on a timer
-// When ISR is enabled this is called every MotionBlock::TICK_INTERVAL_NS nanoseconds
+// When ISR is enabled this is called every MotionBlock::TICK_INTERVAL_NS nanoseconds except
+// in step timer mode where the time to the next call is set on each call
 void IRAM_ATTR RampGenerator::_staticISRStepperMotion()
 {
-    if (_pThis)
-        _pThis->isrStepperMotion();
+    if (!_pThis)
+        return;
+    uint32_t startCycles = XTHAL_GET_CCOUNT();
+    _pThis->_isrStartCycles = startCycles;
+    _pThis->isrStepperMotion();
+    if (_pThis->_rampGenMode == RAMP_GEN_MODE_STEP_TIMER)
+        _pThis->setStepTimerPeriod();
+    uint32_t isrCycles = XTHAL_GET_CCOUNT() - startCycles;
+    _pThis->_isrCycles += isrCycles;
+    _pThis->_timingStats.recordISRCycles(isrCycles);
+}
+
+// Time until the ISR is next needed in step timer mode
+uint32_t IRAM_ATTR RampGenerator::stepTimerPeriodNs()
+{
+    // End the step pulse or finish discarding as soon as possible
+    if (_axisStepActiveBits || _stepCmdDiscarding)
+        return STEP_TIMER_MIN_PERIOD_NS;
+
+    // Nothing to do
+    if (_isPaused)
+        return STEP_TIMER_IDLE_PERIOD_NS;
+    MotionBlock *pBlock = _pMotionPipeline->peekGet();
+    if (!pBlock || (pBlock->_stepCompileState == MotionBlock::STEP_COMPILE_NONE))
+        return STEP_TIMER_IDLE_PERIOD_NS;
+
+    // Block to start or step command to load
+    if (!pBlock->_isExecuting)
+        return STEP_TIMER_MIN_PERIOD_NS;
+    if (!_stepCmdLoaded)
+        return _stepCmdQueue.peekGet() ? STEP_TIMER_MIN_PERIOD_NS : STEP_TIMER_UNDERRUN_PERIOD_NS;
+
+    // Time to the next step (converted from the step clock to real time) - limited if end-stops
+    // need to be polled
+    int32_t untilStepNs = int32_t(_nextStepNs - _stepClockNs);
+    if ((untilStepNs > 0) && (_feedScaleQ16 > 0))
+        untilStepNs = int32_t(std::min((int64_t(untilStepNs) << 16) / _feedScaleQ16, int64_t(INT32_MAX)));
+    else if (untilStepNs > 0)
+        untilStepNs = INT32_MAX;
+    uint32_t maxPeriodNs = (_endStopCheckNum > 0) ? STEP_TIMER_ENDSTOP_PERIOD_NS : STEP_TIMER_IDLE_PERIOD_NS;
+    if (untilStepNs < int32_t(STEP_TIMER_MIN_PERIOD_NS))
+        return STEP_TIMER_MIN_PERIOD_NS;
+    if (uint32_t(untilStepNs) > maxPeriodNs)
+        return maxPeriodNs;
+    return untilStepNs;
+}
+
+// Set the timer alarm for the next ISR call in step timer mode
+void IRAM_ATTR RampGenerator::setStepTimerPeriod()
+{
+    uint32_t timerTicks = stepTimerPeriodNs() / STEP_TIMER_NS_PER_TICK;
+    _isrPeriodNs = timerTicks * STEP_TIMER_NS_PER_TICK;
+#ifdef USE_ESP32_TIMER_ISR
+    if (_isrTimerStarted)
+        timerAlarmWrite(_isrMotionTimer, timerTicks, true);
+#endif
 }
 
 void IRAM_ATTR RampGenerator::isrStepperMotion()
@@ -367,62 +1004,85 @@ void IRAM_ATTR RampGenerator::isrStepperMotion()
     // Instrumentation code to time ISR execution (if enabled - see MotionInstrumentation.h)
     INSTRUMENT_MOTION_ACTUATOR_TIME_START
 
+    // Count ticks, ramp the feed scale and advance the step clock
+    _isrTickCount++;
+    if (!_isPaused)
+    {
+        updateFeedScale();
+        _stepClockNs += feedScale(_isrPeriodNs);
+    }
+
     // Do a step-end for any motor which needs one - return here to avoid too short a pulse
     if (handleStepEnd())
         return;
 
     // Check if paused
     if (_isPaused)
+    {
+        _stepTimingValid = false;
+        return;
+    }
+
+    // Physical steps for shaped axes
+    if (_inputShaper.isEnabled())
+        shapedStepOutput();
+
+    // Finish discarding step commands from a block which ended early
+    if (_stepCmdDiscarding && !discardStepCmds())
         return;
 
-    // Peek a MotionPipelineElem from the queue
+    // Peek a MotionPipelineElem from the queue - count the times the pipeline runs dry
+    // while there is more work waiting to be planned
     MotionBlock *pBlock = _pMotionPipeline->peekGet();
     if (!pBlock)
+    {
+        if (_pipelineHadBlock && (_plannerWorkQueued || _upstreamWorkQueued))
+            _pipelineStarvedCount++;
+        _pipelineHadBlock = false;
+        countUnderrun();
         return;
+    }
+    _pipelineHadBlock = true;
+
+    // Step event modes are handled separately
+    if (usesStepCommands())
+    {
+        isrStepEvents(pBlock);
+        return;
+    }
 
     // Check if the element can be executed
-    if (!pBlock->_canExecute)
+    if (!pBlock->_execReady)
+    {
+        countUnderrun();
         return;
+    }
 
     // See if the block was already executing and set isExecuting if not
     bool newBlock = !pBlock->_isExecuting;
     pBlock->_isExecuting = true;
+    _isrBlockTickCount++;
 
-    // New block
+    // New block - the execution record is prepared so the block starts stepping in this tick
     if (newBlock)
-    {
-        // Setup new block
         setupNewBlock(pBlock);
 
-        // Return here to reduce the maximum time this function takes
-        // Assuming this function is called frequently (<50uS intervals say)
-        // then it will make little difference if we return now and pick up on the next tick
-        return;
-    }
-
-    // Check endstops        
-    bool endStopHit = false;
-    for (int i = 0; i < _endStopCheckNum; i++)
-    {
-        bool pinVal = digitalRead(_endStopChecks[i].pin);
-        if (pinVal == _endStopChecks[i].val)
-            endStopHit = true;
-    }
-
     // Handle end-stop hit
-    if (endStopHit)
+    if (checkEndStops() && handleEndStopHits())
     {
-        // Cancel motion (by removing the block) as end-stop reached
-        _endStopReached = true;
+        // Cancel motion (by removing the block) as all end-stops reached
         endMotion(pBlock);
+        return;
     }
 
     // Update the millisec accumulator - this handles the process of changing speed incrementally to
     // implement acceleration and deceleration
     updateMSAccumulator(pBlock);
 
-    // Bump the step accumulator
-    _curAccumulatorStep += std::max(_curStepRatePerTTicks, MIN_STEP_RATE_PER_TTICKS);
+    // Bump the step accumulator - at most one step can be made per tick
+    uint32_t stepRateInc = std::min(feedScale(std::max(_curStepRatePerTTicks, MIN_STEP_RATE_PER_TTICKS)),
+                                    MotionBlock::TTICKS_VALUE);
+    _curAccumulatorStep += stepRateInc;
 
 #ifdef DEBUG_MONITOR_ISR_OPERATION
     accumStep = _curAccumulatorStep;
@@ -441,8 +1101,14 @@ void IRAM_ATTR RampGenerator::isrStepperMotion()
         // Flag indicating this block is finished
         bool anyAxisMoving = false;
 
+        // Subtract from accumulator leaving remainder
+        _curAccumulatorStep -= MotionBlock::TTICKS_VALUE;
+
         // Handle a step
         anyAxisMoving = handleStepMotion(pBlock);
+        _isrStepTickCount++;
+        if (stepRateInc > 0)
+            recordStepTiming(uint32_t((uint64_t(MotionBlock::TTICKS_VALUE) * _isrPeriodNs) / stepRateInc));
 
         // Any axes still moving?
         if (!anyAxisMoving)
@@ -465,9 +1131,30 @@ void RampGenerator::process()
     // If using a controller with a ramp generator then service the block handling
     if (_rampGenEnabled)
     {
-        // If not using ISR call _isrStepperMotion on every process call
+        // Prepare blocks for the ISR
+        prepareBlocksForExec();
+
+        // Compile blocks into step commands
+        if (usesStepCommands())
+            serviceStepCompiler();
+
+        // If not using the ISR then run a virtual timer - the ISR function is called once
+        // for every ISR period that has elapsed since the last call
 #ifndef USE_ESP32_TIMER_ISR
-        _isrStepperMotion();
+        uint32_t nowUs = micros();
+        _virtualTimerElapsedNs += (nowUs - _virtualTimerLastUs) * 1000;
+        _virtualTimerLastUs = nowUs;
+        uint32_t ticksRun = 0;
+        while (_virtualTimerElapsedNs >= _isrPeriodNs)
+        {
+            _virtualTimerElapsedNs -= _isrPeriodNs;
+            _staticISRStepperMotion();
+            if (++ticksRun >= VIRTUAL_TIMER_MAX_TICKS_PER_PROCESS)
+            {
+                _virtualTimerElapsedNs = 0;
+                break;
+            }
+        }
 #endif
     }
 
@@ -486,10 +1173,21 @@ String RampGenerator::getDebugStr()
     char dbg[200];
     sprintf(dbg, "accum %d rate %d accacc %d maxstepidx %d accrate %d cursteps %d befDec %d maxRt %d",
             accumStep, stepRate, accelacc, maxstepax, accrate, curSteps, befDec, maxStepRt);
-    anymov = 6;
     return dbg;
 #endif
-    return "";
+    // ISR load since last called
+    uint32_t nowUs = micros();
+    uint64_t isrCycles = _isrCycles;
+    float isrLoadPC = 0;
+    if (nowUs != _isrLoadLastUs)
+        isrLoadPC = 100.0f * (isrCycles - _isrLoadLastCycles) / (float(getCpuFrequencyMhz()) * (nowUs - _isrLoadLastUs));
+    _isrLoadLastUs = nowUs;
+    _isrLoadLastCycles = isrCycles;
+    char tickStr[140];
+    snprintf(tickStr, sizeof(tickStr), "ticks %u blkTicks %u stepTicks %u isrLoad %.2f%% starved %u",
+            (unsigned)_isrTickCount, (unsigned)_isrBlockTickCount, (unsigned)_isrStepTickCount, isrLoadPC,
+            (unsigned)_pipelineStarvedCount);
+    return tickStr;
 }
 
 void RampGenerator::showDebug()
@@ -499,3 +1197,122 @@ void RampGenerator::showDebug()
         _pMotionInstrumentation->showDebug();
 #endif
 }
+
+// Compile blocks which are ready to execute into step commands - blocks are only compiled
+// a short time ahead of execution so that the planner can keep refining them
+void RampGenerator::serviceStepCompiler()
+{
+    // Check if the block being compiled has been ended early by the ISR - the ISR keeps the block
+    // in the pipeline until the compiler has queued its last command
+    if (_stepCmdDiscarding && _stepCmdCompiler.isBusy() && _stepCmdCompiler.getBlock()->_isExecuting)
+        _stepCmdCompiler.abortBlock(_stepCmdQueue);
+
+    while (true)
+    {
+        // Find the next block to compile if not already compiling one
+        if (!_stepCmdCompiler.isBusy())
+        {
+            MotionBlock* pNextBlock = NULL;
+            uint32_t compiledAheadUs = 0;
+            for (int blockIdx = 0; ; blockIdx++)
+            {
+                MotionBlock* pBlock = _pMotionPipeline->peekNthFromGet(blockIdx);
+                if (!pBlock)
+                    break;
+                if (pBlock->_stepCompileState == MotionBlock::STEP_COMPILE_NONE)
+                {
+                    pNextBlock = pBlock;
+                    break;
+                }
+                if (!pBlock->_isExecuting)
+                    compiledAheadUs += pBlock->_stepCompileDurationUs;
+            }
+            if (!pNextBlock || !pNextBlock->_execReady || (compiledAheadUs > uint32_t((uint64_t(_stepCompileLeadUs) * _feedOverrideQ16) >> 16)))
+                return;
+            _stepCmdCompiler.startBlock(pNextBlock, MIN_STEP_RATE_PER_SEC, _rampGenProfile == RAMP_GEN_PROFILE_S_CURVE);
+        }
+
+        // Compile - stop when the queue is full or enough work has been done
+        if (!_stepCmdCompiler.compile(_stepCmdQueue, STEP_COMPILE_MAX_STEPS_PER_SERVICE))
+            return;
+    }
+}
+
+// Set the feed override - takes effect immediately on all blocks including the one executing
+// (ramped at the block's acceleration)
+void RampGenerator::setFeedOverride(float percent)
+{
+    percent = std::min(std::max(percent, FEED_OVERRIDE_MIN_PERCENT), FEED_OVERRIDE_MAX_PERCENT);
+    _feedOverrideQ16 = uint32_t(percent * 65536 / 100);
+    Log.notice("%sfeed override %F%%\n", MODULE_PREFIX, percent);
+}
+
+float RampGenerator::getFeedOverride()
+{
+    return _feedOverrideQ16 * 100.0f / 65536;
+}
+
+void RampGenerator::stepRecorderStart(int maxEvents)
+{
+    _stepRecorder.start(maxEvents);
+    Log.notice("RampGenerator: step recorder started maxEvents %d\n", maxEvents);
+}
+
+void RampGenerator::stepRecorderStop()
+{
+    _stepRecorder.stop();
+    Log.notice("RampGenerator: step recorder stopped events %d\n", _stepRecorder.count());
+}
+
+void RampGenerator::getStepRecord(String& csvStr)
+{
+    _stepRecorder.getCSV(csvStr);
+}
+
+void RampGenerator::plannerTraceStart(int maxBlocks)
+{
+    _plannerTrace.start(maxBlocks);
+    Log.notice("RampGenerator: planner trace started maxBlocks %d\n", maxBlocks);
+}
+
+void RampGenerator::plannerTraceStop()
+{
+    _plannerTrace.stop();
+    Log.notice("RampGenerator: planner trace stopped blocks %d\n", _plannerTrace.count());
+}
+
+void RampGenerator::getPlannerTrace(String& csvStr)
+{
+    _plannerTrace.getCSV(csvStr);
+}
+
+void RampGenerator::getUnderrunStats(String& jsonStr)
+{
+    char statsStr[200];
+    snprintf(statsStr, sizeof(statsStr),
+            "\"starved\":%u,\"planUnderrunTicks\":%u,\"planUnderrunMs\":%u,"
+            "\"upstreamUnderrunTicks\":%u,\"upstreamUnderrunMs\":%u,\"followedStops\":%u",
+            (unsigned)_pipelineStarvedCount, (unsigned)_underrunPlannerTicks, (unsigned)(_underrunPlannerNs / 1000000),
+            (unsigned)_underrunUpstreamTicks, (unsigned)(_underrunUpstreamNs / 1000000), (unsigned)_followedBlockStopCount);
+    jsonStr = statsStr;
+}
+
+void RampGenerator::resetUnderrunStats()
+{
+    _pipelineHadBlock = false;
+    _pipelineStarvedCount = 0;
+    _underrunPlannerTicks = 0;
+    _underrunUpstreamTicks = 0;
+    _underrunPlannerNs = 0;
+    _underrunUpstreamNs = 0;
+    _lastBlockFollowed = false;
+    _followedBlockGapNs = 0;
+    _followedBlockStopCount = 0;
+}
+
+void RampGenerator::getISRTickCounts(uint32_t& ticks, uint32_t& blockTicks, uint32_t& stepTicks)
+{
+    ticks = _isrTickCount;
+    blockTicks = _isrBlockTickCount;
+    stepTicks = _isrStepTickCount;
+}
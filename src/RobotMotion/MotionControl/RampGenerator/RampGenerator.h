@@ -9,13 +9,45 @@
 
 #include <ArduinoLog.h>
 #include "MotionInstrumentation.h"
+#include "MotionStepRecorder.h"
+#include "MotionTimingStats.h"
+#include "MotionPlannerTrace.h"
+#include "StepCommandQueue.h"
+#include "StepCommandCompiler.h"
 #include "../MotionBlock.h"
 #include "RampGenIO.h"
+#include "InputShaper.h"
 
 class MotionPipeline;
 
 class RampGenerator
 {
+public:
+    // Ramp generation modes
+    // Accumulator - rates and acceleration are computed in the ISR on each tick
+    // Step events - blocks are compiled on the main thread into step commands which the ISR plays
+    // Step timer - as step events but the timer is set to fire at the time of the next step
+    enum RampGenMode
+    {
+        RAMP_GEN_MODE_ACCUMULATOR,
+        RAMP_GEN_MODE_STEP_EVENTS,
+        RAMP_GEN_MODE_STEP_TIMER
+    };
+
+    // Acceleration profiles
+    // Trapezoid - constant acceleration
+    // S-curve - acceleration ramps up and down smoothly (jerk limited) with the ramp taking the
+    // same time and distance as the trapezoid
+    enum RampGenProfile
+    {
+        RAMP_GEN_PROFILE_TRAPEZOID,
+        RAMP_GEN_PROFILE_S_CURVE
+    };
+
+    // Feed override limits (percent)
+    static constexpr float FEED_OVERRIDE_MIN_PERCENT = 10;
+    static constexpr float FEED_OVERRIDE_MAX_PERCENT = 200;
+
 private:
     // This singleton
     static RampGenerator* _pThis;
@@ -23,6 +55,14 @@ private:
     // If this is true nothing will move
     volatile bool _isPaused;
 
+    // Execution hold - blocks are not made ready for execution while this is set (used to buffer
+    // blocks before starting from stopped)
+    bool _execHold;
+
+    // Feed hold - pausing ramps the feed scale down to zero so motion decelerates along the
+    // path and the ISR then pauses with the remaining steps and planned blocks intact
+    volatile bool _feedHoldActive;
+
     // Steps moved in total and increment based on direction
     volatile int32_t _axisTotalSteps[RobotConsts::MAX_AXES];
     volatile int32_t _totalStepsInc[RobotConsts::MAX_AXES];
@@ -33,8 +73,14 @@ private:
     // Motors and endstops
     RampGenIO _rampGenIO;
 
+    // Input shaping of axes which ring
+    InputShaper _inputShaper;
+
     // Raw access to motors and endstops
     RobotConsts::RawMotionHwInfo_t _rawMotionHwInfo;
+    // End-stop pin masks by end-stop bit (axisIdx * MAX_ENDSTOPS_PER_AXIS + endStopIdx) of a
+    // block's execution record
+    uint64_t _endStopPinMasks[RobotConsts::MAX_AXES * RobotConsts::MAX_ENDSTOPS_PER_AXIS];
 
     // This is to ensure that the robot never goes to 0 tick rate - which would leave it
     // immobile forever
@@ -51,9 +97,114 @@ private:
     hw_timer_t *_isrMotionTimer;
     static constexpr uint32_t CLOCK_RATE_MHZ = 80;
     static constexpr uint32_t DIRECT_STEP_ISR_TIMER_PERIOD_US = uint32_t(MotionBlock::TICK_INTERVAL_NS / 1000l);
+#else
+    // Virtual timer - process() runs the ISR for the periods which have elapsed since it was last called
+    uint32_t _virtualTimerLastUs;
+    uint32_t _virtualTimerElapsedNs;
+    static constexpr uint32_t VIRTUAL_TIMER_MAX_TICKS_PER_PROCESS = 1000;
 #endif
     bool _isrTimerStarted;
 
+    // Step timer mode - the timer runs at 10MHz and the alarm is set on each ISR call
+    static constexpr uint32_t STEP_TIMER_DIVIDER = 8;
+    static constexpr uint32_t STEP_TIMER_NS_PER_TICK = 100;
+    static constexpr uint32_t STEP_TIMER_MIN_PERIOD_NS = 4000;
+    static constexpr uint32_t STEP_TIMER_UNDERRUN_PERIOD_NS = MotionBlock::TICK_INTERVAL_NS;
+    static constexpr uint32_t STEP_TIMER_ENDSTOP_PERIOD_NS = MotionBlock::TICK_INTERVAL_NS;
+    static constexpr uint32_t STEP_TIMER_IDLE_PERIOD_NS = 200000;
+
+    // Time between ISR calls - fixed in accumulator and step event modes
+    volatile uint32_t _isrPeriodNs;
+
+    // Feed override and current feed scale (Q16 fractions) - motion runs on a clock which
+    // advances at the feed scale fraction of real time so speeds scale by it and accelerations
+    // by its square without any change to planned blocks
+    // The feed scale ramps towards the override (or zero in a feed hold) at the executing
+    // block's acceleration
+    volatile uint32_t _feedOverrideQ16;
+    volatile uint32_t _feedScaleQ16;
+    uint32_t _feedScaleAccumNs;
+
+    // Axes (bit per axis) with step pins set and waiting to be reset and the mask of
+    // GPIO pins to reset
+    uint32_t _axisStepActiveBits;
+    uint64_t _stepPinActiveMask;
+
+    // ISR execution time in CPU cycles (to measure ISR load)
+    volatile uint64_t _isrCycles;
+    uint64_t _isrLoadLastCycles;
+    uint32_t _isrLoadLastUs;
+
+    // ISR tick counts - total, ticks with a block executing and ticks in which a step started
+    volatile uint32_t _isrTickCount;
+    volatile uint32_t _isrBlockTickCount;
+    volatile uint32_t _isrStepTickCount;
+
+    // Pipeline underrun telemetry
+    // Work is waiting to be planned (commands or split blocks) or further upstream (work items
+    // and evaluators)
+    volatile bool _plannerWorkQueued;
+    volatile bool _upstreamWorkQueued;
+    // Times the ISR found the pipeline empty (after executing a block) while work was waiting
+    bool _pipelineHadBlock;
+    volatile uint32_t _pipelineStarvedCount;
+    // ISR ticks (and time) with nothing to execute while work was waiting
+    volatile uint32_t _underrunPlannerTicks;
+    volatile uint32_t _underrunUpstreamTicks;
+    volatile uint64_t _underrunPlannerNs;
+    volatile uint64_t _underrunUpstreamNs;
+    // Stops between blocks which were planned to flow into the next block - a gap shorter
+    // than FOLLOWED_BLOCK_STOP_MIN_NS doesn't count as the motors barely notice it
+    bool _lastBlockFollowed;
+    uint32_t _followedBlockGapNs;
+    volatile uint32_t _followedBlockStopCount;
+    static constexpr uint32_t FOLLOWED_BLOCK_STOP_MIN_NS = 1000000;
+
+    // Step event recorder
+    MotionStepRecorder _stepRecorder;
+
+    // Trace of executed blocks and the time the current block started (only set when tracing)
+    MotionPlannerTrace _plannerTrace;
+    uint32_t _curBlockStartUs;
+
+    // ISR execution time and step interval deviation - the cycle count at the start of the
+    // current ISR call is the actual time of any step it makes
+    MotionTimingStats _timingStats;
+    uint32_t _cpuFreqMHz;
+    uint32_t _isrStartCycles;
+    uint32_t _lastStepCycles;
+    bool _stepTimingValid;
+
+    // Mode
+    RampGenMode _rampGenMode;
+
+    // Acceleration profile
+    RampGenProfile _rampGenProfile;
+
+    // Step commands compiled from blocks (step event mode)
+    StepCommandQueue _stepCmdQueue;
+    StepCommandCompiler _stepCmdCompiler;
+    uint32_t _stepCompileLeadUs;
+    static constexpr int STEP_CMD_QUEUE_LEN_DEFAULT = 400;
+    static constexpr int STEP_COMPILE_LEAD_MS_DEFAULT = 50;
+    static constexpr uint32_t STEP_COMPILE_MAX_STEPS_PER_SERVICE = 2000;
+    static constexpr uint32_t STEP_CMD_MAX_DISCARD_PER_TICK = 32;
+
+    // Step command being played by the ISR (step event mode)
+    // Times are in ns and wrap - _stepClockNs advances by the tick interval (scaled by the feed
+    // scale) while not paused
+    volatile bool _stepCmdDiscarding;
+    bool _stepCmdLoaded;
+    bool _stepCmdLastInBlock;
+    bool _stepCmdUnderrun;
+    uint32_t _stepCmdCountLeft;
+    uint32_t _stepCmdIntervalNs;
+    int32_t _stepCmdAddNs;
+    uint32_t _stepClockNs;
+    uint32_t _lastStepNs;
+    uint32_t _nextStepNs;
+    static constexpr int32_t STEP_EVENT_MAX_LATENESS_NS = 2 * MotionBlock::TICK_INTERVAL_NS;
+
 private:
     // Execution info for the currently executing block
     bool _isEnabled;
@@ -61,10 +212,10 @@ private:
     bool _rampGenEnabled;
     // End-stop reached
     bool _endStopReached;
-    // Last completed numbered command
+    // Last completed numbered command and the axes whose end-stops it hit
     int _lastDoneNumberedCmdIdx;
+    uint32_t _lastDoneNumberedCmdEndStopHitBits;
     // Steps
-    uint32_t _stepsTotalAbs[RobotConsts::MAX_AXES];
     uint32_t _curStepCount[RobotConsts::MAX_AXES];
     // Current step rate (in steps per K ticks)
     uint32_t _curStepRatePerTTicks;
@@ -72,23 +223,30 @@ private:
     uint32_t _curAccumulatorStep;
     uint32_t _curAccumulatorNS;
     uint32_t _curAccumulatorRelative[RobotConsts::MAX_AXES];
+    // S-curve ramp in progress - rates are per TTicks and times in ms
+    bool _sCurveDecelStarted;
+    uint32_t _sCurveStartRate;
+    uint32_t _sCurveEndRate;
+    uint32_t _sCurveElapsedMs;
+    uint32_t _sCurveDurationMs;
+    static constexpr uint32_t S_CURVE_MAX_DURATION_MS = 65535;
 
+    // Number of end-stops checked in the current block (hits are latched by RampGenIO)
     int _endStopCheckNum;
-    struct EndStopChecks
-    {
-        int pin;
-        bool val;
-    };
-    EndStopChecks _endStopChecks[RobotConsts::MAX_AXES];
+    // Axes (bit per axis) which have stopped in the current block because their end-stop was hit -
+    // the block continues (without steps on these axes) until all its end-stops are hit
+    uint32_t _axisEndStopHitBits;
+    static constexpr uint32_t END_STOP_DEBOUNCE_US_DEFAULT = 0;
 
 public:
     RampGenerator(MotionPipeline* pMotionPipeline);
     // static void setRawMotionHwInfo(RobotConsts::RawMotionHwInfo_t &rawMotionHwInfo);
     void setInstrumentationMode(const char *testModeStr);
     void deinit();
-    void configure(bool rampGenEnabled);
+    void configure(bool rampGenEnabled, const char* robotGeomJSON);
     bool configureAxis(int axisIdx, const char *axisJSON)
     {
+        _inputShaper.configureAxis(axisIdx, axisJSON, MotionBlock::TICK_INTERVAL_NS);
         return _rampGenIO.configureAxis(axisIdx, axisJSON);
     }
     void stop();
@@ -103,17 +261,80 @@ public:
         _rampGenIO.getEndStopStatus(axisEndStopVals);
     }
     bool isEndStopReached();
+    void setFeedOverride(float percent);
+    void setExecHold(bool holdIt)
+    {
+        _execHold = holdIt;
+    }
+    float getFeedOverride();
     int getLastCompletedNumberedCmdIdx();
+    uint32_t getLastCompletedNumberedCmdEndStopHits();
     void process();
     String getDebugStr();
     void showDebug();
 
+    // Step recording and ISR tick counts
+    void stepRecorderStart(int maxEvents);
+    void stepRecorderStop();
+    void getStepRecord(String& csvStr);
+    void getISRTickCounts(uint32_t& ticks, uint32_t& blockTicks, uint32_t& stepTicks);
+
+    // Planner trace
+    void plannerTraceStart(int maxBlocks);
+    void plannerTraceStop();
+    void getPlannerTrace(String& csvStr);
+
+    // Underrun telemetry
+    void setWorkQueued(bool plannerWorkQueued, bool upstreamWorkQueued)
+    {
+        _plannerWorkQueued = plannerWorkQueued;
+        _upstreamWorkQueued = upstreamWorkQueued;
+    }
+    void getUnderrunStats(String& jsonStr);
+    void resetUnderrunStats();
+
+    // ISR timing statistics
+    void getTimingStats(String& jsonStr)
+    {
+        _timingStats.getJSON(jsonStr);
+    }
+    void resetTimingStats()
+    {
+        _timingStats.reset();
+    }
+
 private:
     static void _staticISRStepperMotion();
     void isrStepperMotion();
     bool handleStepEnd();
     void setupNewBlock(MotionBlock *pBlock);
+    void prepareBlockExec(MotionBlock *pBlock);
+    void prepareBlocksForExec();
     void updateMSAccumulator(MotionBlock *pBlock);
+    void startSCurve(uint32_t endRate, uint32_t accPerMs);
     bool handleStepMotion(MotionBlock *pBlock);
+    void startAxisStep(int axisIdx, uint64_t& stepPinMask);
     void endMotion(MotionBlock *pBlock);
+    bool checkEndStops();
+    bool handleEndStopHits();
+    void shapedStepOutput();
+    void flushShapedSteps(uint32_t axisBits);
+    void isrStepEvents(MotionBlock *pBlock);
+    void endStepEventBlock(MotionBlock *pBlock);
+    bool discardStepCmds();
+    void resetStepEvents();
+    void serviceStepCompiler();
+    uint32_t stepTimerPeriodNs();
+    void updateFeedScale();
+    void countUnderrun();
+    void recordStepTiming(uint32_t plannedStepNs);
+    uint32_t feedScale(uint32_t valToScale)
+    {
+        return uint32_t((uint64_t(valToScale) * _feedScaleQ16) >> 16);
+    }
+    void setStepTimerPeriod();
+    bool usesStepCommands()
+    {
+        return _rampGenMode != RAMP_GEN_MODE_ACCUMULATOR;
+    }
 };
@@ -0,0 +1,263 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#include "StepCommandCompiler.h"
+#include "../MotionBlock.h"
+
+StepCommandCompiler::StepCommandCompiler()
+{
+    reset();
+}
+
+void StepCommandCompiler::reset()
+{
+    _pBlock = NULL;
+    _stepsTotal = 0;
+    _stepIdx = 0;
+    _stepsBeforeDecel = 0;
+    _curRate = 0;
+    _maxRate = 0;
+    _finalRate = 0;
+    _minRate = 0;
+    _accel = 0;
+    _stepTimeNs = 0;
+    _sCurve = false;
+    _sCurveDecelStarted = false;
+    _sCurveStartRate = 0;
+    _sCurveEndRate = 0;
+    _sCurveDurationSecs = 0;
+    _sCurveStartNs = 0;
+    _sCurveStartStepIdx = 0;
+    _segStartNs = 0;
+    _segIntervalNs = 0;
+    _segAddNs = 0;
+    _segCount = 0;
+    _cmdWaiting = false;
+}
+
+void StepCommandCompiler::startBlock(MotionBlock* pBlock, float minStepRatePerSec, bool sCurve)
+{
+    reset();
+    _pBlock = pBlock;
+
+    // Convert the block's rates (which are in steps per TTICKS) into steps per second
+    const float ttickToStepsPerSec = MotionBlock::TICKS_PER_SEC / MotionBlock::TTICKS_VALUE;
+    _stepsTotal = pBlock->getAbsStepsToTarget(pBlock->_axisIdxWithMaxSteps);
+    _stepsBeforeDecel = pBlock->_stepsBeforeDecel;
+    _curRate = pBlock->_initialStepRatePerTTicks * ttickToStepsPerSec;
+    _maxRate = pBlock->_maxStepRatePerTTicks * ttickToStepsPerSec;
+    _finalRate = pBlock->_finalStepRatePerTTicks * ttickToStepsPerSec;
+    _accel = pBlock->_accStepsPerTTicksPerMS * 1000 * ttickToStepsPerSec;
+    _minRate = minStepRatePerSec;
+
+    // S-curve starts with the acceleration phase
+    _sCurve = sCurve;
+    if (_sCurve)
+        startSCurve(std::max(_maxRate, _minRate));
+
+    // Mark the block so that the planner leaves it alone from now on
+    pBlock->_stepCompileDurationUs = 0;
+    pBlock->_stepCompileState = MotionBlock::STEP_COMPILE_STARTED;
+}
+
+bool StepCommandCompiler::compile(StepCommandQueue& queue, uint32_t maxSteps)
+{
+    if (!_pBlock)
+        return true;
+
+    uint32_t stepsDone = 0;
+    while (true)
+    {
+        // Put any complete command into the queue - the block is updated first as it can be
+        // removed by the ISR as soon as its last command is in the queue
+        if (_cmdWaiting)
+        {
+            if (!queue.canPut())
+                return false;
+            bool lastInBlock = (_cmdToPut._flags & StepCommand::STEP_CMD_FLAG_LAST_IN_BLOCK) != 0;
+            _pBlock->_stepCompileDurationUs = uint32_t(_segStartNs / 1000);
+            if (lastInBlock)
+            {
+                _pBlock->_stepCompileState = MotionBlock::STEP_COMPILE_DONE;
+                _pBlock = NULL;
+            }
+            queue.put(_cmdToPut);
+            _cmdWaiting = false;
+            if (lastInBlock)
+                return true;
+        }
+
+        // When all steps have been generated the command being built is the last one
+        if (_stepIdx >= _stepsTotal)
+        {
+            closeSegment(true);
+            continue;
+        }
+
+        // Limit the work done in one call
+        if (stepsDone >= maxSteps)
+            return false;
+        stepsDone++;
+
+        // Time of the next step and the time it would have as part of the current command
+        uint64_t stepNs = nextStepTimeNs();
+        if (_segCount == 1)
+        {
+            // Second step of a command defines the add value
+            _segAddNs = int32_t(int64_t(stepNs - _segStartNs) - 2 * int64_t(_segIntervalNs));
+            _segCount = 2;
+            continue;
+        }
+        else if ((_segCount > 1) && (_segCount < 0xffff))
+        {
+            int64_t k = _segCount + 1;
+            int64_t lastInterval = int64_t(_segIntervalNs) + int64_t(_segAddNs) * (k - 1);
+            int64_t predNs = int64_t(_segStartNs) + k * int64_t(_segIntervalNs) + int64_t(_segAddNs) * k * (k - 1) / 2;
+            int64_t errNs = predNs - int64_t(stepNs);
+            if ((lastInterval > 0) && (errNs <= int64_t(MAX_STEP_TIME_ERROR_NS)) && (errNs >= -int64_t(MAX_STEP_TIME_ERROR_NS)))
+            {
+                _segCount++;
+                continue;
+            }
+        }
+
+        // Step doesn't fit the current command so start a new one
+        if (_segCount != 0)
+            closeSegment(false);
+        int64_t intervalNs = int64_t(stepNs) - int64_t(_segStartNs);
+        _segIntervalNs = uint32_t(intervalNs < 1 ? 1 : (intervalNs > INT32_MAX ? INT32_MAX : intervalNs));
+        _segAddNs = 0;
+        _segCount = 1;
+    }
+}
+
+bool StepCommandCompiler::abortBlock(StepCommandQueue& queue)
+{
+    if (!_pBlock)
+        return true;
+    // Drop anything not yet queued and queue an empty command to mark the end of the block (if
+    // this hasn't already been done and is waiting for space in the queue)
+    if (!_cmdWaiting || !(_cmdToPut._flags & StepCommand::STEP_CMD_FLAG_LAST_IN_BLOCK))
+    {
+        _cmdWaiting = false;
+        _segCount = 0;
+        closeSegment(true);
+    }
+    return compile(queue, 0);
+}
+
+// Generate the time of the next step on the axis with most steps - this follows the same
+// profile as the accumulator based ramp generator (accelerate to max rate, decelerate
+// after _stepsBeforeDecel steps) but with acceleration applied per step rather than per ms
+uint64_t StepCommandCompiler::nextStepTimeNs()
+{
+    if (_sCurve)
+        return nextSCurveStepNs();
+
+    float newRate = _curRate;
+    if (_stepIdx > _stepsBeforeDecel)
+    {
+        float floorRate = std::max(_finalRate, _minRate);
+        if ((_curRate > floorRate) && (_accel > 0))
+        {
+            float rateSq = _curRate * _curRate - 2 * _accel;
+            newRate = (rateSq > floorRate * floorRate) ? sqrtf(rateSq) : floorRate;
+        }
+    }
+    else if ((_curRate < _maxRate) && (_accel > 0))
+    {
+        newRate = sqrtf(_curRate * _curRate + 2 * _accel);
+        if (newRate > _maxRate)
+            newRate = _maxRate;
+    }
+
+    // Time for one step at the mean rate
+    float meanRate = (_curRate + newRate) / 2;
+    if (meanRate < _minRate)
+        meanRate = _minRate;
+    _curRate = newRate;
+    _stepIdx++;
+    _stepTimeNs += uint64_t(1e9f / meanRate);
+    return _stepTimeNs;
+}
+
+// S-curve step time - the time at which the distance covered by the ramp reaches the next
+// step is found using Newton's method (limited to the minimum step rate)
+// The deceleration ramp starts from the rate reached when _stepsBeforeDecel is passed
+uint64_t StepCommandCompiler::nextSCurveStepNs()
+{
+    if (!_sCurveDecelStarted && (_stepIdx > _stepsBeforeDecel))
+    {
+        _sCurveDecelStarted = true;
+        startSCurve(std::max(_finalRate, _minRate));
+    }
+    _stepIdx++;
+
+    // Steps since start of ramp and time of previous step
+    float stepsInRamp = _stepIdx - _sCurveStartStepIdx;
+    float prevSecs = (_stepTimeNs - _sCurveStartNs) / 1e9f;
+    float stepSecs = 0;
+    float rampSteps = sCurveSteps(_sCurveDurationSecs);
+    if (stepsInRamp >= rampSteps)
+    {
+        // Past the end of the ramp
+        stepSecs = _sCurveDurationSecs + (stepsInRamp - rampSteps) / std::max(_sCurveEndRate, _minRate);
+        _curRate = _sCurveEndRate;
+    }
+    else
+    {
+        stepSecs = prevSecs + 1 / std::max(_curRate, _minRate);
+        for (int i = 0; i < S_CURVE_MAX_SOLVE_ITERATIONS; i++)
+        {
+            float fraction = std::min(std::max(stepSecs / _sCurveDurationSecs, 0.0f), 1.0f);
+            _curRate = _sCurveStartRate + (_sCurveEndRate - _sCurveStartRate) * 
+                            MotionBlock::sCurveFractionQ16(uint32_t(fraction * 65536)) / 65536.0f;
+            float stepErr = sCurveSteps(stepSecs) - stepsInRamp;
+            if (fabsf(stepErr) < 0.001f)
+                break;
+            stepSecs -= stepErr / std::max(_curRate, _minRate);
+            stepSecs = std::min(std::max(stepSecs, prevSecs), _sCurveDurationSecs);
+        }
+    }
+
+    // Don't go slower than the minimum rate
+    if (stepSecs - prevSecs > 1 / _minRate)
+        stepSecs = prevSecs + 1 / _minRate;
+    _stepTimeNs = _sCurveStartNs + uint64_t(stepSecs * 1e9f);
+    return _stepTimeNs;
+}
+
+// Steps covered by the S-curve ramp after secs (the integral of the ramp's rate)
+float StepCommandCompiler::sCurveSteps(float secs)
+{
+    if (_sCurveDurationSecs <= 0)
+        return _sCurveEndRate * secs;
+    float u = std::min(secs / _sCurveDurationSecs, 1.0f);
+    float u4 = u * u * u * u;
+    float rampFraction = u4 * (2.5f - 3 * u + u * u);
+    return _sCurveStartRate * std::min(secs, _sCurveDurationSecs) + 
+                (_sCurveEndRate - _sCurveStartRate) * _sCurveDurationSecs * rampFraction;
+}
+
+void StepCommandCompiler::startSCurve(float endRate)
+{
+    _sCurveStartRate = _curRate;
+    _sCurveEndRate = endRate;
+    _sCurveStartNs = _stepTimeNs;
+    _sCurveStartStepIdx = _stepIdx;
+    _sCurveDurationSecs = (_accel > 0) ? fabsf(endRate - _curRate) / _accel : 0;
+}
+
+void StepCommandCompiler::closeSegment(bool lastInBlock)
+{
+    _cmdToPut._intervalNs = _segIntervalNs;
+    _cmdToPut._addNs = _segAddNs;
+    _cmdToPut._count = _segCount;
+    _cmdToPut._flags = lastInBlock ? StepCommand::STEP_CMD_FLAG_LAST_IN_BLOCK : 0;
+    _cmdWaiting = true;
+
+    // Start of the next command is the (compiled) time of the last step in this one
+    if (_segCount > 0)
+        _segStartNs += uint64_t(_segCount) * _segIntervalNs + int64_t(_segAddNs) * (int64_t(_segCount) * (_segCount - 1) / 2);
+    _segCount = 0;
+}
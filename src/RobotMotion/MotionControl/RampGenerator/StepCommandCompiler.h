@@ -0,0 +1,93 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#pragma once
+
+#include <Arduino.h>
+#include "StepCommandQueue.h"
+
+class MotionBlock;
+
+// Converts a MotionBlock's stepping profile (as prepared by MotionBlock::prepareForStepping)
+// into a stream of step commands which the ramp generator ISR can play without doing
+// any acceleration maths
+// Step times are generated for each step on the axis with most steps and then runs of
+// steps whose timing fits interval + add within a small error are merged into one command
+// A block can be compiled in several calls so that long blocks don't need a large queue
+class StepCommandCompiler
+{
+public:
+    // Maximum deviation of a compiled step time from the ideal step time
+    static constexpr uint32_t MAX_STEP_TIME_ERROR_NS = 2000;
+
+private:
+    // Block being compiled
+    MotionBlock* _pBlock;
+
+    // Step time generation - rates are in steps per second
+    uint32_t _stepsTotal;
+    uint32_t _stepIdx;
+    uint32_t _stepsBeforeDecel;
+    float _curRate;
+    float _maxRate;
+    float _finalRate;
+    float _minRate;
+    float _accel;
+    uint64_t _stepTimeNs;
+
+    // S-curve ramp (see MotionBlock::sCurveFractionQ16) - the ramp takes the time a constant
+    // acceleration would so the block covers the same distance
+    bool _sCurve;
+    bool _sCurveDecelStarted;
+    float _sCurveStartRate;
+    float _sCurveEndRate;
+    float _sCurveDurationSecs;
+    uint64_t _sCurveStartNs;
+    uint32_t _sCurveStartStepIdx;
+    static constexpr int S_CURVE_MAX_SOLVE_ITERATIONS = 8;
+
+    // Command currently being built
+    uint64_t _segStartNs;
+    uint32_t _segIntervalNs;
+    int32_t _segAddNs;
+    uint32_t _segCount;
+
+    // Command which is complete but hasn't yet been put into the queue (queue full)
+    bool _cmdWaiting;
+    StepCommand _cmdToPut;
+
+public:
+    StepCommandCompiler();
+
+    // Abandon any block being compiled
+    void reset();
+
+    // Check if a block is being compiled
+    bool isBusy()
+    {
+        return _pBlock != NULL;
+    }
+    // Block being compiled - it stays in the pipeline until its last command has been queued
+    // (the ramp generator doesn't remove a block which ends early until then)
+    MotionBlock* getBlock()
+    {
+        return _pBlock;
+    }
+
+    // Start compiling a block
+    void startBlock(MotionBlock* pBlock, float minStepRatePerSec, bool sCurve);
+
+    // Compile up to maxSteps steps of the current block into the queue
+    // Returns true when the block has been completely compiled
+    bool compile(StepCommandQueue& queue, uint32_t maxSteps);
+
+    // Finish the current block early (e.g. after an end-stop hit) by queueing an empty last command
+    bool abortBlock(StepCommandQueue& queue);
+
+private:
+    uint64_t nextStepTimeNs();
+    uint64_t nextSCurveStepNs();
+    void startSCurve(float endRate);
+    float sCurveSteps(float secs);
+    void closeSegment(bool lastInBlock);
+};
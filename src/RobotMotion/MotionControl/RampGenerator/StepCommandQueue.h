@@ -0,0 +1,80 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#pragma once
+
+#include <Arduino.h>
+#include "../MotionRingBuffer.h"
+#include <vector>
+
+// A step command describes a run of steps on the axis with most steps in a block
+// The first step is _intervalNs after the previous step, each following step is
+// the previous interval plus _addNs after the one before it
+// Other axes in the block are stepped in proportion to the main axis (Bresenham)
+struct StepCommand
+{
+    static constexpr uint8_t STEP_CMD_FLAG_LAST_IN_BLOCK = 0x01;
+
+    uint32_t _intervalNs;
+    int32_t _addNs;
+    uint16_t _count;
+    uint8_t _flags;
+};
+
+// Queue of step commands - filled by the step command compiler on the main thread
+// and emptied by the ramp generator ISR
+class StepCommandQueue
+{
+private:
+    MotionRingBufferPosn _queuePosn;
+    std::vector<StepCommand> _queue;
+
+public:
+    StepCommandQueue() : _queuePosn(0)
+    {
+    }
+
+    void init(int queueSize)
+    {
+        _queue.resize(queueSize);
+        _queuePosn.init(queueSize);
+    }
+
+    void clear()
+    {
+        _queuePosn.clear();
+    }
+
+    unsigned int count()
+    {
+        return _queuePosn.count();
+    }
+
+    bool canPut()
+    {
+        return _queuePosn.canPut();
+    }
+
+    bool put(const StepCommand& cmd)
+    {
+        if (!_queuePosn.canPut())
+            return false;
+        _queue[_queuePosn._putPos] = cmd;
+        _queuePosn.hasPut();
+        return true;
+    }
+
+    // Peek the command which would be got next (NULL if empty)
+    StepCommand* IRAM_ATTR peekGet()
+    {
+        if (!_queuePosn.canGet())
+            return NULL;
+        return &(_queue[_queuePosn._getPos]);
+    }
+
+    void IRAM_ATTR remove()
+    {
+        if (_queuePosn.canGet())
+            _queuePosn.hasGot();
+    }
+};
@@ -162,4 +162,25 @@ class StepperMotor
     {
         return _motorType;
     }
+
+    // Step pin - the ramp generator can drive this directly if the direction
+    // doesn't need to be set (via the multiplexer) with each step
+    int getStepPin()
+    {
+        return _pinStep;
+    }
+    bool isDirectionMultiplexed()
+    {
+        return _pinDirectionSingle < 0;
+    }
+
+    // Direction pin and the level it is set to for a direction
+    int getDirectionPin()
+    {
+        return _pinDirectionSingle;
+    }
+    bool getDirectionPinLevel(bool dirn)
+    {
+        return _motorDirectionReversed ? dirn : !dirn;
+    }
 };
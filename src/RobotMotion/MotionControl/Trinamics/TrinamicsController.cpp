@@ -22,6 +22,7 @@ TrinamicsController::TrinamicsController(AxesParams& axesParams, MotionPipeline&
     _pThisObj = this;
     _isEnabled = false;
     _isRampGenerator = false;
+    _lastDoneNumberedCmdIdx = RobotConsts::NUMBERED_COMMAND_NONE;
     _tx1 = _tx2 = -1;
 }
 
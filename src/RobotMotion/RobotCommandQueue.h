@@ -0,0 +1,89 @@
+// RBotFirmware
+// Rob Dobson 2016-2019
+
+#pragma once
+
+#include <Arduino.h>
+#include "RobotCommandArgs.h"
+#include "MotionControl/MotionRingBuffer.h"
+#include <vector>
+
+// A command for the robot - moves and the commands which must stay in order with them
+struct RobotCommand
+{
+    enum RobotCommandType
+    {
+        ROBOT_CMD_MOVE_TO,
+        ROBOT_CMD_SET_MOTION_PARAMS,
+        ROBOT_CMD_GO_HOME,
+        ROBOT_CMD_SET_HOME
+    };
+
+    RobotCommandType _cmdType;
+    RobotCommandArgs _args;
+};
+
+// Queue of robot commands - filled by the work manager (main loop) after parsing and
+// evaluation and emptied by the motion task which does kinematics and planning
+// Single producer and single consumer so no locking is needed
+class RobotCommandQueue
+{
+private:
+    MotionRingBufferPosn _queuePosn;
+    std::vector<RobotCommand> _queue;
+
+public:
+    RobotCommandQueue() : _queuePosn(0)
+    {
+    }
+
+    void init(int queueSize)
+    {
+        _queue.resize(queueSize);
+        _queuePosn.init(queueSize);
+    }
+
+    // Discard everything queued - only the get position moves so this must be called by the
+    // consumer but the producer can carry on putting
+    void discardAll()
+    {
+        unsigned int numToDiscard = _queuePosn.count();
+        for (unsigned int i = 0; i < numToDiscard; i++)
+            _queuePosn.hasGot();
+    }
+
+    unsigned int count()
+    {
+        return _queuePosn.count();
+    }
+
+    bool canPut()
+    {
+        return _queuePosn.canPut();
+    }
+
+    bool canGet()
+    {
+        return _queuePosn.canGet();
+    }
+
+    bool put(RobotCommand::RobotCommandType cmdType, RobotCommandArgs& args)
+    {
+        if (!_queuePosn.canPut())
+            return false;
+        RobotCommand& cmd = _queue[_queuePosn._putPos];
+        cmd._cmdType = cmdType;
+        cmd._args = args;
+        _queuePosn.hasPut();
+        return true;
+    }
+
+    bool get(RobotCommand& cmd)
+    {
+        if (!_queuePosn.canGet())
+            return false;
+        cmd = _queue[_queuePosn._getPos];
+        _queuePosn.hasGot();
+        return true;
+    }
+};
@@ -16,6 +16,12 @@ RobotController::RobotController()
 {
     // Init
     _pRobot = NULL;
+    _workItemsQueued = false;
+    _cmdQueue.init(CMD_QUEUE_LEN);
+#ifdef USE_MOTION_TASK
+    _motionTask = NULL;
+    _motionMutex = xSemaphoreCreateMutex();
+#endif
 }
 
 RobotController::~RobotController()
@@ -25,7 +31,9 @@ RobotController::~RobotController()
 
 bool RobotController::init(const char* configStr)
 {
-    // Init
+    // Init - the motion lock makes this the queue's consumer so it can discard commands
+    motionLock();
+    _cmdQueue.discardAll();
     delete _pRobot;
     _pRobot = NULL;
 
@@ -39,7 +47,10 @@ bool RobotController::init(const char* configStr)
         Log.notice("Constructing %s\n", robotModel.c_str());
         _pRobot = new RobotSandTableRotary(robotModel.c_str(), _motionHelper);
         if (!_pRobot)
+        {
+            motionUnlock();
             return false;
+        }
         _pRobot->init(configStr);
     }
     else
@@ -53,6 +64,7 @@ bool RobotController::init(const char* configStr)
         _pRobot->pause(false);
     }
 
+    motionUnlock();
     return true;
 }
 
@@ -65,7 +77,9 @@ void RobotController::pause(bool pauseIt)
         Log.notice("RobotController: resuming\n");
     if (!_pRobot)
         return;
+    motionLock();
     _pRobot->pause(pauseIt);
+    motionUnlock();
 }
 
 // Stop
@@ -74,7 +88,12 @@ void RobotController::stop()
     Log.notice("RobotController: stop\n");
     if (!_pRobot)
         return;
+    // Commands not yet planned are discarded along with the pipeline (the motion lock makes
+    // this the queue's consumer)
+    motionLock();
+    _cmdQueue.discardAll();
     _pRobot->stop();
+    motionUnlock();
 }
 
 // Check if paused
@@ -85,12 +104,117 @@ bool RobotController::isPaused()
     return _pRobot->isPaused();
 }
 
+// Feed override
+void RobotController::setFeedOverride(float percent)
+{
+    if (!_pRobot)
+        return;
+    _pRobot->setFeedOverride(percent);
+}
+
+// Start the motion task
+void RobotController::startMotionTask()
+{
+#ifdef USE_MOTION_TASK
+    if (_motionTask)
+        return;
+    xTaskCreatePinnedToCore(motionTaskFn, "Motion", MOTION_TASK_STACK_SIZE, this,
+                            MOTION_TASK_PRIORITY, &_motionTask, MOTION_TASK_CORE);
+#endif
+}
+
+void RobotController::motionTaskFn(void* pParam)
+{
+#ifdef USE_MOTION_TASK
+    RobotController* pThis = (RobotController*)pParam;
+    for (;;)
+    {
+        pThis->serviceMotion();
+        // Wait for a command to be queued or the next tick
+        ulTaskNotifyTake(pdTRUE, 1);
+    }
+#endif
+}
+
 // Service (called frequently)
 void RobotController::service()
 {
-    if (!_pRobot)
+#ifdef USE_MOTION_TASK
+    if (_motionTask)
         return;
-    _pRobot->service();
+#endif
+    serviceMotion();
+}
+
+// Execute queued commands (kinematics and planning) and service motion
+void RobotController::serviceMotion()
+{
+    motionLock();
+    if (_pRobot)
+    {
+        // Commands are only taken from the queue when the robot can accept them so that
+        // ordering with moves which are split into blocks (and with homing) is preserved - the
+        // work queued state is updated first so the last block of a move is only marked as
+        // followed if another command is waiting
+        RobotCommand cmd;
+        while (_pRobot->canAcceptCommand() && _cmdQueue.get(cmd))
+        {
+            _motionHelper.setWorkQueued(_cmdQueue.canGet(), _workItemsQueued);
+            execCommand(cmd);
+        }
+        _motionHelper.setWorkQueued(_cmdQueue.canGet(), _workItemsQueued);
+        _pRobot->service();
+    }
+    motionUnlock();
+}
+
+void RobotController::execCommand(RobotCommand& cmd)
+{
+    switch (cmd._cmdType)
+    {
+        case RobotCommand::ROBOT_CMD_MOVE_TO:
+            _pRobot->moveTo(cmd._args);
+            break;
+        case RobotCommand::ROBOT_CMD_SET_MOTION_PARAMS:
+            _pRobot->setMotionParams(cmd._args);
+            break;
+        case RobotCommand::ROBOT_CMD_GO_HOME:
+            _pRobot->goHome(cmd._args);
+            break;
+        case RobotCommand::ROBOT_CMD_SET_HOME:
+            _pRobot->setHome(cmd._args);
+            break;
+    }
+}
+
+bool RobotController::queueCommand(RobotCommand::RobotCommandType cmdType, RobotCommandArgs& args)
+{
+    if (!_pRobot)
+        return false;
+    if (!_cmdQueue.put(cmdType, args))
+    {
+        Log.notice("RobotController: command queue full\n");
+        return false;
+    }
+#ifdef USE_MOTION_TASK
+    if (_motionTask)
+        xTaskNotifyGive(_motionTask);
+#endif
+    return true;
+}
+
+void RobotController::motionLock()
+{
+#ifdef USE_MOTION_TASK
+    xSemaphoreTake(_motionMutex, portMAX_DELAY);
+#endif
+}
+
+void RobotController::motionUnlock()
+{
+#ifdef USE_MOTION_TASK
+    xSemaphoreGive(_motionMutex);
+#endif
 }
 
 // Movement commands
@@ -106,22 +230,18 @@ bool RobotController::canAcceptCommand()
 {
     if (!_pRobot)
         return false;
-    return _pRobot->canAcceptCommand();
+    return _cmdQueue.canPut();
 }
 
-void RobotController::moveTo(RobotCommandArgs& args)
+bool RobotController::moveTo(RobotCommandArgs& args)
 {
-    if (!_pRobot)
-        return;
-    _pRobot->moveTo(args);
+    return queueCommand(RobotCommand::ROBOT_CMD_MOVE_TO, args);
 }
 
 // Set motion parameters
-void RobotController::setMotionParams(RobotCommandArgs& args)
+bool RobotController::setMotionParams(RobotCommandArgs& args)
 {
-    if (!_pRobot)
-        return;
-    _pRobot->setMotionParams(args);
+    return queueCommand(RobotCommand::ROBOT_CMD_SET_MOTION_PARAMS, args);
 }
 
 // Get status
@@ -129,7 +249,11 @@ void RobotController::getCurStatus(RobotCommandArgs& args)
 {
     if (!_pRobot)
         return;
+    motionLock();
     _pRobot->getCurStatus(args);
+    motionUnlock();
+    // Include commands not yet planned
+    args.setNumQueued(args.getNumQueued() + _cmdQueue.count());
 }
 
 // Get robot attributes
@@ -138,23 +262,21 @@ void RobotController::getRobotAttributes(String& robotAttrs)
     robotAttrs = "{}";
     if (!_pRobot)
         return;
+    motionLock();
     _pRobot->getRobotAttributes(robotAttrs);
+    motionUnlock();
 }
 
 // Go Home
-void RobotController::goHome(RobotCommandArgs& args)
+bool RobotController::goHome(RobotCommandArgs& args)
 {
-    if (!_pRobot)
-        return;
-    _pRobot->goHome(args);
+    return queueCommand(RobotCommand::ROBOT_CMD_GO_HOME, args);
 }
 
 // Set Home
-void RobotController::setHome(RobotCommandArgs& args)
+bool RobotController::setHome(RobotCommandArgs& args)
 {
-    if (!_pRobot)
-        return;
-    _pRobot->setHome(args);
+    return queueCommand(RobotCommand::ROBOT_CMD_SET_HOME, args);
 }
 
 bool RobotController::wasActiveInLastNSeconds(int nSeconds)
@@ -166,5 +288,43 @@ bool RobotController::wasActiveInLastNSeconds(int nSeconds)
 
 String RobotController::getDebugStr()
 {
-    return _motionHelper.getDebugStr();
+    motionLock();
+    String debugStr = _motionHelper.getDebugStr();
+    motionUnlock();
+    return debugStr;
+}
+
+void RobotController::stepRecorder(const char* cmdStr, int maxEvents, String& respStr)
+{
+    motionLock();
+    _motionHelper.stepRecorder(cmdStr, maxEvents, respStr);
+    motionUnlock();
+}
+
+void RobotController::motionStats(const char* cmdStr, String& respStr)
+{
+    motionLock();
+    _motionHelper.motionStats(cmdStr, respStr);
+    motionUnlock();
+}
+
+void RobotController::homingStatus(String& respStr)
+{
+    motionLock();
+    _motionHelper.homingStatus(respStr);
+    motionUnlock();
+}
+
+void RobotController::isrStats(const char* cmdStr, String& respStr)
+{
+    motionLock();
+    _motionHelper.isrStats(cmdStr, respStr);
+    motionUnlock();
+}
+
+void RobotController::plannerTrace(const char* cmdStr, int maxBlocks, String& respStr)
+{
+    motionLock();
+    _motionHelper.plannerTrace(cmdStr, maxBlocks, respStr);
+    motionUnlock();
 }
@@ -4,6 +4,11 @@
 #pragma once
 
 #include "MotionControl/MotionHelper.h"
+#include "RobotCommandQueue.h"
+
+#ifdef ESP32
+#define USE_MOTION_TASK 1
+#endif
 
 class RobotBase;
 class RobotCommandArgs;
@@ -14,6 +19,25 @@ private:
     RobotBase* _pRobot;
     MotionHelper _motionHelper;
 
+    // Commands waiting for kinematics and planning
+    RobotCommandQueue _cmdQueue;
+    static constexpr int CMD_QUEUE_LEN = 20;
+
+    // Work items queued in the work manager (used for underrun telemetry)
+    volatile bool _workItemsQueued;
+
+#ifdef USE_MOTION_TASK
+    // Kinematics, planning and step compilation run in their own task so that they are not
+    // held up by the web server, file system, etc in the main loop
+    // The mutex is held by the motion task while it runs and by the main loop for anything
+    // other than queueing a command
+    TaskHandle_t _motionTask;
+    SemaphoreHandle_t _motionMutex;
+    static constexpr int MOTION_TASK_CORE = 1;
+    static constexpr int MOTION_TASK_PRIORITY = 5;
+    static constexpr int MOTION_TASK_STACK_SIZE = 8192;
+#endif
+
 public:
     RobotController();
     ~RobotController();
@@ -28,6 +52,12 @@ public:
     // Check if paused
     bool isPaused();
 
+    // Feed override - scales the speed of all motion (including moves already planned)
+    void setFeedOverride(float percent);
+
+    // Start the motion task - if it isn't started service() does the motion work
+    void startMotionTask();
+
     // Service (called frequently)
     void service();
 
@@ -37,10 +67,11 @@ public:
     // Check if the robot can accept a (motion) command
     bool canAcceptCommand();
 
-    void moveTo(RobotCommandArgs& args);
+    // Commands which are queued to stay in order with moves return false if the queue is full
+    bool moveTo(RobotCommandArgs& args);
 
     // Set motion parameters
-    void setMotionParams(RobotCommandArgs& args);
+    bool setMotionParams(RobotCommandArgs& args);
 
     // Get status
     void getCurStatus(RobotCommandArgs& args);
@@ -49,12 +80,41 @@ public:
     void getRobotAttributes(String& robotAttrs);
 
     // Go Home
-    void goHome(RobotCommandArgs& args);
+    bool goHome(RobotCommandArgs& args);
 
     // Set Home
-    void setHome(RobotCommandArgs& args);
+    bool setHome(RobotCommandArgs& args);
 
     bool wasActiveInLastNSeconds(int nSeconds);
 
     String getDebugStr();
+
+    // Step recorder
+    void stepRecorder(const char* cmdStr, int maxEvents, String& respStr);
+
+    // Motion statistics (underruns and planning time)
+    void motionStats(const char* cmdStr, String& respStr);
+
+    // Homing status (including errors in the homing sequence)
+    void homingStatus(String& respStr);
+
+    // ISR timing statistics
+    void isrStats(const char* cmdStr, String& respStr);
+
+    // Planner trace
+    void plannerTrace(const char* cmdStr, int maxBlocks, String& respStr);
+    void setWorkItemsQueued(bool workItemsQueued)
+    {
+        _workItemsQueued = workItemsQueued;
+    }
+
+private:
+    // Queue a command to be executed in order with moves - false if the queue is full
+    bool queueCommand(RobotCommand::RobotCommandType cmdType, RobotCommandArgs& args);
+    // Execute queued commands and service motion
+    void serviceMotion();
+    void execCommand(RobotCommand& cmd);
+    void motionLock();
+    void motionUnlock();
+    static void motionTaskFn(void* pParam);
 };
@@ -35,6 +35,12 @@ void RobotBase::stop()
     _motionHelper.stop();
 }
 
+// Feed override
+void RobotBase::setFeedOverride(float percent)
+{
+    _motionHelper.setFeedOverride(percent);
+}
+
 bool RobotBase::init(const char *robotConfigStr)
 {
     // Init motion controller from config
@@ -23,6 +23,8 @@ class RobotBase
     virtual bool isPaused();
     // Stop
     virtual void stop();
+    // Feed override (percent of planned speed)
+    virtual void setFeedOverride(float percent);
     virtual bool init(const char *robotConfigStr);
     virtual bool canAcceptCommand();
     virtual void service();
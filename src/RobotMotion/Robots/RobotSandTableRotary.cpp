@@ -9,6 +9,8 @@
 
 static const char* MODULE_PREFIX = "SandTableRotary: ";
 
+static_assert(RobotConsts::MAX_AXES >= RobotSandTableRotary::NUM_ROBOT_AXES, "ROBOT_MAX_AXES too small for SandTableRotary");
+
 // Notes for SandTableRotary
 // Positive stepping direction for axis 0 is clockwise movement of the rotary plate
 // Positive stepping direction for axis 1 need to move OUT
@@ -20,7 +22,8 @@ RobotSandTableRotary::RobotSandTableRotary(const char* pRobotTypeName, MotionHel
     RobotBase(pRobotTypeName, motionHelper)
 {
     // Set transforms
-    _motionHelper.setTransforms(ptToActuator, actuatorToPt, correctStepOverflow, convertCoords, setRobotAttributes);
+    _motionHelper.setTransforms(ptToActuator, actuatorToPt, correctStepOverflow, convertCoords, setRobotAttributes,
+                ptToActuatorPolar, actuatorFloatsToPt);
 }
 
 RobotSandTableRotary::~RobotSandTableRotary()
@@ -36,7 +39,8 @@ bool RobotSandTableRotary::ptToActuator(AxisFloats& targetPt, AxisFloats& outAct
     // Val0 is theta
     // Val0 is rho
     AxisFloats curPolar;
-    actuatorToPolar(curAxisPositions._stepsFromHome, curPolar, axesParams);
+    AxisFloats curActuator(float(curAxisPositions._stepsFromHome.getVal(0)), float(curAxisPositions._stepsFromHome.getVal(1)));
+    actuatorFloatsToPolar(curActuator, curPolar, axesParams);
     // Best relative polar solution
     AxisFloats relativePolarSolution;
 
@@ -71,6 +75,26 @@ bool RobotSandTableRotary::ptToActuator(AxisFloats& targetPt, AxisFloats& outAct
     return true;
 }
 
+// Convert a cartesian point reached by sweeping an angle around the origin to actuator coordinates
+// Steps for both axes are linear in the angle so whole rotations are simply added to the
+// closest solution (which never turns more than 180 degrees)
+bool RobotSandTableRotary::ptToActuatorPolar(AxisFloats& targetPt, float sweepDegs, AxisFloats& outActuator, 
+            AxisPosition& curAxisPositions, AxesParams& axesParams, bool allowOutOfBounds)
+{
+    if (!ptToActuator(targetPt, outActuator, curAxisPositions, axesParams, allowOutOfBounds))
+        return false;
+
+    // Angle turned by the closest solution
+    float thetaRelDegs = (outActuator.getVal(0) - curAxisPositions._stepsFromHome.getVal(0)) * 360 / axesParams.getStepsPerRot(0);
+    float wholeRotations = roundf((sweepDegs - thetaRelDegs) / 360);
+    if (wholeRotations != 0)
+    {
+        outActuator.setVal(0, outActuator.getVal(0) + wholeRotations * axesParams.getStepsPerRot(0));
+        outActuator.setVal(1, outActuator.getVal(1) + wholeRotations * axesParams.getStepsPerRot(1));
+    }
+    return true;
+}
+
 void RobotSandTableRotary::actuatorToPt(AxisInt32s& actuatorPos, AxisFloats& outPt, AxisPosition& curPos, AxesParams& axesParams)
 {
     // Get current polar
@@ -94,6 +118,20 @@ void RobotSandTableRotary::actuatorToPt(AxisInt32s& actuatorPos, AxisFloats& out
     outPt.setVal(1, y);    
 }
 
+void RobotSandTableRotary::actuatorFloatsToPt(AxisFloats& actuatorPos, AxisFloats& outPt, AxisPosition& curPos, AxesParams& axesParams)
+{
+    AxisFloats curPolar;
+    actuatorFloatsToPolar(actuatorPos, curPolar, axesParams);
+    float maxLinear = -1;
+    axesParams.getMaxVal(1, maxLinear);
+    if(maxLinear == -1)
+        maxLinear = 100;
+    float rho = curPolar.getVal(1) * maxLinear;
+    float theta = curPolar.getVal(0);
+    outPt.setVal(0, rho * cos(AxisUtils::d2r(theta)));
+    outPt.setVal(1, rho * sin(AxisUtils::d2r(theta)));
+}
+
 void RobotSandTableRotary::correctStepOverflow(AxisPosition& curPos, AxesParams& axesParams)
 {
     int rotationStepsTheta = (int)(axesParams.getStepsPerRot(0));
@@ -175,10 +213,11 @@ void RobotSandTableRotary::relativePolarToSteps(AxisFloats& relativePolar, AxisP
     if(maxLinear == -1)
         maxLinear = 100;
 
-    // Convert relative polar to steps
+    // Convert relative polar to steps (unrounded - the planner rounds to whole steps and keeps
+    // the unrounded positions for its step rate checks)
 
     float fractionalRotation = float(relativePolar.getVal(0) / float(360));
-    int32_t stepsRelTheta = int32_t(roundf(float(fractionalRotation * float(axesParams.getStepsPerRot(0)))));
+    float stepsRelTheta = float(fractionalRotation * float(axesParams.getStepsPerRot(0)));
 
     //Rho axis is a special one! Step it to rotate the gear the same degree as the theta.
     //Theta is moving relativePolar.getVal(0) degrees, therefore rho would be moving 
@@ -191,7 +230,7 @@ void RobotSandTableRotary::relativePolarToSteps(AxisFloats& relativePolar, AxisP
     float rhoMM = relativePolar.getVal(1) * maxLinear;
     float rhoActiveSteps = rhoMM * axesParams.getStepsPerUnit(1);
 
-    int32_t stepsRelRho = int32_t(roundf(rhoCounteractSteps + rhoActiveSteps));
+    float stepsRelRho = rhoCounteractSteps + rhoActiveSteps;
 
     // Add to existing
     outActuator.setVal(0, curAxisPositions._stepsFromHome.getVal(0) + stepsRelTheta);
@@ -218,6 +257,18 @@ void RobotSandTableRotary::actuatorToPolar(AxisInt32s& actuatorCoords, AxisFloat
         polarCoords.setVal(1, currentRho);
     }
 
+// As actuatorToPolar but without rounding the linear steps
+void RobotSandTableRotary::actuatorFloatsToPolar(AxisFloats& actuatorCoords, AxisFloats& polarCoords, AxesParams& axesParams)
+{
+    polarCoords.setVal(0, AxisUtils::wrapDegrees(actuatorCoords.getVal(0) * 360 / axesParams.getStepsPerRot(0)));
+    float maxLinear = -1;
+    axesParams.getMaxVal(1, maxLinear);
+    if(maxLinear == -1)
+        maxLinear = 100;
+    float linearStepsFromHome = actuatorCoords.getVal(1) - actuatorCoords.getVal(0) * float(axesParams.getStepsPerRot(1)/axesParams.getStepsPerRot(0));
+    polarCoords.setVal(1, linearStepsFromHome / (maxLinear * axesParams.getStepsPerUnit(1)));
+}
+
 void RobotSandTableRotary::convertCoords(RobotCommandArgs& cmdArgs, AxesParams& axesParams)
 {
     // Coordinates can be converted here if required
@@ -238,7 +289,7 @@ void RobotSandTableRotary::setRobotAttributes(AxesParams& axesParams, String& ro
     // Set attributes
     constexpr int MAX_ATTR_STR_LEN = 400;
     char attrStr[MAX_ATTR_STR_LEN];
-    sprintf(attrStr, "{\"sizeX\":%0.2f,\"sizeY\":%0.2f,\"sizeZ\":%0.2f,\"originX\":%0.2f,\"originY\":%0.2f,\"originZ\":%0.2f}",
+    sprintf(attrStr, "{\"sizeX\":%0.2f,\"sizeY\":%0.2f,\"sizeZ\":%0.2f,\"originX\":%0.2f,\"originY\":%0.2f,\"originZ\":%0.2f,\"polarNative\":1}",
             maxLinear*2, maxLinear*2, 0.0,
             maxLinear, maxLinear, 0.0);
     robotAttributes = attrStr;
@@ -42,10 +42,18 @@ private:
     static bool ptToActuator(AxisFloats& targetPt, AxisFloats& outActuator, 
                 AxisPosition& curPos, AxesParams& axesParams, bool allowOutOfBounds);
 
+    // Convert a cartesian point reached by sweeping an angle around the origin to actuator coordinates
+    static bool ptToActuatorPolar(AxisFloats& targetPt, float sweepDegs, AxisFloats& outActuator, 
+                AxisPosition& curPos, AxesParams& axesParams, bool allowOutOfBounds);
+
     // Convert actuator values to cartesian point
     static void actuatorToPt(AxisInt32s& targetActuator, AxisFloats& outPt,
                 AxisPosition& curPos, AxesParams& axesParams);
 
+    // Convert unrounded actuator values (fractions of a step) to cartesian point
+    static void actuatorFloatsToPt(AxisFloats& targetActuator, AxisFloats& outPt,
+                AxisPosition& curPos, AxesParams& axesParams);
+
     // Correct overflow (necessary for continuous rotation robots)
     static void correctStepOverflow(AxisPosition& curPos, AxesParams& axesParams);
 
@@ -61,4 +69,5 @@ private:
     static void relativePolarToSteps(AxisFloats& relativePolar, AxisPosition& curAxisPositions, 
             AxisFloats& outActuator, AxesParams& axesParams);
     static void actuatorToPolar(AxisInt32s &actuatorCoords, AxisFloats &polarCoords, AxesParams &axesParams);
+    static void actuatorFloatsToPolar(AxisFloats &actuatorCoords, AxisFloats &polarCoords, AxesParams &axesParams);
 };
@@ -2,15 +2,25 @@
 // Rob Dobson 2016
 
 #include "Arduino.h"
+#include <ArduinoLog.h>
 #include "EvaluatorGCode.h"
 #include "RobotCommandArgs.h"
 #include "../../RobotMotion/RobotController.h"
 
 // #define DEBUG_GCODE_EVALUATOR 1
 
-#ifdef DEBUG_GCODE_EVALUATOR
 static const char *MODULE_PREFIX = "EvaluatorGCode: ";
-#endif
+
+// A value for an axis this build doesn't have is dropped - this is reported once rather than
+// on every command as patterns repeat it on each line
+static void warnIfAxisNotBuilt(char axisLetter)
+{
+    static bool warned = false;
+    if ((RobotConsts::MAX_AXES > 2) || warned)
+        return;
+    warned = true;
+    Log.warning("%s%c ignored, build has %d axes\n", MODULE_PREFIX, axisLetter, RobotConsts::MAX_AXES);
+}
 
 bool EvaluatorGCode::getCmdNumber(const char* pCmdStr, int& cmdNum)
 {
@@ -43,6 +53,7 @@ bool EvaluatorGCode::getGcodeCmdArgs(const char* pArgStr, RobotCommandArgs& cmdA
                 pStr = pEndStr;
                 break;
             case 'C':
+                warnIfAxisNotBuilt('C');
                 cmdArgs.setAxisSteps(2, int(strtod(++pStr, &pEndStr)), true);
                 pStr = pEndStr;
                 break;
@@ -55,6 +66,7 @@ bool EvaluatorGCode::getGcodeCmdArgs(const char* pArgStr, RobotCommandArgs& cmdA
                 pStr = pEndStr;
                 break;
             case 'Z':
+                warnIfAxisNotBuilt('Z');
                 cmdArgs.setAxisValMM(2, strtod(++pStr, &pEndStr), true);
                 pStr = pEndStr;
                 break;
@@ -66,6 +78,22 @@ bool EvaluatorGCode::getGcodeCmdArgs(const char* pArgStr, RobotCommandArgs& cmdA
                 cmdArgs.setFeedrate(strtod(++pStr, &pEndStr));
                 pStr = pEndStr;
                 break;
+            case 'W':
+                cmdArgs.setPolarSweep(strtod(++pStr, &pEndStr));
+                pStr = pEndStr;
+                break;
+            case 'I':
+                cmdArgs.setArcCentreOffset(0, strtod(++pStr, &pEndStr));
+                pStr = pEndStr;
+                break;
+            case 'J':
+                cmdArgs.setArcCentreOffset(1, strtod(++pStr, &pEndStr));
+                pStr = pEndStr;
+                break;
+            case 'P':
+                cmdArgs.setArcTurns(strtol(++pStr, &pEndStr, 10));
+                pStr = pEndStr;
+                break;
             case 'R':
                 cmdArgs.setMoveType(RobotMoveTypeArg_Relative);
                 pStr++;
@@ -118,14 +146,24 @@ bool EvaluatorGCode::interpG(String& cmdStr, RobotController* pRobotController,
             if (takeAction)
             {
                 cmdArgs.setMoveRapid(cmdNum == 0);
-                pRobotController->moveTo(cmdArgs);
+                return pRobotController->moveTo(cmdArgs);
+            }
+            return true;
+        case 2: // Arc clockwise
+        case 3: // Arc anticlockwise
+            // Centre is given by I and J (offsets from the start point) - if the end point
+            // is at a different radius from the centre the move is an Archimedean spiral
+            if (takeAction)
+            {
+                cmdArgs.setMoveClockwise(cmdNum == 2);
+                return pRobotController->moveTo(cmdArgs);
             }
             return true;
         case 6: // Direct stepper move
             if (takeAction)
             {
                 cmdArgs.setMoveRapid(true);
-                pRobotController->moveTo(cmdArgs);
+                return pRobotController->moveTo(cmdArgs);
             }
             return true;
         case 28: // Home axes
@@ -133,27 +171,27 @@ bool EvaluatorGCode::interpG(String& cmdStr, RobotController* pRobotController,
             {
                 if (!cmdArgs.anyValid())
                     cmdArgs.setAllAxesNeedHoming();
-                pRobotController->goHome(cmdArgs);
+                return pRobotController->goHome(cmdArgs);
             }
             return true;
         case 90: // Move absolute
             if (takeAction)
             {
                 cmdArgs.setMoveType(RobotMoveTypeArg_Absolute);
-                pRobotController->setMotionParams(cmdArgs);
+                return pRobotController->setMotionParams(cmdArgs);
             }
             return true;
         case 91: // Movements relative
             if (takeAction)
             {
                 cmdArgs.setMoveType(RobotMoveTypeArg_Relative);
-                pRobotController->setMotionParams(cmdArgs);
+                return pRobotController->setMotionParams(cmdArgs);
             }
             return true;
         case 92: // Set home
             if (takeAction)
             {
-                pRobotController->setHome(cmdArgs);
+                return pRobotController->setHome(cmdArgs);
             }
             return true;
     }
@@ -164,6 +202,26 @@ bool EvaluatorGCode::interpG(String& cmdStr, RobotController* pRobotController,
 // Interpret GCode M commands
 bool EvaluatorGCode::interpM(String& cmdStr, RobotController* pRobotController, bool takeAction)
 {
+    // Command number
+    int cmdNum = 0;
+    bool rslt = getCmdNumber(cmdStr.c_str(), cmdNum);
+    if (!rslt)
+        return false;
+
+    // Switch on number
+    switch(cmdNum)
+    {
+        case 220: // Feed override percentage
+        {
+            // S is parsed here as getGcodeCmdArgs() treats it as an end-stop flag
+            const char* pSArg = strpbrk(cmdStr.c_str(), "Ss");
+            if (!pSArg)
+                return false;
+            if (takeAction)
+                pRobotController->setFeedOverride(strtod(pSArg + 1, NULL));
+            return true;
+        }
+    }
     return false;
 }
 
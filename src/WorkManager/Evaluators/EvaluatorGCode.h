@@ -17,6 +17,7 @@ public:
     static bool interpG(String& cmdStr, RobotController* pRobotController, bool takeAction);
     // Interpret GCode M commands
     static bool interpM(String& cmdStr, RobotController* pRobotController, bool takeAction);
-    // Interpret GCode commands
+    // Interpret GCode commands - returns false if the command isn't valid or (when takeAction
+    // is set) the robot couldn't queue it
     static bool interpretGcode(WorkItem& workItem, RobotController* pRobotController, bool takeAction);
 };
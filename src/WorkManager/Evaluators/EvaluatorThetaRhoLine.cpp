@@ -28,6 +28,7 @@ EvaluatorThetaRhoLine::EvaluatorThetaRhoLine(WorkManager& workManager) :
     _centreOffsetX = 0;
     _centreOffsetY = 0;
     _isInterpolating = false;
+    _polarNative = false;
 }
 
 void EvaluatorThetaRhoLine::setConfig(const char *configStr, const char* robotAttributes)
@@ -45,6 +46,10 @@ void EvaluatorThetaRhoLine::setConfig(const char *configStr, const char* robotAt
     _thetaMirrored = RdJson::getLong("thrThetaMirrored", 1, configStr) != 0;
     _thetaOffsetAngle = RdJson::getLong("thrThetaOffsetAngle", 1, configStr);
 
+    // Robots which move natively in polar coordinates are sent whole lines
+    _polarNative = (RdJson::getLong("thrNative", 1, configStr) != 0) && 
+                (RdJson::getLong("polarNative", 0, robotAttributes) != 0);
+
     _bedRadiusMM = std::min(sizeX, sizeY) / 2;
     _centreOffsetX = sizeX / 2 - originX;
     _centreOffsetY = sizeY / 2 - originY;
@@ -123,6 +128,23 @@ bool EvaluatorThetaRhoLine::execWorkItem(WorkItem &workItem)
 
     // Must be a _THRLINEN_ then
     double deltaTheta = newTheta - _thetaStartOffset - _prevTheta;
+
+    // Robots which move natively in polar coordinates get the whole line as a single move
+    // Theta is measured clockwise from the Y axis so the sweep (anticlockwise from X) is negated
+    if (_polarNative)
+    {
+        char lineBuf[100];
+        double x,y;
+        calcXYPos(_prevTheta + deltaTheta, newRho, x, y);
+        sprintf(lineBuf, "G0 X%0.3f Y%0.3f W%0.3f", x, y, -AxisUtils::r2d(deltaTheta));
+        String retStr;
+        WorkItem workItem(lineBuf);
+        _workManager.addWorkItem(workItem, retStr);
+        _prevTheta = newTheta;
+        _prevRho = newRho;
+        _isInterpolating = false;
+        return true;
+    }
     double absDeltaTheta = abs(deltaTheta);
     double adaptedStepAngle = _stepAngle;
     if (_stepAdaptation)
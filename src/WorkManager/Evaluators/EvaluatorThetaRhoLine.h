@@ -44,6 +44,7 @@ private:
     double _centreOffsetY;
     double _thetaOffsetAngle;
     bool _thetaMirrored;
+    bool _polarNative;
 
     // Work manager
     WorkManager& _workManager;
@@ -150,6 +150,10 @@ void WorkManager::processSingle(const char *pCmdStr, String &retStr) {
         // Toggle pause state
         _robotController.pause(!_robotController.isPaused());
         retStr = okRslt;
+    } else if (strncasecmp(pCmdStr, "feed/", 5) == 0) {
+        // Feed override in percent - applies immediately (not queued)
+        _robotController.setFeedOverride(atof(pCmdStr + 5));
+        retStr = okRslt;
     } else if (strcasecmp(pCmdStr, "stop") == 0) {
         _robotController.stop();
         _workItemQueue.clear();
@@ -293,20 +297,27 @@ void WorkManager::service() {
         if (rslt) {
             // Check if this work item can be processed
             if (canBeProcessed(workItem)) {
-                rslt = _workItemQueue.get(workItem);
-                if (rslt) {
-                    // Check for extended commands
-                    rslt = execWorkItem(workItem);
-
-                    // Check for GCode
-                    if (!rslt) EvaluatorGCode::interpretGcode(workItem, &_robotController, true);
-                }
+                // Check for extended commands
+                rslt = execWorkItem(workItem);
+
+                // Check for GCode
+                if (!rslt) rslt = EvaluatorGCode::interpretGcode(workItem, &_robotController, true);
+
+                // A command the robot couldn't queue (its queue is now full) stays in the work
+                // queue to be retried - anything else (including invalid commands) is removed
+                if (rslt || _robotController.canAcceptCommand())
+                    _workItemQueue.get(workItem);
+                else
+                    Log.verbose("%srobot queue full, retrying %s\n", MODULE_PREFIX, workItem.getCString());
             }
         }
     }
 
     // Service evaluators
     evaluatorsService();
+
+    // Tell the robot if there is more work to come (for underrun telemetry)
+    _robotController.setWorkItemsQueued(!_workItemQueue.isEmpty() || evaluatorsBusy(true));
 }
 
 void WorkManager::reconfigure() {
@@ -433,3 +444,23 @@ String WorkManager::getDebugStr() {
     returnStr += _workItemQueue.size();
     return returnStr;
 }
+
+void WorkManager::stepRecorder(const char* cmdStr, int maxEvents, String& respStr) {
+    _robotController.stepRecorder(cmdStr, maxEvents, respStr);
+}
+
+void WorkManager::motionStats(const char* cmdStr, String& respStr) {
+    _robotController.motionStats(cmdStr, respStr);
+}
+
+void WorkManager::homingStatus(String& respStr) {
+    _robotController.homingStatus(respStr);
+}
+
+void WorkManager::isrStats(const char* cmdStr, String& respStr) {
+    _robotController.isrStats(cmdStr, respStr);
+}
+
+void WorkManager::plannerTrace(const char* cmdStr, int maxBlocks, String& respStr) {
+    _robotController.plannerTrace(cmdStr, maxBlocks, respStr);
+}
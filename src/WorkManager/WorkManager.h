@@ -90,6 +90,21 @@ class WorkManager {
     // Get debug string
     String getDebugStr();
 
+    // Step recorder
+    void stepRecorder(const char* cmdStr, int maxEvents, String& respStr);
+
+    // Motion statistics
+    void motionStats(const char* cmdStr, String& respStr);
+
+    // Homing status
+    void homingStatus(String& respStr);
+
+    // ISR timing statistics
+    void isrStats(const char* cmdStr, String& respStr);
+
+    // Planner trace
+    void plannerTrace(const char* cmdStr, int maxBlocks, String& respStr);
+
    private:
     // Execute an item of work
     bool execWorkItem(WorkItem& workItem);
@@ -266,6 +266,9 @@ void setup() {
     // Handle statup commands
     _workManager.handleStartupCommands();
 
+    // Kinematics and planning run in their own task (higher priority than the loop)
+    _robotController.startMotionTask();
+
     // Service LED strip.
     xTaskCreatePinnedToCore(ledTaskFunc, /* Function to implement the task */
                             "Task1",     /* Name of the task */